@@ -0,0 +1,708 @@
+//
+// RT64
+//
+
+// CPU microbenchmarks for the hot paths of the HLE pipeline. None of these require a render device, so they can run
+// headless on any machine. Inputs can be recorded with State::dumpRDRAM and loaded back with --rdram to replay a real
+// game's display lists and vertex data. If no recording is provided, deterministic synthetic data is used instead.
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstring>
+#include <functional>
+#include <random>
+#include <string>
+#include <vector>
+
+#include <json/json.hpp>
+
+#include "common/rt64_copy_hash.h"
+#include "gbi/rt64_gbi.h"
+#include "gbi/rt64_gbi_f3dex2.h"
+#include "hle/rt64_game_frame.h"
+#include "hle/rt64_interpreter.h"
+#include "hle/rt64_interpreter_thread.h"
+#include "hle/rt64_rdp.h"
+#include "hle/rt64_rdp_tmem.h"
+#include "hle/rt64_rigid_body.h"
+#include "hle/rt64_rsp.h"
+#include "hle/rt64_state.h"
+#include "hle/rt64_workload_queue.h"
+#include "render/rt64_buffer_uploader.h"
+#include "render/rt64_shader_common.h"
+
+namespace RT64 {
+    struct BenchResult {
+        std::string name;
+        uint64_t iterations = 0;
+        uint64_t opsPerIteration = 0;
+        uint64_t bytesPerIteration = 0;
+        double nsPerOp = 0.0;
+        double minNsPerIteration = 0.0;
+        double medianNsPerIteration = 0.0;
+        double bytesPerSecond = 0.0;
+    };
+
+    struct BenchOptions {
+        std::string rdramPath;
+        std::string outputPath;
+        std::string filter;
+        uint32_t dlAddress = 0;
+        uint32_t vertexAddress = 0;
+        uint64_t iterations = 200;
+    };
+
+    struct HostBuffer : RenderBuffer {
+        std::vector<uint8_t> data;
+
+        HostBuffer(size_t size) {
+            data.resize(size);
+        }
+
+        void *map(uint32_t subresource, const RenderRange *readRange) override {
+            return data.data();
+        }
+
+        void unmap(uint32_t subresource, const RenderRange *writtenRange) override { }
+
+        std::unique_ptr<RenderBufferFormattedView> createBufferFormattedView(RenderFormat format) override {
+            return nullptr;
+        }
+    };
+
+    static void benchCheckInterrupts() { }
+
+    static uint64_t benchCommandCount = 0;
+
+    static void benchCommand(State *state, DisplayList **dl) {
+        benchCommandCount++;
+    }
+
+    static void benchEndDisplayList(State *state, DisplayList **dl) {
+        *dl = nullptr;
+    }
+
+    struct Bench {
+        BenchOptions options;
+        std::vector<uint8_t> RDRAM;
+        uint32_t MI_INTR_REG = 0;
+        std::unique_ptr<State> state;
+        std::unique_ptr<WorkloadQueue> workloadQueue;
+        std::unique_ptr<Interpreter> interpreter;
+        GBI benchGBI;
+        std::vector<BenchResult> results;
+        std::mt19937 randomEngine;
+
+        Bench(const BenchOptions &options) {
+            this->options = options;
+            randomEngine.seed(0x52543634);
+        }
+
+        bool setup() {
+            RDRAM.resize(RDRAMSize + 1, 0);
+            if (!options.rdramPath.empty()) {
+                FILE *fp = fopen(options.rdramPath.c_str(), "rb");
+                if (fp == nullptr) {
+                    fprintf(stderr, "Unable to open RDRAM dump %s.\n", options.rdramPath.c_str());
+                    return false;
+                }
+
+                size_t readBytes = fread(RDRAM.data(), 1, RDRAM.size(), fp);
+                fclose(fp);
+
+                if (readBytes < RDRAMSize) {
+                    fprintf(stderr, "RDRAM dump %s is smaller than expected (%zu bytes).\n", options.rdramPath.c_str(), readBytes);
+                }
+            }
+            else {
+                fillRandom(RDRAM.data(), RDRAM.size());
+            }
+
+            state = std::make_unique<State>(RDRAM.data(), &MI_INTR_REG, benchCheckInterrupts);
+            workloadQueue = std::make_unique<WorkloadQueue>();
+            interpreter = std::make_unique<Interpreter>();
+            interpreter->setup(state.get());
+
+            // The interpreter only needs a GBI to dispatch to. The benchmark GBI does nothing besides counting commands.
+            benchGBI.ucode = GBIUCode::F3DEX2;
+            std::fill(std::begin(benchGBI.map), std::end(benchGBI.map), &benchCommand);
+            benchGBI.map[F3DEX2_G_ENDDL] = &benchEndDisplayList;
+            interpreter->hleGBI = &benchGBI;
+
+            State::External ext = {};
+            ext.interpreter = interpreter.get();
+            ext.workloadQueue = workloadQueue.get();
+            state->ext = ext;
+            state->rdramCheckPending = false;
+            return true;
+        }
+
+        void fillRandom(void *dst, size_t size) {
+            uint8_t *dstBytes = reinterpret_cast<uint8_t *>(dst);
+            for (size_t i = 0; i < size; i++) {
+                dstBytes[i] = uint8_t(randomEngine() & 0xFF);
+            }
+        }
+
+        bool enabled(const std::string &name) const {
+            return options.filter.empty() || (name.find(options.filter) != std::string::npos);
+        }
+
+        void run(const std::string &name, uint64_t opsPerIteration, uint64_t bytesPerIteration, const std::function<void()> &prepare, const std::function<void()> &body) {
+            typedef std::chrono::high_resolution_clock Clock;
+
+            // Warm up the caches and any lazily allocated storage before measuring.
+            const uint64_t warmupIterations = std::max(options.iterations / 10, uint64_t(1));
+            for (uint64_t i = 0; i < warmupIterations; i++) {
+                if (prepare) {
+                    prepare();
+                }
+
+                body();
+            }
+
+            std::vector<double> iterationNs;
+            iterationNs.reserve(options.iterations);
+            for (uint64_t i = 0; i < options.iterations; i++) {
+                if (prepare) {
+                    prepare();
+                }
+
+                const auto start = Clock::now();
+                body();
+                const auto end = Clock::now();
+                iterationNs.emplace_back(double(std::chrono::duration_cast<std::chrono::nanoseconds>(end - start).count()));
+            }
+
+            double totalNs = 0.0;
+            for (double ns : iterationNs) {
+                totalNs += ns;
+            }
+
+            std::sort(iterationNs.begin(), iterationNs.end());
+
+            BenchResult result;
+            result.name = name;
+            result.iterations = options.iterations;
+            result.opsPerIteration = opsPerIteration;
+            result.bytesPerIteration = bytesPerIteration;
+            result.nsPerOp = totalNs / double(options.iterations * opsPerIteration);
+            result.minNsPerIteration = iterationNs.front();
+            result.medianNsPerIteration = iterationNs[iterationNs.size() / 2];
+            result.bytesPerSecond = (totalNs > 0.0) ? (double(bytesPerIteration * options.iterations) * 1e9) / totalNs : 0.0;
+            results.emplace_back(result);
+
+            fprintf(stderr, "%-32s %12.2f ns/op %14.2f ns/iter (median) %10.2f MB/s\n", name.c_str(), result.nsPerOp, result.medianNsPerIteration, result.bytesPerSecond / (1024.0 * 1024.0));
+        }
+
+        // Use the recorded display list if available. Otherwise, write a synthetic one into RDRAM. Branches are not
+        // followed, as the benchmark GBI only measures the cost of dispatching each command.
+        bool setupDisplayList(const std::string &name, uint32_t &dlAddress, uint32_t &commandCount) {
+            const uint32_t MaxCommands = 0x10000;
+            dlAddress = options.dlAddress;
+            commandCount = 0;
+            if (!options.rdramPath.empty() && (dlAddress > 0)) {
+                const DisplayList *dl = reinterpret_cast<const DisplayList *>(state->fromRDRAM(dlAddress));
+                while ((commandCount < MaxCommands) && ((dl[commandCount].w0 >> 24) != F3DEX2_G_ENDDL)) {
+                    commandCount++;
+                }
+
+                if (commandCount == MaxCommands) {
+                    fprintf(stderr, "Display list at 0x%08X has no end command within %u commands. Skipping %s.\n", dlAddress, MaxCommands, name.c_str());
+                    return false;
+                }
+            }
+            else {
+                const uint32_t SyntheticCommands = 4096;
+                dlAddress = 0x100000;
+                DisplayList *dl = reinterpret_cast<DisplayList *>(state->fromRDRAM(dlAddress));
+                for (uint32_t i = 0; i < SyntheticCommands; i++) {
+                    uint8_t opCode = uint8_t(randomEngine() & 0xFF);
+                    if (opCode == F3DEX2_G_ENDDL) {
+                        opCode--;
+                    }
+
+                    dl[i].w0 = (uint32_t(opCode) << 24) | (randomEngine() & 0xFFFFFF);
+                    dl[i].w1 = randomEngine();
+                }
+
+                dl[SyntheticCommands].w0 = uint32_t(F3DEX2_G_ENDDL) << 24;
+                dl[SyntheticCommands].w1 = 0;
+                commandCount = SyntheticCommands;
+            }
+
+            return true;
+        }
+
+        void benchInterpreterDispatch() {
+            const std::string name = "interpreter_dispatch";
+            if (!enabled(name)) {
+                return;
+            }
+
+            uint32_t dlAddress, commandCount;
+            if (!setupDisplayList(name, dlAddress, commandCount)) {
+                return;
+            }
+
+            DisplayList *dlStart = reinterpret_cast<DisplayList *>(state->fromRDRAM(dlAddress));
+            run(name, commandCount + 1, (commandCount + 1) * sizeof(DisplayList), nullptr, [&]() {
+                interpreter->processDisplayLists(dlAddress, dlStart);
+            });
+        }
+
+        // Measures the time the emulator thread spends handing the same display list over to the interpreter thread. The difference
+        // against interpreter_dispatch is the most the emulator thread can gain per task, as it's the time it would otherwise spend
+        // processing the display list synchronously.
+        void benchInterpreterThreadSubmit() {
+            const std::string name = "interpreter_thread_submit";
+            if (!enabled(name)) {
+                return;
+            }
+
+            uint32_t dlAddress, commandCount;
+            if (!setupDisplayList(name, dlAddress, commandCount)) {
+                return;
+            }
+
+            // A typical frame only writes to a small portion of RDRAM, including the display list itself.
+            RDRAMPages dirtyPages;
+            dirtyPages.set(dlAddress, (commandCount + 1) * sizeof(DisplayList));
+            dirtyPages.set(0x200000, 0x40000);
+
+            InterpreterThread interpreterThread(interpreter.get(), state.get(), RDRAM.data());
+            run(name, commandCount + 1, uint64_t(dirtyPages.count()) * RDRAMPages::PageSize, [&]() {
+                interpreterThread.wait();
+            }, [&]() {
+                interpreterThread.markDirtyPages(dirtyPages);
+                interpreterThread.submit(dlAddress, 0, true, dirtyPages);
+            });
+
+            interpreterThread.wait();
+        }
+
+        void benchSetVertex() {
+            const std::string name = "rsp_set_vertex";
+            if (!enabled(name)) {
+                return;
+            }
+
+            const uint32_t VertexCount = 1024;
+            const uint32_t VerticesPerLoad = 32;
+            const uint32_t LoadsPerIteration = VertexCount / VerticesPerLoad;
+            uint32_t vertexAddress = options.vertexAddress;
+            if (options.rdramPath.empty() || (vertexAddress == 0)) {
+                vertexAddress = 0x200000;
+                RSP::Vertex *vertices = reinterpret_cast<RSP::Vertex *>(state->fromRDRAM(vertexAddress));
+                for (uint32_t i = 0; i < VertexCount; i++) {
+                    RSP::Vertex &v = vertices[i];
+                    v.x = int16_t((randomEngine() % 2048) - 1024);
+                    v.y = int16_t((randomEngine() % 2048) - 1024);
+                    v.z = int16_t((randomEngine() % 2048) - 1024);
+                    v.flag = 0;
+                    v.s = int16_t(randomEngine() & 0x7FFF);
+                    v.t = int16_t(randomEngine() & 0x7FFF);
+                    v.normal.x = int8_t(randomEngine() & 0xFF);
+                    v.normal.y = int8_t(randomEngine() & 0xFF);
+                    v.normal.z = int8_t(randomEngine() & 0xFF);
+                    v.normal.a = int8_t(0xFF);
+                }
+            }
+
+            // Perspective projection with a regular 320x240 viewport.
+            hlslpp::float4x4 projMatrix(0.0f);
+            projMatrix[0] = hlslpp::float4(1.5f, 0.0f, 0.0f, 0.0f);
+            projMatrix[1] = hlslpp::float4(0.0f, 2.0f, 0.0f, 0.0f);
+            projMatrix[2] = hlslpp::float4(0.0f, 0.0f, -1.01f, -1.0f);
+            projMatrix[3] = hlslpp::float4(0.0f, 0.0f, -20.0f, 0.0f);
+
+            RSP *rsp = state->rsp.get();
+            Workload &workload = workloadQueue->workloads[workloadQueue->writeCursor];
+            auto prepare = [&]() {
+                workload.begin(0);
+                rsp->reset();
+                rsp->modelMatrixStack[0] = hlslpp::float4x4::identity();
+                rsp->viewMatrixStack[0] = hlslpp::float4x4::identity();
+                rsp->projMatrixStack[0] = projMatrix;
+                rsp->viewProjMatrixStack[0] = projMatrix;
+                rsp->viewportStack[0].scale = { 160.0f, -120.0f, 511.0f };
+                rsp->viewportStack[0].translate = { 160.0f, 120.0f, 511.0f };
+                rsp->geometryModeStack[0] |= G_LIGHTING | G_SHADE;
+                rsp->textureState.on = 1;
+                rsp->textureState.sc = 0x8000;
+                rsp->textureState.tc = 0x8000;
+                rsp->lightCount = 1;
+                rsp->lightsChanged = true;
+                rsp->projectionMatrixChanged = true;
+                rsp->viewportChanged = true;
+                rsp->modelViewProjChanged = true;
+            };
+
+            run(name, VertexCount, VertexCount * sizeof(RSP::Vertex), prepare, [&]() {
+                for (uint32_t i = 0; i < LoadsPerIteration; i++) {
+                    // Simulate a new model matrix every few loads.
+                    if ((i % 4) == 0) {
+                        rsp->modelViewProjChanged = true;
+                    }
+
+                    rsp->setVertex(vertexAddress + i * VerticesPerLoad * sizeof(RSP::Vertex), VerticesPerLoad, 0);
+                }
+            });
+        }
+
+        void benchTextureHash() {
+            const std::string name = "tmem_hash_texture";
+            if (!enabled(name)) {
+                return;
+            }
+
+            // Every texture is already known by the manager, so the texture cache is never reached.
+            const uint32_t TextureCount = 64;
+            const uint16_t Width = 32;
+            const uint16_t Height = 32;
+            fillRandom(state->rdp->TMEM, sizeof(state->rdp->TMEM));
+
+            TextureManager textureManager;
+            std::vector<LoadTile> loadTiles(TextureCount);
+            const uint8_t *TMEM = reinterpret_cast<const uint8_t *>(state->rdp->TMEM);
+            for (uint32_t i = 0; i < TextureCount; i++) {
+                LoadTile &loadTile = loadTiles[i];
+                loadTile = {};
+                loadTile.fmt = G_IM_FMT_RGBA;
+                loadTile.siz = G_IM_SIZ_16b;
+                loadTile.line = (Width * 2) / 8;
+                loadTile.tmem = uint16_t((i * 8) % (RDP_TMEM_BYTES / 8));
+                textureManager.hashSet.insert(TextureManager::hashTexture(TMEM, loadTile, Width, Height, 0));
+            }
+
+            const uint64_t bytesPerTexture = Width * Height * 2;
+            run(name, TextureCount, TextureCount * bytesPerTexture, nullptr, [&]() {
+                for (const LoadTile &loadTile : loadTiles) {
+                    textureManager.uploadTexture(state.get(), loadTile, nullptr, 0, Width, Height, 0);
+                }
+            });
+        }
+
+        void benchFramebufferCheckRAM() {
+            const std::string name = "framebuffer_check_ram";
+            if (!enabled(name)) {
+                return;
+            }
+
+            // Typical setup of a game with double buffered 16-bit color at 320x240 and a depth buffer.
+            struct FramebufferDesc {
+                uint32_t address;
+                uint8_t siz;
+                uint32_t width;
+                uint32_t height;
+            };
+
+            const FramebufferDesc fbDescs[] = {
+                { 0x300000, G_IM_SIZ_16b, 320, 240 },
+                { 0x325800, G_IM_SIZ_16b, 320, 240 },
+                { 0x34B000, G_IM_SIZ_16b, 320, 240 },
+                { 0x400000, G_IM_SIZ_32b, 640, 480 }
+            };
+
+            FramebufferManager framebufferManager;
+            uint64_t totalBytes = 0;
+            for (const FramebufferDesc &desc : fbDescs) {
+                Framebuffer &fb = framebufferManager.get(desc.address, desc.siz, desc.width, desc.height);
+                fb.RAMBytes = fb.imageRowBytes(desc.width) * desc.height;
+                totalBytes += fb.RAMBytes;
+            }
+
+            std::vector<Framebuffer *> differentFbs;
+            run(name, std::size(fbDescs), totalBytes, nullptr, [&]() {
+                framebufferManager.checkRAM(RDRAM.data(), differentFbs, false);
+            });
+        }
+
+        void benchScreenCopyHash() {
+            // Full screen 640x480 framebuffers as stored for the VI by State::updateScreen.
+            const uint32_t ScreenWidth = 640;
+            const uint32_t ScreenHeight = 480;
+            const uint8_t screenSizs[] = { G_IM_SIZ_16b, G_IM_SIZ_32b };
+            for (uint8_t siz : screenSizs) {
+                const uint32_t screenBytes = (ScreenWidth * ScreenHeight) << (siz - 1);
+                const std::string sizName = (siz == G_IM_SIZ_16b) ? "16b" : "32b";
+                std::vector<uint8_t> screenStorage(screenBytes);
+                volatile uint64_t sink = 0;
+
+                const std::string separateName = "screen_copy_then_hash_" + sizName;
+                if (enabled(separateName)) {
+                    run(separateName, 1, screenBytes, nullptr, [&]() {
+                        memcpy(screenStorage.data(), RDRAM.data(), screenBytes);
+                        sink = sink ^ XXH3_64bits(screenStorage.data(), screenBytes);
+                    });
+                }
+
+                const std::string fusedName = "screen_copy_hash_" + sizName;
+                if (enabled(fusedName)) {
+                    run(fusedName, 1, screenBytes, nullptr, [&]() {
+                        sink = sink ^ CopyAndHash(screenStorage.data(), RDRAM.data(), screenBytes);
+                    });
+                }
+            }
+        }
+
+        void benchGameFrameMatch() {
+            const std::string name = "game_frame_match";
+            if (!enabled(name)) {
+                return;
+            }
+
+            // Two consecutive frames with the same calls and slightly moved transforms.
+            const uint32_t TransformCount = 256;
+            const uint32_t PrevWorkloadIndex = 0;
+            const uint32_t CurWorkloadIndex = 1;
+            std::vector<hlslpp::float3> basePositions(TransformCount);
+            for (uint32_t t = 0; t < TransformCount; t++) {
+                basePositions[t] = hlslpp::float3(float(randomEngine() % 1000), float(randomEngine() % 1000), float(randomEngine() % 1000));
+            }
+
+            auto fillWorkload = [&](Workload &workload, uint64_t frame) {
+                workload.begin(frame);
+                workload.addFramebufferPair(0x300000, G_IM_FMT_RGBA, G_IM_SIZ_16b, 320, 0x34B000);
+
+                DrawData &drawData = workload.drawData;
+                drawData.transformGroups.emplace_back(TransformGroup());
+                drawData.viewTransforms.emplace_back(hlslpp::float4x4::identity());
+                drawData.projTransforms.emplace_back(hlslpp::float4x4::identity());
+                drawData.viewProjTransforms.emplace_back(hlslpp::float4x4::identity());
+                drawData.viewProjTransformGroups.emplace_back(0);
+
+                FramebufferPair &fbPair = workload.fbPairs[workload.currentFramebufferPairIndex()];
+                fbPair.changeProjection(0, Projection::Type::Perspective);
+                for (uint32_t t = 0; t < TransformCount; t++) {
+                    hlslpp::float4x4 transform = hlslpp::float4x4::identity();
+                    transform[3] = hlslpp::float4(basePositions[t] + hlslpp::float3(float(frame) * 0.5f, 0.0f, 0.0f), 1.0f);
+                    drawData.worldTransforms.emplace_back(transform);
+                    drawData.worldTransformGroups.emplace_back(0);
+                    drawData.worldTransformVertexIndices.emplace_back(0);
+
+                    interop::RDPTile rdpTile = {};
+                    rdpTile.fmt = G_IM_FMT_RGBA;
+                    rdpTile.siz = G_IM_SIZ_16b;
+                    rdpTile.masks = 5;
+                    rdpTile.maskt = 5;
+                    rdpTile.uls = float(frame);
+                    rdpTile.lrs = float(frame) + 31.0f;
+                    rdpTile.lrt = 31.0f;
+                    drawData.rdpTiles.emplace_back(rdpTile);
+
+                    DrawCallTile callTile = {};
+                    callTile.tmemHashOrID = t;
+                    drawData.callTiles.emplace_back(callTile);
+
+                    GameCall gameCall = {};
+                    gameCall.callDesc.minWorldMatrix = uint16_t(t);
+                    gameCall.callDesc.maxWorldMatrix = uint16_t(t);
+                    gameCall.callDesc.triangleCount = (t % 8) + 1;
+                    gameCall.callDesc.tileIndex = t;
+                    gameCall.callDesc.tileCount = 1;
+                    fbPair.addGameCall(gameCall);
+                }
+            };
+
+            fillWorkload(workloadQueue->workloads[PrevWorkloadIndex], 0);
+            fillWorkload(workloadQueue->workloads[CurWorkloadIndex], 1);
+
+            GameFrame prevFrame;
+            GameFrame curFrame;
+            prevFrame.set(*workloadQueue, &PrevWorkloadIndex, 1);
+
+            // Velocity buffers are only uploaded when vertex interpolation is enabled, which the default transform groups skip.
+            bool velocityUploaderUsed = false;
+            bool tileInterpolationUsed = false;
+            auto prepare = [&]() {
+                curFrame.set(*workloadQueue, &CurWorkloadIndex, 1);
+            };
+
+            run(name, TransformCount, 0, prepare, [&]() {
+                curFrame.match(nullptr, *workloadQueue, prevFrame, nullptr, velocityUploaderUsed, tileInterpolationUsed);
+            });
+
+            workloadQueue->reset();
+        }
+
+        void benchRigidBodyLerp() {
+            const std::string name = "rigid_body_lerp";
+            if (!enabled(name)) {
+                return;
+            }
+
+            const uint32_t LerpCount = 1024;
+            auto makeTransform = [](float angle, hlslpp::float3 position) {
+                hlslpp::float4x4 transform = hlslpp::float4x4::identity();
+                transform[0] = hlslpp::float4(cosf(angle), 0.0f, -sinf(angle), 0.0f);
+                transform[2] = hlslpp::float4(sinf(angle), 0.0f, cosf(angle), 0.0f);
+                transform[3] = hlslpp::float4(position, 1.0f);
+                return transform;
+            };
+
+            const hlslpp::float4x4 prevTransform = makeTransform(0.25f, hlslpp::float3(10.0f, 0.0f, 5.0f));
+            const hlslpp::float4x4 curTransform = makeTransform(0.35f, hlslpp::float3(11.0f, 0.5f, 5.0f));
+            RigidBody rigidBody;
+            rigidBody.updateDecomposition(prevTransform, true);
+            rigidBody.updateLinear(prevTransform, curTransform, G_EX_COMPONENT_AUTO);
+            rigidBody.updateAngular(prevTransform, curTransform, G_EX_COMPONENT_AUTO, G_EX_COMPONENT_AUTO, G_EX_COMPONENT_AUTO);
+            rigidBody.updatePerspective(prevTransform, curTransform, G_EX_COMPONENT_AUTO);
+            rigidBody.updateDecomposition(curTransform, true);
+
+            volatile float sink = 0.0f;
+            run(name, LerpCount, 0, nullptr, [&]() {
+                float sum = 0.0f;
+                for (uint32_t i = 0; i < LerpCount; i++) {
+                    const hlslpp::float4x4 result = rigidBody.lerp(float(i) / float(LerpCount), prevTransform, curTransform, true);
+                    sum += float(result[3].x);
+                }
+
+                sink = sink + sum;
+            });
+        }
+
+        void benchBufferUploaderCopy() {
+            const std::string name = "buffer_uploader_copy";
+            if (!enabled(name)) {
+                return;
+            }
+
+            // Roughly the size of the position data uploaded by a busy frame.
+            const size_t ElementCount = 1024 * 1024;
+            std::vector<int16_t> srcData(ElementCount * 3);
+            fillRandom(srcData.data(), srcData.size() * sizeof(int16_t));
+
+            BufferPair bufferPair;
+            bufferPair.uploadBuffer = std::make_unique<HostBuffer>(srcData.size() * sizeof(int16_t));
+            bufferPair.allocatedSize = srcData.size() * sizeof(int16_t);
+
+            const BufferUploader::Upload upload = { srcData.data(), { 0, srcData.size() }, sizeof(int16_t), RenderBufferFlag::FORMATTED, { RenderFormat::R16_SINT }, &bufferPair };
+            run(name, 1, srcData.size() * sizeof(int16_t), nullptr, [&]() {
+                BufferUploader::threadUpload(upload);
+            });
+        }
+
+        void benchShaderDescriptionHash() {
+            const std::string name = "shader_description_hash";
+            if (!enabled(name)) {
+                return;
+            }
+
+            const uint32_t DescriptionCount = 4096;
+            std::vector<ShaderDescription> descriptions(DescriptionCount);
+            fillRandom(descriptions.data(), descriptions.size() * sizeof(ShaderDescription));
+
+            volatile uint64_t sink = 0;
+            run(name, DescriptionCount, DescriptionCount * sizeof(ShaderDescription), nullptr, [&]() {
+                uint64_t hashSum = 0;
+                for (const ShaderDescription &desc : descriptions) {
+                    hashSum ^= desc.hash();
+                }
+
+                sink = sink ^ hashSum;
+            });
+        }
+
+        void runAll() {
+            benchInterpreterDispatch();
+            benchInterpreterThreadSubmit();
+            benchSetVertex();
+            benchTextureHash();
+            benchFramebufferCheckRAM();
+            benchScreenCopyHash();
+            benchGameFrameMatch();
+            benchRigidBodyLerp();
+            benchBufferUploaderCopy();
+            benchShaderDescriptionHash();
+        }
+
+        bool writeResults() const {
+            nlohmann::json jroot;
+            jroot["rdram"] = options.rdramPath.empty() ? "synthetic" : options.rdramPath;
+            jroot["iterations"] = options.iterations;
+
+            nlohmann::json &jbenchmarks = jroot["benchmarks"];
+            jbenchmarks = nlohmann::json::array();
+            for (const BenchResult &result : results) {
+                nlohmann::json jresult;
+                jresult["name"] = result.name;
+                jresult["iterations"] = result.iterations;
+                jresult["opsPerIteration"] = result.opsPerIteration;
+                jresult["bytesPerIteration"] = result.bytesPerIteration;
+                jresult["nsPerOp"] = result.nsPerOp;
+                jresult["minNsPerIteration"] = result.minNsPerIteration;
+                jresult["medianNsPerIteration"] = result.medianNsPerIteration;
+                jresult["bytesPerSecond"] = result.bytesPerSecond;
+                jbenchmarks.push_back(jresult);
+            }
+
+            const std::string jsonText = jroot.dump(4);
+            if (options.outputPath.empty()) {
+                fprintf(stdout, "%s\n", jsonText.c_str());
+                return true;
+            }
+
+            FILE *fp = fopen(options.outputPath.c_str(), "w");
+            if (fp == nullptr) {
+                fprintf(stderr, "Unable to write results to %s.\n", options.outputPath.c_str());
+                return false;
+            }
+
+            fwrite(jsonText.data(), 1, jsonText.size(), fp);
+            fclose(fp);
+            return true;
+        }
+    };
+};
+
+static void printUsage(const char *program) {
+    fprintf(stderr,
+        "Usage: %s [options]\n"
+        "  --rdram <path>       RDRAM dump recorded with State::dumpRDRAM.\n"
+        "  --dl <address>       Address of a display list inside the RDRAM dump.\n"
+        "  --vtx <address>      Address of vertex data inside the RDRAM dump.\n"
+        "  --iterations <n>     Measured iterations per benchmark.\n"
+        "  --filter <name>      Only run benchmarks containing this name.\n"
+        "  --output <path>      Write the JSON results to a file instead of stdout.\n", program);
+}
+
+int main(int argc, char **argv) {
+    RT64::BenchOptions options;
+    for (int i = 1; i < argc; i++) {
+        const std::string arg = argv[i];
+        const bool hasValue = (i + 1) < argc;
+        if ((arg == "--rdram") && hasValue) {
+            options.rdramPath = argv[++i];
+        }
+        else if ((arg == "--dl") && hasValue) {
+            options.dlAddress = uint32_t(strtoul(argv[++i], nullptr, 0)) & 0x00FFFFFF;
+        }
+        else if ((arg == "--vtx") && hasValue) {
+            options.vertexAddress = uint32_t(strtoul(argv[++i], nullptr, 0)) & 0x00FFFFFF;
+        }
+        else if ((arg == "--iterations") && hasValue) {
+            options.iterations = std::max(strtoull(argv[++i], nullptr, 0), 1ULL);
+        }
+        else if ((arg == "--filter") && hasValue) {
+            options.filter = argv[++i];
+        }
+        else if ((arg == "--output") && hasValue) {
+            options.outputPath = argv[++i];
+        }
+        else {
+            printUsage(argv[0]);
+            return 1;
+        }
+    }
+
+    RT64::Bench bench(options);
+    if (!bench.setup()) {
+        return 1;
+    }
+
+    bench.runAll();
+    return bench.writeResults() ? 0 : 1;
+}
@@ -0,0 +1,36 @@
+//
+// RT64
+//
+
+#include "rt64_copy_hash.h"
+
+#include <algorithm>
+#include <cstring>
+
+#include "xxHash/xxh3.h"
+
+namespace RT64 {
+    uint64_t CopyAndHash(void *dst, const void *src, size_t size) {
+        // Small enough to still be in the L1 cache when it's hashed after being copied on most CPUs.
+        const size_t ChunkSize = 16 * 1024;
+        if (size <= ChunkSize) {
+            memcpy(dst, src, size);
+            return XXH3_64bits(dst, size);
+        }
+
+        XXH3_state_t hashState;
+        XXH3_64bits_reset(&hashState);
+
+        uint8_t *dstBytes = reinterpret_cast<uint8_t *>(dst);
+        const uint8_t *srcBytes = reinterpret_cast<const uint8_t *>(src);
+        size_t offset = 0;
+        while (offset < size) {
+            const size_t chunkBytes = std::min(ChunkSize, size - offset);
+            memcpy(dstBytes + offset, srcBytes + offset, chunkBytes);
+            XXH3_64bits_update(&hashState, dstBytes + offset, chunkBytes);
+            offset += chunkBytes;
+        }
+
+        return XXH3_64bits_digest(&hashState);
+    }
+};
@@ -0,0 +1,14 @@
+//
+// RT64
+//
+
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+
+namespace RT64 {
+    // Copies the memory in chunks small enough to stay in the cache and hashes each chunk right after it's copied, so the
+    // source only needs to be read from memory once. The result is identical to hashing the source with XXH3_64bits.
+    uint64_t CopyAndHash(void *dst, const void *src, size_t size);
+};
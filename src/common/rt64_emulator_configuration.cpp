@@ -11,5 +11,6 @@ namespace RT64 {
         dither.postBlendNoise = true;
         framebuffer.renderToRAM = true;
         framebuffer.copyWithGPU = true;
+        framebuffer.readback = Framebuffer::Readback::Immediate;
     }
 };
\ No newline at end of file
@@ -13,8 +13,20 @@ namespace RT64 {
         };
 
         struct Framebuffer {
+            // Controls when the results of rendering to RAM are written back to RDRAM.
+            // - Immediate: The emulator waits for the GPU at the end of every display list.
+            // - Deferred: The emulator resumes right away and the results are written the next time it calls into the renderer.
+            // - OnDemand: The results are only written when the renderer needs them or the emulator notifies it's reading the memory.
+            enum class Readback {
+                Immediate,
+                Deferred,
+                OnDemand,
+                OptionCount
+            };
+
             bool renderToRAM;
             bool copyWithGPU;
+            Readback readback;
         };
 
         Dither dither;
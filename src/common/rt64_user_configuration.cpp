@@ -30,6 +30,8 @@ namespace RT64 {
         j["refreshRateTarget"] = cfg.refreshRateTarget;
         j["internalColorFormat"] = cfg.internalColorFormat;
         j["idleWorkActive"] = cfg.idleWorkActive;
+        j["threadedDisplayLists"] = cfg.threadedDisplayLists;
+        j["rdramSoftDirtyTracking"] = cfg.rdramSoftDirtyTracking;
         j["developerMode"] = cfg.developerMode;
     }
 
@@ -51,6 +53,8 @@ namespace RT64 {
         cfg.refreshRateTarget = j.value("refreshRateTarget", defaultCfg.refreshRateTarget);
         cfg.internalColorFormat = j.value("internalColorFormat", defaultCfg.internalColorFormat);
         cfg.idleWorkActive = j.value("idleWorkActive", defaultCfg.idleWorkActive);
+        cfg.threadedDisplayLists = j.value("threadedDisplayLists", defaultCfg.threadedDisplayLists);
+        cfg.rdramSoftDirtyTracking = j.value("rdramSoftDirtyTracking", defaultCfg.rdramSoftDirtyTracking);
         cfg.developerMode = j.value("developerMode", defaultCfg.developerMode);
     }
 
@@ -80,6 +84,8 @@ namespace RT64 {
         refreshRateTarget = 60;
         internalColorFormat = InternalColorFormat::Automatic;
         idleWorkActive = true;
+        threadedDisplayLists = false;
+        rdramSoftDirtyTracking = false;
         developerMode = false;
     }
 
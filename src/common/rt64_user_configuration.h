@@ -86,6 +86,8 @@ namespace RT64 {
         int refreshRateTarget;
         InternalColorFormat internalColorFormat;
         bool idleWorkActive;
+        bool threadedDisplayLists;
+        bool rdramSoftDirtyTracking;
         bool developerMode;
 
         UserConfiguration();
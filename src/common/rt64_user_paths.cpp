@@ -18,6 +18,7 @@ namespace RT64 {
     const std::filesystem::path ConfigurationFile = "rt64.json";
     const std::filesystem::path ImGuiFile = "rt64-imgui.ini";
     const std::filesystem::path LogFile = "rt64.log";
+    const std::filesystem::path PipelineCacheFile = "rt64-pipelines.bin";
 
     std::filesystem::path UserPaths::detectDataPath(const std::filesystem::path &appId) {
         std::filesystem::path resultPath;
@@ -61,6 +62,7 @@ namespace RT64 {
             configurationPath = dataPath / ConfigurationFile;
             imguiPath = dataPath / ImGuiFile;
             logPath = dataPath / LogFile;
+            pipelineCachePath = dataPath / PipelineCacheFile;
         }
     }
 
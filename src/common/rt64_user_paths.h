@@ -14,6 +14,7 @@ namespace RT64 {
         std::filesystem::path configurationPath;
         std::filesystem::path imguiPath;
         std::filesystem::path logPath;
+        std::filesystem::path pipelineCachePath;
 
         std::filesystem::path detectDataPath(const std::filesystem::path &appId);
         void setupPaths(const std::filesystem::path &dataPath);
@@ -465,6 +465,11 @@ namespace RT64 {
             }
         }
 
+        // Argument buffers are only ever read by indirect draws.
+        if ((accessBits == RenderBufferAccess::READ) && (bufferFlags & RenderBufferFlag::INDIRECT)) {
+            return D3D12_RESOURCE_STATE_INDIRECT_ARGUMENT;
+        }
+
         // Use unordered access state if the buffer supports it and writing is enabled.
         if ((accessBits & RenderBufferAccess::WRITE) && (bufferFlags & RenderBufferFlag::UNORDERED_ACCESS)) {
             return D3D12_RESOURCE_STATE_UNORDERED_ACCESS;
@@ -708,6 +713,7 @@ namespace RT64 {
         assert(device != nullptr);
 
         this->device = device;
+        this->device->liveDescriptorSetCount++;
 
         entryCount = 0;
 
@@ -751,6 +757,7 @@ namespace RT64 {
         assert(entryCount > 0);
 
         this->device = device;
+        this->device->liveDescriptorSetCount++;
         this->entryCount = entryCount;
 
         allocatorOffset = device->descriptorHeapAllocator->allocate(entryCount);
@@ -762,6 +769,7 @@ namespace RT64 {
 
     D3D12DescriptorSet::~D3D12DescriptorSet() {
         device->descriptorHeapAllocator->free(allocatorOffset, entryCount);
+        device->liveDescriptorSetCount--;
     }
 
     void D3D12DescriptorSet::setBuffer(uint32_t descriptorIndex, const RenderBuffer *buffer, uint64_t bufferSize, const RenderBufferStructuredView *bufferStructuredView, const RenderBufferFormattedView *bufferFormattedView) {
@@ -1071,6 +1079,21 @@ namespace RT64 {
         nativeFormat = toDXGI(format);
 
         getWindowSize(width, height);
+
+        // Tearing must be allowed when the swap chain is created for the immediate present mode to be available.
+        IDXGIFactory4 *dxgiFactory = commandQueue->device->renderInterface->dxgiFactory;
+        IDXGIFactory5 *dxgiFactory5 = nullptr;
+        if (SUCCEEDED(dxgiFactory->QueryInterface(IID_PPV_ARGS(&dxgiFactory5)))) {
+            BOOL allowTearing = FALSE;
+            HRESULT res = dxgiFactory5->CheckFeatureSupport(DXGI_FEATURE_PRESENT_ALLOW_TEARING, &allowTearing, sizeof(allowTearing));
+            tearingSupported = SUCCEEDED(res) && allowTearing;
+            dxgiFactory5->Release();
+        }
+
+        swapChainFlags = DXGI_SWAP_CHAIN_FLAG_FRAME_LATENCY_WAITABLE_OBJECT;
+        if (tearingSupported) {
+            swapChainFlags |= DXGI_SWAP_CHAIN_FLAG_ALLOW_TEARING;
+        }
         
         DXGI_SWAP_CHAIN_DESC1 swapChainDesc = {};
         swapChainDesc.BufferCount = textureCount;
@@ -1080,10 +1103,9 @@ namespace RT64 {
         swapChainDesc.BufferUsage = DXGI_USAGE_RENDER_TARGET_OUTPUT;
         swapChainDesc.SwapEffect = DXGI_SWAP_EFFECT_FLIP_DISCARD;
         swapChainDesc.SampleDesc.Count = 1;
-        swapChainDesc.Flags = DXGI_SWAP_CHAIN_FLAG_FRAME_LATENCY_WAITABLE_OBJECT;
+        swapChainDesc.Flags = swapChainFlags;
 
         IDXGISwapChain1 *swapChain1;
-        IDXGIFactory4 *dxgiFactory = commandQueue->device->renderInterface->dxgiFactory;
         HRESULT res = dxgiFactory->CreateSwapChainForHwnd(commandQueue->d3d, renderWindow, &swapChainDesc, nullptr, nullptr, &swapChain1);
         if (FAILED(res)) {
             fprintf(stderr, "CreateSwapChainForHwnd failed with error code 0x%X.\n", res);
@@ -1134,7 +1156,21 @@ namespace RT64 {
             while (WaitForSingleObjectEx(waitableObject, 0, FALSE));
         }
 
-        HRESULT res = d3d->Present(1, 0);
+        // Mailbox is approximated by presenting without a sync interval, which lets the compositor discard frames that were replaced before being shown.
+        HRESULT res;
+        switch (presentMode) {
+        case RenderPresentMode::IMMEDIATE:
+            res = d3d->Present(0, DXGI_PRESENT_ALLOW_TEARING);
+            break;
+        case RenderPresentMode::MAILBOX:
+            res = d3d->Present(0, 0);
+            break;
+        case RenderPresentMode::FIFO:
+        default:
+            res = d3d->Present(1, 0);
+            break;
+        }
+
         return SUCCEEDED(res);
     }
 
@@ -1152,7 +1188,7 @@ namespace RT64 {
             textures[i].d3d = nullptr;
         }
 
-        HRESULT res = d3d->ResizeBuffers(0, 0, 0, DXGI_FORMAT_UNKNOWN, DXGI_SWAP_CHAIN_FLAG_FRAME_LATENCY_WAITABLE_OBJECT);
+        HRESULT res = d3d->ResizeBuffers(0, 0, 0, DXGI_FORMAT_UNKNOWN, swapChainFlags);
         if (FAILED(res)) {
             fprintf(stderr, "ResizeBuffers failed with error code 0x%X.\n", res);
             return false;
@@ -1218,6 +1254,33 @@ namespace RT64 {
         return (d3d == nullptr) || (width == 0) || (height == 0);
     }
 
+    bool D3D12SwapChain::isPresentModeSupported(RenderPresentMode presentMode) const {
+        switch (presentMode) {
+        case RenderPresentMode::FIFO:
+        case RenderPresentMode::MAILBOX:
+            return true;
+        case RenderPresentMode::IMMEDIATE:
+            return tearingSupported;
+        case RenderPresentMode::FIFO_RELAXED:
+        default:
+            return false;
+        }
+    }
+
+    bool D3D12SwapChain::setPresentMode(RenderPresentMode presentMode) {
+        if (!isPresentModeSupported(presentMode)) {
+            return false;
+        }
+
+        // The sync interval and flags are picked on every present, so the swap chain doesn't need to be recreated.
+        this->presentMode = presentMode;
+        return true;
+    }
+
+    RenderPresentMode D3D12SwapChain::getPresentMode() const {
+        return presentMode;
+    }
+
     uint32_t D3D12SwapChain::getRefreshRate() const {
         return 0;
     }
@@ -1463,6 +1526,24 @@ namespace RT64 {
         d3d->DrawIndexedInstanced(indexCountPerInstance, instanceCount, startIndexLocation, baseVertexLocation, startInstanceLocation);
     }
 
+    void D3D12CommandList::drawInstancedIndirect(RenderBufferReference argumentBuffer, uint32_t drawCount) {
+        assert(argumentBuffer.ref != nullptr);
+
+        const D3D12Buffer *interfaceBuffer = static_cast<const D3D12Buffer *>(argumentBuffer.ref);
+        checkTopology();
+        checkFramebufferSamplePositions();
+        d3d->ExecuteIndirect(device->drawCommandSignature, drawCount, interfaceBuffer->d3d, argumentBuffer.offset, nullptr, 0);
+    }
+
+    void D3D12CommandList::drawIndexedInstancedIndirect(RenderBufferReference argumentBuffer, uint32_t drawCount) {
+        assert(argumentBuffer.ref != nullptr);
+
+        const D3D12Buffer *interfaceBuffer = static_cast<const D3D12Buffer *>(argumentBuffer.ref);
+        checkTopology();
+        checkFramebufferSamplePositions();
+        d3d->ExecuteIndirect(device->drawIndexedCommandSignature, drawCount, interfaceBuffer->d3d, argumentBuffer.offset, nullptr, 0);
+    }
+
     void D3D12CommandList::setPipeline(const RenderPipeline *pipeline) {
         assert(pipeline != nullptr);
 
@@ -1963,9 +2044,19 @@ namespace RT64 {
             fprintf(stderr, "CreateCommandQueue failed with error code 0x%X.\n", res);
             return;
         }
+
+        res = device->d3d->CreateFence(0, D3D12_FENCE_FLAG_NONE, IID_PPV_ARGS(&timelineFence));
+        if (FAILED(res)) {
+            fprintf(stderr, "CreateFence failed with error code 0x%X.\n", res);
+            return;
+        }
     }
 
     D3D12CommandQueue::~D3D12CommandQueue() {
+        if (timelineFence != nullptr) {
+            timelineFence->Release();
+        }
+
         if (d3d != nullptr) {
             d3d->Release();
         }
@@ -1986,6 +2077,8 @@ namespace RT64 {
         if (!executionVector.empty()) {
             d3d->ExecuteCommandLists(UINT(executionVector.size()), executionVector.data());
         }
+
+        d3d->Signal(timelineFence, ++timelineValue);
         
         if (signalFence != nullptr) {
             D3D12CommandFence *interfaceFence = static_cast<D3D12CommandFence *>(signalFence);
@@ -2002,6 +2095,19 @@ namespace RT64 {
         WaitForSingleObjectEx(interfaceFence->fenceEvent, INFINITE, FALSE);
     }
 
+    uint64_t D3D12CommandQueue::getTimelineValue() {
+        return timelineValue;
+    }
+
+    void D3D12CommandQueue::waitForCommandQueue(RenderCommandQueue *queue, uint64_t value) {
+        assert(queue != nullptr);
+
+        D3D12CommandQueue *interfaceQueue = static_cast<D3D12CommandQueue *>(queue);
+        if ((interfaceQueue != this) && (value > 0)) {
+            d3d->Wait(interfaceQueue->timelineFence, value);
+        }
+    }
+
     // D3D12Buffer
 
     D3D12Buffer::D3D12Buffer(D3D12Device *device, D3D12Pool *pool, const RenderBufferDesc &desc) {
@@ -2517,7 +2623,7 @@ namespace RT64 {
             for (uint32_t j = 0; j < desc.inputSlotsCount; j++) {
                 if (renderElement.slotIndex == desc.inputSlots[j].index) {
                     inputSlotClass = toD3D12(desc.inputSlots[j].classification);
-                    instanceDataStepRate = (inputSlotClass == D3D12_INPUT_CLASSIFICATION_PER_INSTANCE_DATA) ? desc.inputSlots[j].stride : 0;
+                    instanceDataStepRate = (inputSlotClass == D3D12_INPUT_CLASSIFICATION_PER_INSTANCE_DATA) ? 1 : 0;
                     foundInputSlot = true;
                     break;
                 }
@@ -3055,10 +3161,36 @@ namespace RT64 {
         }
 #   endif
         
+        // Create the command signatures used by indirect draws.
+        D3D12_INDIRECT_ARGUMENT_DESC drawArgumentDesc = {};
+        drawArgumentDesc.Type = D3D12_INDIRECT_ARGUMENT_TYPE_DRAW;
+
+        D3D12_COMMAND_SIGNATURE_DESC signatureDesc = {};
+        signatureDesc.ByteStride = sizeof(RenderDrawIndirectArguments);
+        signatureDesc.NumArgumentDescs = 1;
+        signatureDesc.pArgumentDescs = &drawArgumentDesc;
+        res = d3d->CreateCommandSignature(&signatureDesc, nullptr, IID_PPV_ARGS(&drawCommandSignature));
+        if (FAILED(res)) {
+            fprintf(stderr, "CreateCommandSignature failed with error code 0x%X.\n", res);
+            release();
+            return;
+        }
+
+        drawArgumentDesc.Type = D3D12_INDIRECT_ARGUMENT_TYPE_DRAW_INDEXED;
+        signatureDesc.ByteStride = sizeof(RenderDrawIndexedIndirectArguments);
+        res = d3d->CreateCommandSignature(&signatureDesc, nullptr, IID_PPV_ARGS(&drawIndexedCommandSignature));
+        if (FAILED(res)) {
+            fprintf(stderr, "CreateCommandSignature failed with error code 0x%X.\n", res);
+            release();
+            return;
+        }
+
         // Fill capabilities.
         capabilities.descriptorIndexing = true;
         capabilities.scalarBlockLayout = true;
         capabilities.presentWait = true;
+        capabilities.queueTimelines = true;
+        capabilities.multiDrawIndirect = true;
         capabilities.preferHDR = dedicatedVideoMemory > (512 * 1024 * 1024);
 
         // Create descriptor heaps allocator.
@@ -3309,7 +3441,34 @@ namespace RT64 {
         return countsSupported;
     }
 
+    RenderDescriptorSetStats D3D12Device::getDescriptorSetStats() const {
+        // Descriptor sets are sub-allocated from a single heap instead of pools.
+        RenderDescriptorSetStats stats;
+        stats.setCount = liveDescriptorSetCount;
+        return stats;
+    }
+
+    bool D3D12Device::loadPipelineCache(const void *data, uint64_t size) {
+        // Not implemented. The driver keeps its own cache of compiled pipelines.
+        return false;
+    }
+
+    bool D3D12Device::savePipelineCache(std::vector<uint8_t> &data) {
+        // Not implemented. The driver keeps its own cache of compiled pipelines.
+        return false;
+    }
+
     void D3D12Device::release() {
+        if (drawCommandSignature != nullptr) {
+            drawCommandSignature->Release();
+            drawCommandSignature = nullptr;
+        }
+
+        if (drawIndexedCommandSignature != nullptr) {
+            drawIndexedCommandSignature->Release();
+            drawIndexedCommandSignature = nullptr;
+        }
+
         if (d3d != nullptr) {
             d3d->Release();
             d3d = nullptr;
@@ -6,12 +6,13 @@
 
 #include "rhi/rt64_render_interface.h"
 
+#include <atomic>
 #include <map>
 #include <mutex>
 #include <unordered_map>
 
 #include <d3d12.h>
-#include <dxgi1_4.h>
+#include <dxgi1_5.h>
 
 #include "D3D12MemAlloc.h"
 
@@ -102,6 +103,9 @@ namespace RT64 {
         uint32_t width = 0;
         uint32_t height = 0;
         uint32_t refreshRate = 0;
+        UINT swapChainFlags = 0;
+        bool tearingSupported = false;
+        RenderPresentMode presentMode = RenderPresentMode::FIFO;
 
         D3D12SwapChain(D3D12CommandQueue *commandQueue, RenderWindow renderWindow, uint32_t textureCount, RenderFormat format);
         ~D3D12SwapChain() override;
@@ -115,6 +119,9 @@ namespace RT64 {
         RenderTexture *getTexture(uint32_t index) override;
         RenderWindow getWindow() const override;
         bool isEmpty() const override;
+        bool isPresentModeSupported(RenderPresentMode presentMode) const override;
+        bool setPresentMode(RenderPresentMode presentMode) override;
+        RenderPresentMode getPresentMode() const override;
         uint32_t getRefreshRate() const override;
         void getWindowSize(uint32_t &dstWidth, uint32_t &dstHeight) const;
         void setTextures();
@@ -159,6 +166,8 @@ namespace RT64 {
         void traceRays(uint32_t width, uint32_t height, uint32_t depth, RenderBufferReference shaderBindingTable, const RenderShaderBindingGroupsInfo &shaderBindingGroupsInfo) override;
         void drawInstanced(uint32_t vertexCountPerInstance, uint32_t instanceCount, uint32_t startVertexLocation, uint32_t startInstanceLocation) override;
         void drawIndexedInstanced(uint32_t indexCountPerInstance, uint32_t instanceCount, uint32_t startIndexLocation, int32_t baseVertexLocation, uint32_t startInstanceLocation) override;
+        void drawInstancedIndirect(RenderBufferReference argumentBuffer, uint32_t drawCount) override;
+        void drawIndexedInstancedIndirect(RenderBufferReference argumentBuffer, uint32_t drawCount) override;
         void setPipeline(const RenderPipeline *pipeline) override;
         void setComputePipelineLayout(const RenderPipelineLayout *pipelineLayout) override;
         void setComputePushConstants(uint32_t rangeIndex, const void *data) override;
@@ -207,12 +216,16 @@ namespace RT64 {
         ID3D12CommandQueue *d3d = nullptr;
         D3D12Device *device = nullptr;
         RenderCommandListType type = RenderCommandListType::UNKNOWN;
+        ID3D12Fence *timelineFence = nullptr;
+        std::atomic<uint64_t> timelineValue = 0;
 
         D3D12CommandQueue(D3D12Device *device, RenderCommandListType type);
         ~D3D12CommandQueue() override;
         std::unique_ptr<RenderSwapChain> createSwapChain(RenderWindow renderWindow, uint32_t textureCount, RenderFormat format) override;
         void executeCommandLists(const RenderCommandList **commandLists, uint32_t commandListCount, RenderCommandFence *signalFence) override;
         void waitForCommandFence(RenderCommandFence *fence) override;
+        uint64_t getTimelineValue() override;
+        void waitForCommandQueue(RenderCommandQueue *queue, uint64_t value) override;
     };
 
     struct D3D12Buffer : RenderBuffer {
@@ -381,7 +394,10 @@ namespace RT64 {
         std::unique_ptr<D3D12DescriptorHeapAllocator> descriptorHeapAllocator;
         std::unique_ptr<D3D12DescriptorHeapAllocator> colorTargetHeapAllocator;
         std::unique_ptr<D3D12DescriptorHeapAllocator> depthTargetHeapAllocator;
+        ID3D12CommandSignature *drawCommandSignature = nullptr;
+        ID3D12CommandSignature *drawIndexedCommandSignature = nullptr;
         RenderDeviceCapabilities capabilities;
+        std::atomic<uint32_t> liveDescriptorSetCount = 0;
 
         D3D12Device(D3D12Interface *renderInterface);
         ~D3D12Device() override;
@@ -405,6 +421,9 @@ namespace RT64 {
         void setShaderBindingTableInfo(RenderShaderBindingTableInfo &tableInfo, const RenderShaderBindingGroups &groups, const RenderPipeline *pipeline, RenderDescriptorSet **descriptorSets, uint32_t descriptorSetCount) override;
         const RenderDeviceCapabilities &getCapabilities() const override;
         RenderSampleCounts getSampleCountsSupported(RenderFormat format) const override;
+        RenderDescriptorSetStats getDescriptorSetStats() const override;
+        bool loadPipelineCache(const void *data, uint64_t size) override;
+        bool savePipelineCache(std::vector<uint8_t> &data) override;
         void release();
         bool isValid() const;
     };
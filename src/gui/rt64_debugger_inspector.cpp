@@ -688,6 +688,7 @@ namespace RT64 {
                                         ImGui::Text("WriteChanges");
                                         ImGui::Text("Address: 0x%08X", fbOp.writeChanges.address);
                                         ImGui::Text("Tile ID: %" PRIu64, fbOp.writeChanges.id);
+                                        ImGui::Text("Rows: %u to %u", fbOp.writeChanges.rowStart, fbOp.writeChanges.rowStart + fbOp.writeChanges.rowCount);
                                         break;
                                     case FramebufferOperation::Type::CreateTileCopy: {
                                         ImGui::Text("CreateTileCopy");
@@ -1028,6 +1029,7 @@ namespace RT64 {
                                                     ImGui::Text("Top %u", tileCopy.top);
                                                     ImGui::Text("Width %u", tileCopy.usedWidth);
                                                     ImGui::Text("Height %u", tileCopy.usedHeight);
+                                                    ImGui::Text("Atlas Rect %u %u %u %u", tileCopy.atlasRect.x, tileCopy.atlasRect.y, tileCopy.atlasRect.width, tileCopy.atlasRect.height);
                                                     ImGui::Unindent();
                                                     ImGui::TreePop();
                                                 }
@@ -6,6 +6,7 @@
 #include "rhi/rt64_render_hooks.h"
 
 #include <filesystem>
+#include <fstream>
 
 #include "common/rt64_dynamic_libraries.h"
 #include "common/rt64_elapsed_timer.h"
@@ -58,6 +59,7 @@ namespace RT64 {
         frameCounter = 0;
         threadsAvailable = std::max(std::thread::hardware_concurrency(), 1U);
         freeCamClearQueued = false;
+        rdramWriteNotifications = false;
 
         if (appConfig.detectDataPath) {
             this->appConfig.dataPath = userPaths.detectDataPath(appConfig.appId);
@@ -175,6 +177,7 @@ namespace RT64 {
         workloadVelocityUploader = std::make_unique<BufferUploader>(device.get());
         workloadTilesUploader = std::make_unique<BufferUploader>(device.get());
         framebufferGraphicsWorker = std::make_unique<RenderWorker>(device.get(), "Framebuffer Graphics", RenderCommandListType::DIRECT);
+        readbackQueue = std::make_unique<ReadbackQueue>(framebufferGraphicsWorker.get());
         textureComputeWorker = std::make_unique<RenderWorker>(device.get(), "Texture Compute", RenderCommandListType::COMPUTE);
         workloadGraphicsWorker = std::make_unique<RenderWorker>(device.get(), "Workload Graphics", RenderCommandListType::DIRECT);
         presentGraphicsWorker = std::make_unique<RenderWorker>(device.get(), "Present Graphics", RenderCommandListType::DIRECT);
@@ -203,11 +206,16 @@ namespace RT64 {
             userConfig.antialiasing = UserConfiguration::Antialiasing::None;
         }
 
+        // Load the pipelines compiled by the driver in previous sessions before creating any of them.
+        const bool pipelineCacheLoaded = loadPipelineCache();
+
         // Create the shader library.
+        ElapsedTimer shaderLibraryTimer;
         const RenderMultisampling multisampling = RasterShader::generateMultisamplingPattern(userConfig.msaaSampleCount(), device->getCapabilities().sampleLocations);
         shaderLibrary = std::make_unique<ShaderLibrary>(usesHDR);
         shaderLibrary->setupCommonShaders(renderInterface.get(), device.get());
         shaderLibrary->setupMultisamplingShaders(renderInterface.get(), device.get(), multisampling);
+        RT64_LOG_PRINTF("Created shader library pipelines in %.2f ms (pipeline cache %s).", shaderLibraryTimer.elapsedMilliseconds(), pipelineCacheLoaded ? "loaded" : "not loaded");
         
         // Create the shader caches. Estimate the amount of shader compiler threads by trying to use about half of the system's available threads.
         const uint32_t rasterShaderThreads = std::max(threadsAvailable / 2U, 1U);
@@ -254,6 +262,7 @@ namespace RT64 {
         workloadExt.workloadVelocityUploader = workloadVelocityUploader.get();
         workloadExt.workloadTilesUploader = workloadTilesUploader.get();
         workloadExt.presentQueue = presentQueue.get();
+        workloadExt.readbackQueue = readbackQueue.get();
         workloadExt.sharedResources = sharedQueueResources.get();
         workloadExt.rasterShaderCache = rasterShaderCache.get();
         workloadExt.textureCache = textureCache.get();
@@ -289,6 +298,7 @@ namespace RT64 {
         stateExt.tilesUploader = tilesUploader.get();
         stateExt.workloadQueue = workloadQueue.get();
         stateExt.presentQueue = presentQueue.get();
+        stateExt.readbackQueue = readbackQueue.get();
         stateExt.sharedQueueResources = sharedQueueResources.get();
         stateExt.rasterShaderCache = rasterShaderCache.get();
         stateExt.textureCache = textureCache.get();
@@ -296,6 +306,8 @@ namespace RT64 {
         stateExt.enhancementConfig = &enhancementConfig;
         stateExt.userConfig = &userConfig;
         stateExt.dlApiProfiler = &dlApiProfiler;
+        stateExt.dlEmulatorProfiler = &dlEmulatorProfiler;
+        stateExt.dlThreadGainProfiler = &dlThreadGainProfiler;
         stateExt.screenApiProfiler = &screenApiProfiler;
         stateExt.createdGraphicsAPI = createdGraphicsAPI;
 #   if RT_ENABLED
@@ -309,12 +321,103 @@ namespace RT64 {
         // Set up the RDP 
         state->rdp->setGBI();
 
+        // Create the thread the interpreter can optionally run on.
+        interpreterThread = std::make_unique<InterpreterThread>(interpreter.get(), state.get(), core.RDRAM);
+
+        // Track the pages of RDRAM written to by the emulator.
+        rdramTracker.setup(core.RDRAM, RDRAMSize, rdramWriteNotifications, userConfig.rdramSoftDirtyTracking);
+        state->rdramWritesTracked = (rdramTracker.mode == RDRAMTracker::Mode::Notifications);
+
         return SetupResult::Success;
     }
     
     Application::~Application() { }
 
+    void Application::raiseDeferredInterrupts() {
+        if (state->raiseDeferredInterrupts() && threadedTask.pending && !threadedTask.dpRaised) {
+            threadedTask.dpRaiseMilliseconds = threadedTask.submitTimer.elapsedMilliseconds();
+            threadedTask.dpRaised = true;
+        }
+    }
+
+    void Application::logThreadedTask() {
+        if (!threadedTask.pending) {
+            return;
+        }
+
+        // Processing the task synchronously would've blocked the emulator for as long as the interpreter took. When threaded, the
+        // emulator is blocked while submitting the task and, if the game waits on it, until the DP interrupt is raised.
+        double blockedMilliseconds = threadedTask.emulatorMilliseconds;
+        if (threadedTask.dpRaised) {
+            blockedMilliseconds = std::max(blockedMilliseconds, threadedTask.dpRaiseMilliseconds);
+        }
+
+        const double gainMilliseconds = interpreterThread->lastTaskMilliseconds - blockedMilliseconds;
+        dlThreadGainProfiler.reset();
+        dlThreadGainProfiler.accumulation = gainMilliseconds;
+        dlThreadGainProfiler.log();
+        threadedTask.pending = false;
+
+        // Only stop using the interpreter thread if it's consistently slower than processing the display lists synchronously.
+        if (gainMilliseconds < 0.0) {
+            threadedStallCount++;
+            if (threadedStallCount >= ThreadedStallLimit) {
+                RT64_LOG_PRINTF("Interpreter thread stalled the emulator on %u consecutive tasks. Display lists will be processed synchronously.", threadedStallCount);
+                threadedStallsDetected = true;
+            }
+        }
+        else {
+            threadedStallCount = 0;
+        }
+    }
+
     void Application::processDisplayLists(uint8_t *memory, uint32_t dlStartAddress, uint32_t dlEndAddress, bool isHLE) {
+        dlEmulatorProfiler.reset();
+        dlEmulatorProfiler.start();
+
+        // Only one task can be in flight at a time, so the previous one must be finished before the state or the configuration can
+        // be read. Raise any interrupts from it that were deferred.
+        interpreterThread->wait();
+        raiseDeferredInterrupts();
+        logThreadedTask();
+
+        // Disabling the option allows the interpreter thread to be tried again after stalls were detected.
+        if (!userConfig.threadedDisplayLists) {
+            threadedStallCount = 0;
+            threadedStallsDetected = false;
+        }
+
+        // The interpreter thread can only be used if the task doesn't need to write its results back to RAM before
+        // the emulator resumes. Scripts also rely on the display lists being processed synchronously.
+        bool useInterpreterThread = userConfig.threadedDisplayLists && (memory == core.RDRAM);
+#   if SCRIPT_ENABLED
+        useInterpreterThread = useInterpreterThread && (currentScript == nullptr);
+#   endif
+
+        // The DP interrupt of a threaded task is raised on the next call from the emulator. Games that wait on it before doing anything
+        // else would stall until then, so the display lists are processed synchronously once the thread consistently loses time.
+        useInterpreterThread = useInterpreterThread && !threadedStallsDetected;
+
+        // The inspector modifies the configuration while the display list is processed, so it can't run on the interpreter thread.
+        bool inspectorOpen = false;
+        if (userConfig.developerMode) {
+            const std::lock_guard<std::mutex> lock(presentQueue->inspectorMutex);
+            inspectorOpen = (presentQueue->inspector != nullptr);
+        }
+
+        if (inspectorOpen || state->debuggerInspector.paused || state->renderToRAMEnabled()) {
+            useInterpreterThread = false;
+        }
+
+        // Collect the RDRAM pages written to by the emulator since the last call. These must be handed over along with the task
+        // when the interpreter thread is used, as they must only be considered once the mirror of RDRAM is processed.
+        RDRAMPages dirtyPages;
+        rdramTracker.collect(dirtyPages);
+        interpreterThread->markDirtyPages(dirtyPages);
+        if (!useInterpreterThread) {
+            state->addRDRAMDirtyPages(dirtyPages);
+        }
+
         if (state->debuggerInspector.paused) {
             // TODO: It'd be necessary to parse the display list to see if it actually does a fullSync before sending the interrupt.
             state->dpInterrupt();
@@ -338,7 +441,13 @@ namespace RT64 {
             }
 #       endif
 
-            if (isHLE) {
+            if (useInterpreterThread) {
+                threadedTask.submitTimer.reset();
+                threadedTask.dpRaised = false;
+                threadedTask.pending = true;
+                interpreterThread->submit(dlStartAddress, dlEndAddress, isHLE, dirtyPages);
+            }
+            else if (isHLE) {
                 interpreter->processDisplayLists(dlStartAddress, dlStart);
             }
             else {
@@ -361,18 +470,77 @@ namespace RT64 {
             saveConfiguration();
             state->configurationSaveQueued = false;
         }
+
+        dlEmulatorProfiler.end();
+        if (isHLE) {
+            dlEmulatorProfiler.log();
+        }
+
+        if (threadedTask.pending) {
+            threadedTask.emulatorMilliseconds = threadedTask.submitTimer.elapsedMilliseconds();
+        }
     }
     
     void Application::updateScreen() {
         screenApiProfiler.logAndRestart();
+        interpreterThread->wait();
+        raiseDeferredInterrupts();
+        logThreadedTask();
+
+        RDRAMPages dirtyPages;
+        rdramTracker.collect(dirtyPages);
+        rdramTracker.endFrame();
+        interpreterThread->markDirtyPages(dirtyPages);
+        state->addRDRAMDirtyPages(dirtyPages);
         state->updateScreen(core.decodeVI(), false);
     }
 
+    void Application::setRDRAMWriteNotifications(bool enabled) {
+        rdramWriteNotifications = enabled;
+
+        if (state != nullptr) {
+            interpreterThread->wait();
+            rdramTracker.setup(core.RDRAM, RDRAMSize, rdramWriteNotifications, userConfig.rdramSoftDirtyTracking);
+            state->rdramWritesTracked = (rdramTracker.mode == RDRAMTracker::Mode::Notifications);
+
+            // Nothing is known about the writes that happened before the tracking mode was changed.
+            RDRAMPages allPages;
+            allPages.setAll();
+            interpreterThread->markDirtyPages(allPages);
+            state->addRDRAMDirtyPages(allPages);
+        }
+    }
+
+    void Application::notifyRDRAMWrite(uint32_t address, uint32_t size) {
+        rdramTracker.notifyWrite(address, size);
+
+        // Raise the DP interrupt as soon as the interpreter thread is done with the task without waiting for it.
+        if ((state != nullptr) && (state->deferredInterrupts.load() != 0)) {
+            raiseDeferredInterrupts();
+        }
+    }
+
+    void Application::notifyRDRAMRead(uint32_t address, uint32_t size) {
+        interpreterThread->wait();
+        raiseDeferredInterrupts();
+
+        // The pages written by the emulator since the last call must be known before any readbacks are written back.
+        if (state->rdramWritesTracked) {
+            RDRAMPages dirtyPages;
+            rdramTracker.collect(dirtyPages);
+            interpreterThread->markDirtyPages(dirtyPages);
+            state->addRDRAMDirtyPages(dirtyPages);
+        }
+
+        state->notifyRDRAMRead(address, size);
+    }
+
     bool Application::loadOfflineShaderCache(std::istream &stream) {
         return rasterShaderCache->loadOfflineList(stream);
     }
 
     void Application::destroyShaderCache() {
+        interpreterThread->wait();
         workloadQueue->waitForWorkloadId(state->workloadId);
         presentQueue->waitForPresentId(state->presentId);
         workloadQueue->waitForIdle();
@@ -389,6 +557,8 @@ namespace RT64 {
         }
 #   endif
 
+        interpreterThread->wait();
+
         // Destroy shader cache by waiting for the queues to be idle.
         destroyShaderCache();
 
@@ -477,6 +647,8 @@ namespace RT64 {
         }
 #   endif
 
+        interpreterThread.reset();
+        state->waitForReadbacks();
         state.reset();
         workloadQueue.reset();
         presentQueue.reset();
@@ -499,12 +671,14 @@ namespace RT64 {
         blueNoiseTexture.texture.reset();
 #   endif
         textureCache.reset();
+        readbackQueue.reset();
         framebufferGraphicsWorker.reset();
         textureComputeWorker.reset();
         swapChain.reset();
         workloadGraphicsWorker.reset();
         presentGraphicsWorker.reset();
         shaderLibrary.reset();
+        savePipelineCache();
         device.reset();
         renderInterface.reset();
 
@@ -539,6 +713,64 @@ namespace RT64 {
         return ConfigurationJSON::write(userConfig, cfgStream);
     }
 
+    bool Application::loadPipelineCache() {
+        if (userPaths.isEmpty()) {
+            return false;
+        }
+
+        std::ifstream cacheStream(userPaths.pipelineCachePath, std::ios_base::in | std::ios_base::binary);
+        if (!cacheStream.is_open()) {
+            return false;
+        }
+
+        std::vector<uint8_t> cacheData((std::istreambuf_iterator<char>(cacheStream)), std::istreambuf_iterator<char>());
+        if (cacheData.empty()) {
+            return false;
+        }
+
+        return device->loadPipelineCache(cacheData.data(), cacheData.size());
+    }
+
+    bool Application::savePipelineCache() {
+        if (userPaths.isEmpty() || !checkDirectoryCreated(userPaths.dataPath)) {
+            return false;
+        }
+
+        std::vector<uint8_t> cacheData;
+        if (!device->savePipelineCache(cacheData) || cacheData.empty()) {
+            return false;
+        }
+
+        // The cache is written to a temporary file first and then moved over the previous one, so a crash while writing it can't
+        // leave a truncated cache behind.
+        std::filesystem::path tempCachePath = userPaths.pipelineCachePath;
+        tempCachePath += ".tmp";
+        {
+            std::ofstream cacheStream(tempCachePath, std::ios_base::out | std::ios_base::binary | std::ios_base::trunc);
+            if (!cacheStream.is_open()) {
+                return false;
+            }
+
+            cacheStream.write(reinterpret_cast<const char *>(cacheData.data()), cacheData.size());
+            cacheStream.close();
+            if (cacheStream.fail()) {
+                std::error_code ec;
+                std::filesystem::remove(tempCachePath, ec);
+                return false;
+            }
+        }
+
+        std::error_code ec;
+        std::filesystem::rename(tempCachePath, userPaths.pipelineCachePath, ec);
+        if (ec) {
+            fprintf(stderr, "Failed to replace the pipeline cache: %s\n", ec.message().c_str());
+            std::filesystem::remove(tempCachePath, ec);
+            return false;
+        }
+
+        return true;
+    }
+
     bool Application::checkDirectoryCreated(const std::filesystem::path& path) {
         std::filesystem::path dirPath(path);
         return std::filesystem::is_directory(dirPath) || std::filesystem::create_directories(dirPath);
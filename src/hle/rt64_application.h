@@ -25,6 +25,8 @@
 
 #include "rt64_application_window.h"
 #include "rt64_interpreter.h"
+#include "rt64_interpreter_thread.h"
+#include "rt64_readback_queue.h"
 #include "rt64_shared_queue_resources.h"
 
 #if RT_ENABLED
@@ -108,10 +110,28 @@ namespace RT64 {
         UserPaths userPaths;
         std::unique_ptr<Interpreter> interpreter;
         std::unique_ptr<State> state;
+        std::unique_ptr<InterpreterThread> interpreterThread;
+
+        // Measurements of the last task submitted to the interpreter thread. The DP interrupt of a task can only be raised once the
+        // emulator calls back into the renderer, so the game might've been waiting on it until then.
+        struct ThreadedTask {
+            ElapsedTimer submitTimer;
+            double emulatorMilliseconds = 0.0;
+            double dpRaiseMilliseconds = 0.0;
+            bool pending = false;
+            bool dpRaised = false;
+        } threadedTask;
+
+        static const uint32_t ThreadedStallLimit = 60;
+        uint32_t threadedStallCount = 0;
+        bool threadedStallsDetected = false;
+        RDRAMTracker rdramTracker;
+        bool rdramWriteNotifications;
         std::unique_ptr<ApplicationWindow> appWindow;
         std::unique_ptr<RenderDevice> device;
         std::unique_ptr<RenderSwapChain> swapChain;
         std::unique_ptr<RenderWorker> framebufferGraphicsWorker;
+        std::unique_ptr<ReadbackQueue> readbackQueue;
         std::unique_ptr<BufferUploader> drawDataUploader;
         std::unique_ptr<BufferUploader> transformsUploader;
         std::unique_ptr<BufferUploader> tilesUploader;
@@ -132,6 +152,8 @@ namespace RT64 {
         uint64_t frameCounter;
         uint32_t threadsAvailable;
         ProfilingTimer dlApiProfiler = ProfilingTimer(120);
+        ProfilingTimer dlEmulatorProfiler = ProfilingTimer(120);
+        ProfilingTimer dlThreadGainProfiler = ProfilingTimer(120);
         ProfilingTimer screenApiProfiler = ProfilingTimer(120);
         bool wineDetected;
 
@@ -150,14 +172,21 @@ namespace RT64 {
         Application(const Core &core, const ApplicationConfiguration &appConfig);
         ~Application();
         SetupResult setup(uint32_t threadId);
+        void raiseDeferredInterrupts();
+        void logThreadedTask();
         void processDisplayLists(uint8_t *memory, uint32_t dlStartAddress, uint32_t dlEndAddress, bool isHLE);
         void updateScreen();
+        void setRDRAMWriteNotifications(bool enabled);
+        void notifyRDRAMWrite(uint32_t address, uint32_t size);
+        void notifyRDRAMRead(uint32_t address, uint32_t size);
         bool loadOfflineShaderCache(std::istream &stream);
         void destroyShaderCache();
         void updateMultisampling();
         void end();
         bool loadConfiguration();
         bool saveConfiguration();
+        bool loadPipelineCache();
+        bool savePipelineCache();
         bool checkDirectoryCreated(const std::filesystem::path &path);
 #   ifdef _WIN32
         bool windowMessageFilter(unsigned int message, WPARAM wParam, LPARAM lParam) override;
@@ -37,6 +37,9 @@ namespace RT64 {
         modifiedBytes = 0;
         RAMBytes = 0;
         RAMHash = 0;
+        RAMHashBytes = 0;
+        RAMBlockHashBytes = 0;
+        RAMBlockRowBytes = 0;
         ditherPatterns.fill(0);
         lastWriteType = Type::None;
         lastWriteFmt = 0;
@@ -71,8 +74,105 @@ namespace RT64 {
         return (lastWriteType != Type::None) && (lastWriteType != newType);
     }
 
-    uint32_t Framebuffer::copyRAMToNativeAndChanges(RenderWorker *worker, FramebufferChange &fbChange, const uint8_t *src, uint32_t rowStart, uint32_t rowCount, uint8_t fmt, bool invalidateTargets, const ShaderLibrary *shaderLibrary) {
-        assert(worker != nullptr);
+    void Framebuffer::hashRAMBlocks(const uint8_t *fbRAM) {
+        assert(fbRAM != nullptr);
+
+        const uint32_t rowBytes = imageRowBytes(width);
+        const uint32_t blockBytes = rowBytes * RAMBlockRows;
+        if ((blockBytes == 0) || (RAMBytes == 0)) {
+            RAMBlockHashes.clear();
+            RAMBlockHashBytes = 0;
+            RAMBlockRowBytes = 0;
+            return;
+        }
+
+        const uint32_t blockCount = (RAMBytes + blockBytes - 1) / blockBytes;
+        RAMBlockHashes.resize(blockCount);
+        for (uint32_t b = 0; b < blockCount; b++) {
+            const uint32_t blockOffset = b * blockBytes;
+            RAMBlockHashes[b] = XXH3_64bits(&fbRAM[blockOffset], std::min(blockBytes, RAMBytes - blockOffset));
+        }
+
+        RAMBlockHashBytes = RAMBytes;
+        RAMBlockRowBytes = rowBytes;
+    }
+
+    void Framebuffer::hashRAM(const uint8_t *fbRAM) {
+        assert(fbRAM != nullptr);
+
+        const uint32_t rowBytes = imageRowBytes(width);
+        const uint32_t blockBytes = rowBytes * RAMBlockRows;
+        if ((blockBytes == 0) || (RAMBytes == 0)) {
+            RAMHash = XXH3_64bits(fbRAM, RAMBytes);
+            RAMHashBytes = RAMBytes;
+            RAMBlockHashes.clear();
+            RAMBlockHashBytes = 0;
+            RAMBlockRowBytes = 0;
+            return;
+        }
+
+        // The hash of the whole framebuffer is streamed alongside the hash of each block while the block is still in the cache,
+        // so the memory is only read once. The streamed hash is identical to hashing the whole framebuffer at once.
+        XXH3_state_t xxh3;
+        XXH3_64bits_reset(&xxh3);
+
+        const uint32_t blockCount = (RAMBytes + blockBytes - 1) / blockBytes;
+        RAMBlockHashes.resize(blockCount);
+        for (uint32_t b = 0; b < blockCount; b++) {
+            const uint32_t blockOffset = b * blockBytes;
+            const uint32_t blockSize = std::min(blockBytes, RAMBytes - blockOffset);
+            RAMBlockHashes[b] = XXH3_64bits(&fbRAM[blockOffset], blockSize);
+            XXH3_64bits_update(&xxh3, &fbRAM[blockOffset], blockSize);
+        }
+
+        RAMHash = XXH3_64bits_digest(&xxh3);
+        RAMHashBytes = RAMBytes;
+        RAMBlockHashBytes = RAMBytes;
+        RAMBlockRowBytes = rowBytes;
+    }
+
+    bool Framebuffer::checkRAMBlocks(const uint8_t *fbRAM, uint32_t &rowStart, uint32_t &rowCount, uint32_t &changedBytes) {
+        assert(fbRAM != nullptr);
+
+        // The entire framebuffer is considered to be modified if the block hashes were computed with a different layout.
+        const uint32_t rowBytes = imageRowBytes(width);
+        const uint32_t blockBytes = rowBytes * RAMBlockRows;
+        if ((RAMBlockHashBytes != RAMBytes) || (RAMBlockRowBytes != rowBytes) || (blockBytes == 0)) {
+            hashRAMBlocks(fbRAM);
+            rowStart = 0;
+            rowCount = height;
+            changedBytes = RAMBytes;
+            return false;
+        }
+
+        uint32_t firstBlock = UINT32_MAX;
+        uint32_t lastBlock = 0;
+        changedBytes = 0;
+        for (uint32_t b = 0; b < uint32_t(RAMBlockHashes.size()); b++) {
+            const uint32_t blockOffset = b * blockBytes;
+            const uint32_t blockSize = std::min(blockBytes, RAMBytes - blockOffset);
+            const uint64_t blockHash = XXH3_64bits(&fbRAM[blockOffset], blockSize);
+            if (blockHash != RAMBlockHashes[b]) {
+                RAMBlockHashes[b] = blockHash;
+                firstBlock = std::min(firstBlock, b);
+                lastBlock = b;
+                changedBytes += blockSize;
+            }
+        }
+
+        if (firstBlock == UINT32_MAX) {
+            rowStart = 0;
+            rowCount = 0;
+        }
+        else {
+            rowStart = std::min(firstBlock * RAMBlockRows, height);
+            rowCount = std::min((lastBlock + 1) * RAMBlockRows, height) - rowStart;
+        }
+
+        return true;
+    }
+
+    const uint8_t *Framebuffer::swapRAMToNative(const uint8_t *src, uint32_t rowCount) {
         assert(src != nullptr);
 
         // Swap the endianness from the source.
@@ -91,7 +191,23 @@ namespace RT64 {
             dstWords++;
         }
 
-        uint32_t differentPixels = nativeTarget.copyFromRAM(worker, fbChange, width, rowCount, rowStart, siz, fmt, nativeSwappedRAM.data(), invalidateTargets, shaderLibrary);
+        return nativeSwappedRAM.data();
+    }
+
+    void Framebuffer::copyRAMRowsToNativeAndChanges(RenderWorker *worker, FramebufferChange &fbChange, const uint8_t *src, uint32_t rowStart, uint32_t rowCount, uint8_t fmt, const ShaderLibrary *shaderLibrary) {
+        assert(worker != nullptr);
+        assert(src != nullptr);
+
+        const uint8_t *nativeRows = swapRAMToNative(src + imageRowBytes(width) * rowStart, rowCount);
+        nativeTarget.copyRowsFromRAM(worker, fbChange, width, height, rowStart, rowCount, siz, fmt, nativeRows, shaderLibrary);
+    }
+
+    uint32_t Framebuffer::copyRAMToNativeAndChanges(RenderWorker *worker, FramebufferChange &fbChange, const uint8_t *src, uint32_t rowStart, uint32_t rowCount, uint8_t fmt, bool invalidateTargets, const ShaderLibrary *shaderLibrary) {
+        assert(worker != nullptr);
+        assert(src != nullptr);
+
+        const uint8_t *nativeRAM = swapRAMToNative(src, rowCount);
+        uint32_t differentPixels = nativeTarget.copyFromRAM(worker, fbChange, width, rowCount, rowStart, siz, fmt, nativeRAM, invalidateTargets, shaderLibrary);
         return differentPixels;
     }
 
@@ -99,6 +215,9 @@ namespace RT64 {
         assert(worker != nullptr);
         assert(src != nullptr);
         
+        // The read buffer no longer corresponds to the block hashes, so they must be computed again on the next upload.
+        RAMBlockHashBytes = 0;
+
         FramebufferChange &changeUsed = fbChangePool.use(worker, (type == Type::Depth) ? FramebufferChange::Type::Depth : FramebufferChange::Type::Color, width, rowCount, shaderLibrary->usesHDR);
         uint32_t readPixels = copyRAMToNativeAndChanges(worker, changeUsed, src, rowStart, rowCount, fmt, true, shaderLibrary);
         if (readPixels > 0) {
@@ -131,6 +250,7 @@ namespace RT64 {
         assert(dstRowStart < height);
         assert(dstRowEnd <= height);
 
+        RAMBlockHashBytes = 0;
         nativeTarget.copyToNative(worker, target, dstRowWidth, dstRowStart, dstRowEnd, siz, fmt, bestDitherPattern(), ditherRandomSeed, shaderLibrary);
     }
 
@@ -22,6 +22,9 @@ namespace RT64 {
             Depth
         };
 
+        // Amount of rows covered by each of the hashes used to detect which parts of the framebuffer were modified in RAM.
+        static const uint32_t RAMBlockRows = 8;
+
         uint32_t addressStart;
         uint32_t addressEnd;
         uint8_t siz;
@@ -38,6 +41,10 @@ namespace RT64 {
         uint32_t modifiedBytes;
         uint32_t RAMBytes;
         uint64_t RAMHash;
+        uint32_t RAMHashBytes;
+        std::vector<uint64_t> RAMBlockHashes;
+        uint32_t RAMBlockHashBytes;
+        uint32_t RAMBlockRowBytes;
         std::array<uint32_t, 4> ditherPatterns;
         bool widthChanged;
         bool sizChanged;
@@ -52,6 +59,11 @@ namespace RT64 {
         bool overlaps(uint32_t start, uint32_t end) const;
         void discardLastWrite();
         bool isLastWriteDifferent(Framebuffer::Type newType) const;
+        void hashRAMBlocks(const uint8_t *fbRAM);
+        void hashRAM(const uint8_t *fbRAM);
+        bool checkRAMBlocks(const uint8_t *fbRAM, uint32_t &rowStart, uint32_t &rowCount, uint32_t &changedBytes);
+        const uint8_t *swapRAMToNative(const uint8_t *src, uint32_t rowCount);
+        void copyRAMRowsToNativeAndChanges(RenderWorker *worker, FramebufferChange &fbChange, const uint8_t *src, uint32_t rowStart, uint32_t rowCount, uint8_t fmt, const ShaderLibrary *shaderLibrary);
         uint32_t copyRAMToNativeAndChanges(RenderWorker *worker, FramebufferChange &fbChange, const uint8_t *src, uint32_t rowStart, uint32_t rowCount, uint8_t fmt, bool invalidateTargets, const ShaderLibrary *shaderLibrary);
         FramebufferChange *readChangeFromBytes(RenderWorker *worker, FramebufferChangePool &fbChangePool, Type type, uint8_t fmt, const uint8_t *src, uint32_t rowStart, uint32_t rowCount, const ShaderLibrary *shaderLibrary);
         FramebufferChange *readChangeFromStorage(RenderWorker *worker, const FramebufferStorage &fbStorage, FramebufferChangePool &fbChangePool, Type type, uint8_t fmt,
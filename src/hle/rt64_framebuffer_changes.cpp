@@ -4,6 +4,8 @@
 
 #include "rt64_framebuffer_changes.h"
 
+#include <algorithm>
+
 #include "render/rt64_render_target.h"
 
 namespace RT64 {
@@ -14,6 +16,7 @@ namespace RT64 {
         type = Type::Color;
         width = 0;
         height = 0;
+        usesHDR = false;
         used = false;
     }
 
@@ -29,29 +32,30 @@ namespace RT64 {
 
     void FramebufferChangePool::reset() {
         for (auto &changes : changesMap) {
-            changes.second.used = false;
+            if (changes.second.used) {
+                changes.second.used = false;
+                freeBuckets[bucketKey(changes.second.type, changes.second.width, changes.second.height, changes.second.usesHDR)].push_back(changes.first);
+            }
         }
+
+        stats.hits = 0;
+        stats.misses = 0;
     }
 
     FramebufferChange &FramebufferChangePool::use(RenderWorker *renderWorker, FramebufferChange::Type type, uint32_t width, uint32_t height, bool usesHDR) {
-        // To increase the chances of reusing buffers, we extend the width and height to a multiple of 32.
-        const uint32_t Alignment = 32;
-        uint32_t alignedWidth = ((width / Alignment) + ((width % Alignment) ? 1 : 0)) * Alignment;
-        uint32_t alignedHeight = ((height / Alignment) + ((height % Alignment) ? 1 : 0)) * Alignment;
+        // To increase the chances of reusing buffers, the sizes are extended to the size class they belong to.
+        const uint32_t alignedWidth = widthClass(width);
+        const uint32_t alignedHeight = heightClass(height);
 
         // Find a compatible changes buffer to use.
-        for (auto &changes : changesMap) {
-            if (changes.second.used) {
-                continue;
-            }
-
-            if ((changes.second.type == type) &&
-                (changes.second.width == alignedWidth) &&
-                (changes.second.height == alignedHeight))
-            {
-                changes.second.used = true;
-                return changes.second;
-            }
+        auto bucketIt = freeBuckets.find(bucketKey(type, alignedWidth, alignedHeight, usesHDR));
+        if ((bucketIt != freeBuckets.end()) && !bucketIt->second.empty()) {
+            auto &changes = changesMap[bucketIt->second.back()];
+            bucketIt->second.pop_back();
+            assert(!changes.used);
+            changes.used = true;
+            stats.hits++;
+            return changes;
         }
 
         uint64_t changesId = newId++;
@@ -60,7 +64,9 @@ namespace RT64 {
         changes.type = type;
         changes.width = alignedWidth;
         changes.height = alignedHeight;
+        changes.usesHDR = usesHDR;
         changes.used = true;
+        stats.misses++;
 
         RenderFormat pixelFormat;
         switch (type) {
@@ -75,6 +81,8 @@ namespace RT64 {
             break;
         }
 
+        stats.residentBytes += uint64_t(alignedWidth) * alignedHeight * (RenderFormatSize(pixelFormat) + RenderFormatSize(RenderFormat::R8_UINT));
+
         changes.pixelTexture = renderWorker->device->createTexture(RenderTextureDesc::Texture2D(alignedWidth, alignedHeight, 1, pixelFormat, RenderTextureFlag::STORAGE | RenderTextureFlag::UNORDERED_ACCESS));
         changes.booleanTexture = renderWorker->device->createTexture(RenderTextureDesc::Texture2D(alignedWidth, alignedHeight, 1, RenderFormat::R8_UINT, RenderTextureFlag::STORAGE | RenderTextureFlag::UNORDERED_ACCESS));
         changes.drawDescSet = std::make_unique<FramebufferDrawChangesDescriptorSet>(renderWorker->device);
@@ -102,6 +110,37 @@ namespace RT64 {
     void FramebufferChangePool::release(uint64_t id) {
         auto it = changesMap.find(id);
         assert(it != changesMap.end());
-        it->second.used = false;
+        if (it->second.used) {
+            it->second.used = false;
+            freeBuckets[bucketKey(it->second.type, it->second.width, it->second.height, it->second.usesHDR)].push_back(id);
+        }
+    }
+
+    uint32_t FramebufferChangePool::widthClass(uint32_t width) {
+        // The width of the changes is always the width of a framebuffer, so it's enough to align it to a multiple of 32.
+        const uint32_t Alignment = 32;
+        return std::max(((width + Alignment - 1) / Alignment) * Alignment, Alignment);
+    }
+
+    uint32_t FramebufferChangePool::heightClass(uint32_t height) {
+        // The height varies with the amount of rows that were modified, so it's rounded up to the next step of 32, 64, 96, 128,
+        // 192, 256, 384, 512 and so on. This keeps the amount of different sizes low while wasting no more than a third of the texture.
+        const uint32_t Alignment = 32;
+        const uint32_t LinearLimit = 64;
+        if (height <= LinearLimit) {
+            return std::max(((height + Alignment - 1) / Alignment) * Alignment, Alignment);
+        }
+
+        uint32_t power = LinearLimit;
+        while ((power * 2) < height) {
+            power *= 2;
+        }
+
+        const uint32_t midStep = power + (power / 2);
+        return (height <= midStep) ? midStep : (power * 2);
+    }
+
+    uint64_t FramebufferChangePool::bucketKey(FramebufferChange::Type type, uint32_t width, uint32_t height, bool usesHDR) {
+        return (uint64_t(width) << 32) | (uint64_t(height) << 2) | (uint64_t(usesHDR) << 1) | uint64_t(type == FramebufferChange::Type::Depth);
     }
 };
\ No newline at end of file
@@ -12,6 +12,8 @@
 #pragma once
 
 #include <map>
+#include <unordered_map>
+#include <vector>
 
 #include "common/rt64_common.h"
 #include "render/rt64_descriptor_sets.h"
@@ -28,6 +30,7 @@ namespace RT64 {
         Type type;
         uint32_t width;
         uint32_t height;
+        bool usesHDR;
         std::unique_ptr<RenderTexture> pixelTexture;
         std::unique_ptr<RenderTexture> booleanTexture;
         std::unique_ptr<FramebufferDrawChangesDescriptorSet> drawDescSet;
@@ -39,14 +42,27 @@ namespace RT64 {
     };
 
     struct FramebufferChangePool {
+        struct Stats {
+            uint32_t hits = 0;
+            uint32_t misses = 0;
+            uint64_t residentBytes = 0;
+        };
+
         uint64_t newId;
         std::map<uint64_t, FramebufferChange> changesMap;
 
+        // Changes that aren't in use are grouped by their bucket key so they can be reused without searching the whole pool.
+        std::unordered_map<uint64_t, std::vector<uint64_t>> freeBuckets;
+        Stats stats;
+
         FramebufferChangePool();
         ~FramebufferChangePool();
         void reset();
         FramebufferChange &use(RenderWorker *renderWorker, FramebufferChange::Type type, uint32_t width, uint32_t height, bool usesHDR);
         const FramebufferChange *get(uint64_t id) const;
         void release(uint64_t id);
+        static uint32_t widthClass(uint32_t width);
+        static uint32_t heightClass(uint32_t height);
+        static uint64_t bucketKey(FramebufferChange::Type type, uint32_t width, uint32_t height, bool usesHDR);
     };
 };
\ No newline at end of file
@@ -6,6 +6,9 @@
 
 #include <cassert>
 #include <algorithm>
+#include <functional>
+#include <iterator>
+#include <tuple>
 
 #include "xxHash/xxh3.h"
 
@@ -48,6 +51,7 @@ namespace RT64 {
         fb.width = width;
         fb.addressStart = address;
         fb.addressEnd = fb.addressStart + fb.imageRowBytes(width) * fb.height;
+        maxFramebufferBytes = std::max(maxFramebufferBytes, fb.addressEnd - fb.addressStart);
         return fb;
     }
 
@@ -63,8 +67,8 @@ namespace RT64 {
     
     Framebuffer *FramebufferManager::findMostRecentContaining(uint32_t addressStart, uint32_t addressEnd) {
         Framebuffer *mostRecent = nullptr;
-        auto it = framebuffers.begin();
-        while (it != framebuffers.end()) {
+        auto it = findFirstOverlapping(addressStart);
+        while ((it != framebuffers.end()) && (it->first < addressEnd)) {
             if (it->second.overlaps(addressStart, addressEnd)) {
                 if (mostRecent != nullptr) {
                     // Prioritize FBs with newer timestamps.
@@ -86,6 +90,19 @@ namespace RT64 {
 
         return mostRecent;
     }
+
+    std::map<uint32_t, Framebuffer>::iterator FramebufferManager::findFirstOverlapping(uint32_t addressStart) {
+        // Framebuffers that start further back than the biggest framebuffer can't reach the address.
+        const uint32_t searchStart = (addressStart > maxFramebufferBytes) ? (addressStart - maxFramebufferBytes) : 0;
+        return framebuffers.lower_bound(searchStart);
+    }
+
+    void FramebufferManager::updateMaxFramebufferBytes() {
+        maxFramebufferBytes = 0;
+        for (const auto &it : framebuffers) {
+            maxFramebufferBytes = std::max(maxFramebufferBytes, it.second.addressEnd - it.second.addressStart);
+        }
+    }
     
     void FramebufferManager::writeChanges(RenderWorker *renderWorker, const FramebufferChangePool &fbChangePool, const FramebufferOperation &op, 
         RenderTargetManager &targetManager, const ShaderLibrary *shaderLibrary)
@@ -97,7 +114,7 @@ namespace RT64 {
             RenderTargetKey targetKey(it->second.addressStart, it->second.width, it->second.siz, it->second.lastWriteType);
             RenderTarget &target = targetManager.get(targetKey);
             if (!target.isEmpty()) {
-                target.copyFromChanges(renderWorker, *fbChange, it->second.width, it->second.height, 0, shaderLibrary);
+                target.copyFromChanges(renderWorker, *fbChange, it->second.width, op.writeChanges.rowCount, op.writeChanges.rowStart, shaderLibrary);
             }
         }
     }
@@ -129,28 +146,7 @@ namespace RT64 {
         tileCopy.readDepthFromStorage = false;
         tileCopy.ignore = false;
 
-        const bool insufficientSize = (tileCopy.textureWidth < tileWidth) || (tileCopy.textureHeight < tileHeight);
-        if (insufficientSize) {
-            tileCopy.framebuffer.reset();
-            tileCopy.texture.reset();
-        }
-
-        if (tileCopy.texture == nullptr) {
-            tileCopy.textureWidth = tileWidth;
-            tileCopy.textureHeight = tileHeight;
-            fixSizeToMultiple(tileCopy.textureWidth, tileCopy.textureHeight);
-
-            RenderTextureFlags textureFlags = RenderTextureFlag::STORAGE | RenderTextureFlag::UNORDERED_ACCESS;
-            textureFlags |= RenderTextureFlag::RENDER_TARGET;
-
-            const RenderTextureDesc textureDesc = RenderTextureDesc::Texture2D(tileCopy.textureWidth, tileCopy.textureHeight, 1, RenderTarget::colorBufferFormat(targetManager.usesHDR), textureFlags);
-            tileCopy.texture = renderWorker->device->createTexture(textureDesc);
-        }
-
-        if (tileCopy.framebuffer == nullptr) {
-            const RenderTexture *framebufferTexture = tileCopy.texture.get();
-            tileCopy.framebuffer = renderWorker->device->createFramebuffer(RenderFramebufferDesc(&framebufferTexture, 1));
-        }
+        allocateTileCopy(renderWorker, tileCopy, tileWidth, tileHeight, false, targetManager.usesHDR);
         
         RenderTargetKey colorTargetKey(fbIt->second.addressStart, fbIt->second.width, fbIt->second.siz, Framebuffer::Type::Color);
         RenderTarget &colorTarget = targetManager.get(colorTargetKey);
@@ -223,15 +219,15 @@ namespace RT64 {
         const uint32_t srcBottom = std::min(tileCopy.top + tileCopy.usedHeight, static_cast<uint32_t>(colorTarget.height));
         CommandListCopyRegion copyRegion = {};
         copyRegion.srcTexture = colorTarget.getResolvedTexture();
-        copyRegion.dstTexture = tileCopy.texture.get();
 
         if (colorTarget.textureCopyDescSet == nullptr) {
             colorTarget.textureCopyDescSet = std::make_unique<TextureCopyDescriptorSet>(renderWorker->device);
             colorTarget.textureCopyDescSet->setTexture(colorTarget.textureCopyDescSet->gInput, colorTarget.getResolvedTexture(), RenderTextureLayout::SHADER_READ, colorTarget.getResolvedTextureView());
         }
 
-        assert(tileCopy.framebuffer != nullptr);
-        copyRegion.dstFramebuffer = tileCopy.framebuffer.get();
+        assert(tileCopy.atlas != nullptr);
+        copyRegion.dstAtlas = tileCopy.atlas;
+        copyRegion.dstRect = tileCopy.atlasRect;
         copyRegion.descriptorSet = colorTarget.textureCopyDescSet->get();
         copyRegion.pushConstants.uvScroll = { float(tileCopy.left), float(tileCopy.top) };
         copyRegion.pushConstants.uvScale = { float(srcRight - tileCopy.left), float(srcBottom - tileCopy.top) };
@@ -243,7 +239,7 @@ namespace RT64 {
 
         // Source tile must exist.
         TileCopy &srcTile = tileCopies[op.reinterpretTile.srcId];
-        if (srcTile.texture == nullptr) {
+        if (srcTile.atlas == nullptr) {
             srcTile.ignore = true;
             return;
         }
@@ -281,23 +277,7 @@ namespace RT64 {
         dstTile.ditherPattern = srcTile.ditherPattern;
         srcTile.ignore = false;
 
-        const bool insufficientSize = (dstTile.textureWidth < dstTileWidth) || (dstTile.textureHeight < dstTileHeight);
-        if (insufficientSize) {
-            dstTile.framebuffer.reset();
-            dstTile.texture.reset();
-        }
-
-        if (dstTile.texture == nullptr) {
-            dstTile.textureWidth = dstTileWidth;
-            dstTile.textureHeight = dstTileHeight;
-            fixSizeToMultiple(dstTile.textureWidth, dstTile.textureHeight);
-
-            RenderTextureFlags textureFlags = RenderTextureFlag::STORAGE | RenderTextureFlag::UNORDERED_ACCESS;
-            textureFlags |= RenderTextureFlag::RENDER_TARGET;
-
-            const RenderTextureDesc textureDesc = RenderTextureDesc::Texture2D(dstTile.textureWidth, dstTile.textureHeight, 1, RenderTarget::colorBufferFormat(usesHDR), textureFlags);
-            dstTile.texture = renderWorker->device->createTexture(textureDesc);
-        }
+        allocateTileCopy(renderWorker, dstTile, dstTileWidth, dstTileHeight, true, usesHDR);
     }
 
     void FramebufferManager::reinterpretTileRecord(RenderWorker *renderWorker, const FramebufferOperation &op, TextureCache &textureCache, hlslpp::float2 resolutionScale,
@@ -311,23 +291,27 @@ namespace RT64 {
         }
 
         TileCopy &dstTile = tileCopies[op.reinterpretTile.dstId];
-        const uint32_t index = uint32_t(cmdListReinterpretations.cmdListDispatches.size());
         CommandListReinterpretDispatch dispatch;
         auto &c = dispatch.reinterpretCB;
-        c.resolution.x = dstTile.usedWidth;
-        c.resolution.y = dstTile.usedHeight;
-        c.sampleScale = dstTile.sampleScale;
         c.srcSiz = op.reinterpretTile.srcSiz;
         c.srcFmt = op.reinterpretTile.srcFmt;
         c.dstSiz = op.reinterpretTile.dstSiz;
         c.dstFmt = op.reinterpretTile.dstFmt;
         c.tlutFormat = (op.reinterpretTile.tlutHash != 0) ? (op.reinterpretTile.tlutFormat + 1) : 0;
-        c.ditherOffset = dstTile.ditherOffset;
-        c.ditherPattern = dstTile.ditherPattern;
-        c.ditherRandomSeed = uint32_t(writeTimestamp) + op.reinterpretTile.dstId;
         c.usesHDR = usesHDR;
-        dispatch.srcTexture = srcTile.texture.get();
-        dispatch.dstTexture = dstTile.texture.get();
+
+        auto &r = dispatch.region;
+        r.resolution.x = dstTile.usedWidth;
+        r.resolution.y = dstTile.usedHeight;
+        r.inputOffset = { srcTile.atlasRect.x, srcTile.atlasRect.y };
+        r.inputSize = { srcTile.atlasRect.width, srcTile.atlasRect.height };
+        r.outputOffset = { dstTile.atlasRect.x, dstTile.atlasRect.y };
+        r.ditherOffset = dstTile.ditherOffset;
+        r.sampleScale = dstTile.sampleScale;
+        r.ditherPattern = dstTile.ditherPattern;
+        r.ditherRandomSeed = uint32_t(writeTimestamp) + op.reinterpretTile.dstId;
+        dispatch.srcTexture = srcTile.atlas->texture.get();
+        dispatch.dstAtlas = dstTile.atlas;
 
         // Assert for known reinterpretation cases only that are currently supported by the shader.
         assert("Unimplemented reinterpretation logic." && (
@@ -336,30 +320,17 @@ namespace RT64 {
             ((c.srcFmt == G_IM_FMT_RGBA) && (c.srcSiz == G_IM_SIZ_16b) && (c.dstFmt == G_IM_FMT_IA) && (c.dstSiz == G_IM_SIZ_16b))
         ));
 
-        while (descriptorReinterpretSetsCount >= descriptorReinterpretSets.size()) {
-            descriptorReinterpretSets.emplace_back();
-        }
-
-        std::unique_ptr<ReinterpretDescriptorSet> &reinterpretSet = descriptorReinterpretSets[descriptorReinterpretSetsCount];
-        descriptorReinterpretSetsCount++;
-
-        if (reinterpretSet == nullptr) {
-            reinterpretSet = std::make_unique<ReinterpretDescriptorSet>(renderWorker->device);
-        }
-
-        reinterpretSet->setTexture(reinterpretSet->gInputColor, dispatch.srcTexture, RenderTextureLayout::SHADER_READ);
-        reinterpretSet->setTexture(reinterpretSet->gOutput, dispatch.dstTexture, RenderTextureLayout::GENERAL);
-
         // Search the texture cache for the TLUT if it's required.
         if (op.reinterpretTile.tlutHash > 0) {
             uint32_t textureIndex;
             if (textureCache.useTexture(op.reinterpretTile.tlutHash, submissionFrame, textureIndex)) {
                 const Texture *cacheTexture = textureCache.getTexture(textureIndex);
                 assert(cacheTexture != nullptr);
-                reinterpretSet->setTexture(reinterpretSet->gInputTLUT, cacheTexture->tmem.get(), RenderTextureLayout::SHADER_READ);
+                dispatch.tlutTexture = cacheTexture->tmem.get();
             }
             else {
                 assert(false && "Unable to find TLUT required for reintepretation on the texture cache.");
+                return;
             }
         }
         else {
@@ -368,13 +339,126 @@ namespace RT64 {
                 renderWorker->commandList->barriers(RenderBarrierStage::COMPUTE, RenderTextureBarrier(dummyTLUTTexture.get(), RenderTextureLayout::SHADER_READ));
             }
 
-            reinterpretSet->setTexture(reinterpretSet->gInputTLUT, dummyTLUTTexture.get(), RenderTextureLayout::SHADER_READ);
+            dispatch.tlutTexture = dummyTLUTTexture.get();
         }
 
-        dispatch.descriptorSet = reinterpretSet->get();
         cmdListReinterpretations.cmdListDispatches.emplace_back(dispatch);
     }
 
+    void FramebufferManager::reinterpretTileBatches(RenderWorker *renderWorker, CommandListReinterpretations &cmdListReinterpretations) {
+        // Dispatches that share the same formats and resources only differ in their regions, so they can be executed together.
+        std::vector<CommandListReinterpretDispatch> &dispatches = cmdListReinterpretations.cmdListDispatches;
+        auto dispatchKey = [](const CommandListReinterpretDispatch &d) {
+            const interop::FbReinterpretCB &c = d.reinterpretCB;
+            return std::make_tuple(c.srcSiz, c.srcFmt, c.dstSiz, c.dstFmt, c.tlutFormat, uintptr_t(d.tlutTexture), uintptr_t(d.srcTexture), uintptr_t(d.dstAtlas));
+        };
+
+        // Dispatches are only reordered within segments where none of them reads from an atlas written by another one. Segments are
+        // kept in submission order, so reinterpretations of reinterpreted tiles still see the results they depend on.
+        auto sortSegment = [&](size_t segmentStart, size_t segmentEnd) {
+            std::stable_sort(dispatches.begin() + segmentStart, dispatches.begin() + segmentEnd, [&](const CommandListReinterpretDispatch &a, const CommandListReinterpretDispatch &b) {
+                return dispatchKey(a) < dispatchKey(b);
+            });
+        };
+
+        thread_local std::vector<const RenderTexture *> segmentSrcTextures;
+        thread_local std::vector<const RenderTexture *> segmentDstTextures;
+        thread_local std::vector<size_t> segmentEnds;
+        segmentSrcTextures.clear();
+        segmentDstTextures.clear();
+        segmentEnds.clear();
+
+        size_t segmentStart = 0;
+        for (size_t i = 0; i < dispatches.size(); i++) {
+            const RenderTexture *srcTexture = dispatches[i].srcTexture;
+            const RenderTexture *dstTexture = dispatches[i].dstAtlas->texture.get();
+            const bool readsSegmentOutput = std::find(segmentDstTextures.begin(), segmentDstTextures.end(), srcTexture) != segmentDstTextures.end();
+            const bool writesSegmentInput = std::find(segmentSrcTextures.begin(), segmentSrcTextures.end(), dstTexture) != segmentSrcTextures.end();
+            if (readsSegmentOutput || writesSegmentInput) {
+                sortSegment(segmentStart, i);
+                segmentEnds.emplace_back(i);
+                segmentStart = i;
+                segmentSrcTextures.clear();
+                segmentDstTextures.clear();
+            }
+
+            segmentSrcTextures.emplace_back(srcTexture);
+            segmentDstTextures.emplace_back(dstTexture);
+        }
+
+        sortSegment(segmentStart, dispatches.size());
+        segmentEnds.emplace_back(dispatches.size());
+
+        // Groups can't extend past the end of their segment, as the regions of a batch are processed concurrently.
+        size_t groupStart = 0;
+        size_t segmentIndex = 0;
+        while (groupStart < dispatches.size()) {
+            if (groupStart == segmentEnds[segmentIndex]) {
+                segmentIndex++;
+            }
+
+            const size_t segmentEnd = segmentEnds[segmentIndex];
+            size_t groupEnd = groupStart + 1;
+            while ((groupEnd < segmentEnd) && (dispatchKey(dispatches[groupEnd]) == dispatchKey(dispatches[groupStart]))) {
+                groupEnd++;
+            }
+
+            // Groups that don't fit in the space left in the current region buffer are split across multiple batches.
+            size_t batchStart = groupStart;
+            while (batchStart < groupEnd) {
+                if ((reinterpretRegionBuffersCount == 0) || (reinterpretRegionCursor == ReinterpretRegionsPerBuffer)) {
+                    while (reinterpretRegionBuffersCount >= reinterpretRegionBuffers.size()) {
+                        const uint64_t bufferSize = sizeof(interop::FbReinterpretRegion) * ReinterpretRegionsPerBuffer;
+                        reinterpretRegionBuffers.emplace_back(renderWorker->device->createBuffer(RenderBufferDesc::UploadBuffer(bufferSize, RenderBufferFlag::STORAGE)));
+                    }
+
+                    reinterpretRegionBuffersCount++;
+                    reinterpretRegionCursor = 0;
+                }
+
+                RenderBuffer *regionBuffer = reinterpretRegionBuffers[reinterpretRegionBuffersCount - 1].get();
+                const uint32_t regionCount = uint32_t(std::min<size_t>(groupEnd - batchStart, ReinterpretRegionsPerBuffer - reinterpretRegionCursor));
+                const CommandListReinterpretDispatch &groupDispatch = dispatches[batchStart];
+                CommandListReinterpretBatch batch;
+                batch.reinterpretCB = groupDispatch.reinterpretCB;
+                batch.reinterpretCB.regionStart = reinterpretRegionCursor;
+                batch.dstTexture = groupDispatch.dstAtlas->texture.get();
+                batch.regionCount = regionCount;
+                batch.segmentIndex = uint32_t(segmentIndex);
+                batch.maxResolution = { 0, 0 };
+
+                interop::FbReinterpretRegion *dstRegions = reinterpret_cast<interop::FbReinterpretRegion *>(regionBuffer->map());
+                for (uint32_t i = 0; i < regionCount; i++) {
+                    const interop::FbReinterpretRegion &region = dispatches[batchStart + i].region;
+                    dstRegions[reinterpretRegionCursor + i] = region;
+                    batch.maxResolution.x = std::max(batch.maxResolution.x, region.resolution.x);
+                    batch.maxResolution.y = std::max(batch.maxResolution.y, region.resolution.y);
+                }
+
+                regionBuffer->unmap();
+
+                // Descriptor sets are only created when more batches are recorded than ever before and are otherwise recycled.
+                while (descriptorReinterpretSetsCount >= descriptorReinterpretSets.size()) {
+                    descriptorReinterpretSets.emplace_back(std::make_unique<ReinterpretDescriptorSet>(renderWorker->device));
+                }
+
+                std::unique_ptr<ReinterpretDescriptorSet> &reinterpretSet = descriptorReinterpretSets[descriptorReinterpretSetsCount];
+                descriptorReinterpretSetsCount++;
+                reinterpretSet->setTexture(reinterpretSet->gInputColor, groupDispatch.srcTexture, RenderTextureLayout::SHADER_READ);
+                reinterpretSet->setTexture(reinterpretSet->gInputTLUT, groupDispatch.tlutTexture, RenderTextureLayout::SHADER_READ);
+                reinterpretSet->setTexture(reinterpretSet->gOutput, batch.dstTexture, RenderTextureLayout::GENERAL);
+                reinterpretSet->setBuffer(reinterpretSet->gRegions, regionBuffer, RenderBufferStructuredView(sizeof(interop::FbReinterpretRegion)));
+                batch.descriptorSet = reinterpretSet->get();
+                cmdListReinterpretations.cmdListBatches.emplace_back(batch);
+
+                reinterpretRegionCursor += regionCount;
+                batchStart += regionCount;
+            }
+
+            groupStart = groupEnd;
+        }
+    }
+
     bool FramebufferManager::makeFramebufferTile(Framebuffer *fb, uint32_t addressStart, uint32_t addressEnd, uint32_t lineWidth, uint32_t tileHeight, FramebufferTile &outTile, bool RGBA32) {
         assert(fb != nullptr);
 
@@ -502,7 +586,7 @@ namespace RT64 {
         return op;
     }
 
-    void FramebufferManager::insertRegionsTMEM(uint32_t addressStart, uint32_t tmemStart, uint32_t tmemWords, uint32_t tmemMask, bool RGBA32, bool syncRequired, std::vector<RegionIterator> *resultRegions) {
+    void FramebufferManager::insertRegionsTMEM(uint32_t addressStart, uint32_t tmemStart, uint32_t tmemWords, uint32_t tmemMask, bool RGBA32, bool syncRequired, std::vector<uint32_t> *resultRegions) {
         if (resultRegions != nullptr) {
             resultRegions->clear();
         }
@@ -538,14 +622,16 @@ namespace RT64 {
                     wordsLeft = 0;
                 }
 
-                activeRegionsTMEM.push_front(newRegion);
+                activeRegionsTMEM.push_back(newRegion);
 
                 if (resultRegions != nullptr) {
-                    resultRegions->push_back(activeRegionsTMEM.begin());
+                    resultRegions->push_back(uint32_t(activeRegionsTMEM.size() - 1));
                 }
             }
         };
 
+        regionLookupTMEMDirty = true;
+
         insertRegions(false);
 
         if (RGBA32) {
@@ -567,6 +653,7 @@ namespace RT64 {
         else {
             auto it = activeRegionsTMEM.begin();
             const uint32_t tmemEnd = tmemStart + tmemWords;
+            splitRegionsTMEM.clear();
             while (it != activeRegionsTMEM.end()) {
                 if ((it->tmemStart < tmemEnd) && (it->tmemEnd > tmemStart)) {
                     // Region is fully contained within the discard region. Erase the region.
@@ -592,25 +679,49 @@ namespace RT64 {
                         if (it->tmemEnd != tmemEnd) {
                             RegionTMEM newRegion = *it;
                             newRegion.tmemStart = tmemEnd;
-                            activeRegionsTMEM.push_back(newRegion);
+                            splitRegionsTMEM.push_back(newRegion);
                         }
 
                         it->tmemEnd = tmemStart;
                     }
 
-                    // Region is empty, erase it.
-                    if (it->tmemStart == it->tmemEnd) {
-                        it = activeRegionsTMEM.erase(it);
-                    }
-                    else {
-                        it++;
-                    }
-                }
-                else {
-                    it++;
+                    regionLookupTMEMDirty = true;
                 }
+
+                it++;
+            }
+
+            // Erase all the regions that are empty.
+            auto removeIt = std::remove_if(activeRegionsTMEM.begin(), activeRegionsTMEM.end(), [](const RegionTMEM &region) {
+                return (region.tmemStart == region.tmemEnd);
+            });
+
+            activeRegionsTMEM.erase(removeIt, activeRegionsTMEM.end());
+
+            // The regions that were split off are inserted as the oldest ones. They keep the order of the regions they were split from,
+            // so the later uploads still take priority over the earlier ones.
+            if (!splitRegionsTMEM.empty()) {
+                activeRegionsTMEM.insert(activeRegionsTMEM.begin(), splitRegionsTMEM.begin(), splitRegionsTMEM.end());
+            }
+        }
+    }
+
+    void FramebufferManager::updateRegionLookupTMEM() {
+        if (!regionLookupTMEMDirty) {
+            return;
+        }
+
+        // Fill the lookup from the oldest to the newest region so the newest ones overwrite the words they cover.
+        regionLookupTMEM.assign(RDP_TMEM_WORDS, -1);
+        for (uint32_t r = 0; r < activeRegionsTMEM.size(); r++) {
+            const RegionTMEM &region = activeRegionsTMEM[r];
+            const uint32_t wordEnd = std::min(region.tmemEnd, uint32_t(RDP_TMEM_WORDS));
+            for (uint32_t w = region.tmemStart; w < wordEnd; w++) {
+                regionLookupTMEM[w] = int32_t(r);
             }
         }
+
+        regionLookupTMEMDirty = false;
     }
 
     FramebufferManager::CheckCopyResult FramebufferManager::checkTileCopyTMEM(uint32_t tmem, uint32_t lineWidth, uint8_t siz, uint8_t fmt, uint16_t uls) {
@@ -620,8 +731,19 @@ namespace RT64 {
         }
 
         CheckCopyResult result;
-        auto it = activeRegionsTMEM.begin();
-        while (it != activeRegionsTMEM.end()) {
+        if (tmem >= RDP_TMEM_WORDS) {
+            return result;
+        }
+
+        // Start from the newest region that covers the address, as none of the newer ones can match it.
+        updateRegionLookupTMEM();
+        const int32_t regionIndex = regionLookupTMEM[tmem];
+        if (regionIndex < 0) {
+            return result;
+        }
+
+        auto it = std::make_reverse_iterator(activeRegionsTMEM.begin() + regionIndex + 1);
+        while (it != activeRegionsTMEM.rend()) {
             if ((tmem >= it->tmemStart) && (tmem < it->tmemEnd)) {
                 if (it->syncRequired) {
                     result.syncRequired = true;
@@ -688,7 +810,7 @@ namespace RT64 {
                         const uint32_t TMEMUpper = RDP_TMEM_WORDS >> 1;
                         auto searchIt = activeRegionsTMEM.begin();
                         while (searchIt != activeRegionsTMEM.end()) {
-                            if ((searchIt != it) &&
+                            if ((&(*searchIt) != &(*it)) &&
                                 (searchIt->tileCopyId == it->tileCopyId) &&
                                 (searchIt->tmemStart == (it->tmemStart + TMEMUpper)) &&
                                 (searchIt->tmemEnd == (it->tmemEnd + TMEMUpper)))
@@ -765,6 +887,38 @@ namespace RT64 {
         return newId;
     }
 
+    void FramebufferManager::allocateTileCopy(RenderWorker *renderWorker, TileCopy &tileCopy, uint32_t width, uint32_t height, bool reinterpretation, bool usesHDR) {
+        // The current rect can be kept as long as it's big enough and it's stored in the right set of atlases.
+        const bool sufficientSize = (tileCopy.textureWidth >= width) && (tileCopy.textureHeight >= height);
+        if ((tileCopy.atlas != nullptr) && sufficientSize && (tileCopy.reinterpretation == reinterpretation)) {
+            return;
+        }
+
+        releaseTileCopy(tileCopy);
+
+        uint32_t rectWidth = width;
+        uint32_t rectHeight = height;
+        fixSizeToMultiple(rectWidth, rectHeight);
+
+        TileCopyAtlasSet &atlasSet = reinterpretation ? reinterpretAtlases : copyAtlases;
+        tileCopy.atlas = atlasSet.allocate(renderWorker->device, rectWidth, rectHeight, RenderTarget::colorBufferFormat(usesHDR), tileCopy.atlasRect);
+        tileCopy.textureWidth = rectWidth;
+        tileCopy.textureHeight = rectHeight;
+        tileCopy.reinterpretation = reinterpretation;
+    }
+
+    void FramebufferManager::releaseTileCopy(TileCopy &tileCopy) {
+        if (tileCopy.atlas != nullptr) {
+            TileCopyAtlasSet &atlasSet = tileCopy.reinterpretation ? reinterpretAtlases : copyAtlases;
+            atlasSet.release(tileCopy.atlas, tileCopy.atlasRect);
+            tileCopy.atlas = nullptr;
+        }
+
+        tileCopy.atlasRect = TileCopyAtlas::Rect();
+        tileCopy.textureWidth = 0;
+        tileCopy.textureHeight = 0;
+    }
+
     void FramebufferManager::storeRAM(FramebufferStorage &fbStorage, const uint8_t *RDRAM, uint32_t fbPairIndex) {
         assert(RDRAM != nullptr);
 
@@ -776,12 +930,19 @@ namespace RT64 {
         }
     }
 
-    void FramebufferManager::checkRAM(const uint8_t *RDRAM, std::vector<Framebuffer *> &differentFbs, bool updateHashes) {
+    void FramebufferManager::checkRAM(const uint8_t *RDRAM, std::vector<Framebuffer *> &differentFbs, bool updateHashes, const RDRAMPages *dirtyPages) {
         assert(RDRAM != nullptr);
 
         differentFbs.clear();
         auto it = framebuffers.begin();
         while (it != framebuffers.end()) {
+            // Framebuffers that weren't written to since they were last hashed can be skipped.
+            const bool hashedBytesMatch = (it->second.RAMHashBytes == it->second.RAMBytes);
+            if ((dirtyPages != nullptr) && hashedBytesMatch && !dirtyPages->test(it->first, it->second.RAMBytes)) {
+                it++;
+                continue;
+            }
+
             const uint8_t *fbRAM = &RDRAM[it->first];
             uint64_t currentHash = XXH3_64bits(fbRAM, it->second.RAMBytes);
             if (currentHash != it->second.RAMHash) {
@@ -792,6 +953,10 @@ namespace RT64 {
                 }
             }
 
+            if (updateHashes) {
+                it->second.RAMHashBytes = it->second.RAMBytes;
+            }
+
             it++;
         }
     }
@@ -809,13 +974,35 @@ namespace RT64 {
             Framebuffer *fb = differentFbs[i];
             const uint8_t *fbRAM = &RDRAM[fb->addressStart];
             const FramebufferChange::Type fbChangeType = (fb->lastWriteFmt == G_IM_FMT_DEPTH) ? FramebufferChange::Type::Depth : FramebufferChange::Type::Color;
-            FramebufferChange &fbChange = fbChangePool.use(renderWorker, fbChangeType, fb->width, fb->height, shaderLibrary->usesHDR);
-            const uint32_t DifferenceFractionNum = 1;
-            const uint32_t DifferenceFractionDiv = 4;
-            const uint32_t differentPixels = fb->copyRAMToNativeAndChanges(renderWorker, fbChange, fbRAM, 0, fb->height, fb->lastWriteFmt, false, shaderLibrary);
-            const uint32_t differentBytes = differentPixels << fb->siz >> 1;
+
+            // Only the blocks of rows that were modified since the framebuffer was last hashed need to be uploaded. The entire
+            // framebuffer is uploaded instead if the block hashes or the last read can't be used to determine what was modified.
+            uint32_t rowStart = 0;
+            uint32_t rowCount = fb->height;
+            uint32_t changedBlockBytes = 0;
+            const bool blocksChecked = fb->checkRAMBlocks(fbRAM, rowStart, rowCount, changedBlockBytes);
+            const bool uploadRows = blocksChecked && (rowCount > 0) && (rowCount < fb->height) && fb->nativeTarget.canCopyRowsFromRAM(fb->width, fb->height, fb->siz);
+            if (!uploadRows) {
+                rowStart = 0;
+                rowCount = fb->height;
+            }
+
+            FramebufferChange &fbChange = fbChangePool.use(renderWorker, fbChangeType, fb->width, rowCount, shaderLibrary->usesHDR);
+            uint32_t differentBytes = 0;
+            if (uploadRows) {
+                fb->copyRAMRowsToNativeAndChanges(renderWorker, fbChange, fbRAM, rowStart, rowCount, fb->lastWriteFmt, shaderLibrary);
+                differentBytes = changedBlockBytes;
+            }
+            else {
+                const uint32_t differentPixels = fb->copyRAMToNativeAndChanges(renderWorker, fbChange, fbRAM, 0, fb->height, fb->lastWriteFmt, false, shaderLibrary);
+                differentBytes = differentPixels << fb->siz >> 1;
+            }
+
+            uploadedBytes += fb->imageRowBytes(fb->width) * rowCount;
             fb->modifiedBytes += differentBytes;
 
+            const uint32_t DifferenceFractionNum = 1;
+            const uint32_t DifferenceFractionDiv = 4;
             const uint32_t differentBytesLimit = (fb->RAMBytes * DifferenceFractionNum) / DifferenceFractionDiv;
             const bool discardFb = canDiscard && (fb->modifiedBytes >= differentBytesLimit);
             if (discardFb) {
@@ -826,6 +1013,8 @@ namespace RT64 {
                 changesOp.type = FramebufferOperation::Type::WriteChanges;
                 changesOp.writeChanges.address = fb->addressStart;
                 changesOp.writeChanges.id = fbChange.id;
+                changesOp.writeChanges.rowStart = rowStart;
+                changesOp.writeChanges.rowCount = rowCount;
                 fbOps.emplace_back(changesOp);
             }
 
@@ -846,7 +1035,7 @@ namespace RT64 {
         auto it = framebuffers.begin();
         while (it != framebuffers.end()) {
             if ((it->second.maxHeight > 0) && (it->second.RAMBytes > 0)) {
-                it->second.RAMHash = XXH3_64bits(&RDRAM[it->first], it->second.RAMBytes);
+                it->second.hashRAM(&RDRAM[it->first]);
             }
 
             it++;
@@ -856,8 +1045,8 @@ namespace RT64 {
     void FramebufferManager::changeRAM(Framebuffer *changedFb, uint32_t addressStart, uint32_t addressEnd) {
         assert(changedFb != nullptr);
 
-        auto it = framebuffers.begin();
-        while (it != framebuffers.end()) {
+        auto it = findFirstOverlapping(addressStart);
+        while ((it != framebuffers.end()) && (it->first < addressEnd)) {
             if ((&it->second != changedFb) && (it->second.overlaps(addressStart, addressEnd))) {
                 it->second.rdramChanged = true;
             }
@@ -868,6 +1057,8 @@ namespace RT64 {
 
     void FramebufferManager::resetOperations() {
         descriptorReinterpretSetsCount = 0;
+        reinterpretRegionBuffersCount = 0;
+        reinterpretRegionCursor = 0;
     }
 
     void FramebufferManager::setupOperations(RenderWorker *renderWorker, const std::vector<FramebufferOperation> &operations, hlslpp::float2 resolutionScale, RenderTargetManager &targetManager, std::unordered_set<RenderTarget *> *resizedTargets) {
@@ -934,9 +1125,19 @@ namespace RT64 {
             tileCopyBeforeBarriers.clear();
             tileCopyAfterBarriers.clear();
 
-            for (const CommandListCopyRegion &copy : cmdListCopies.cmdListCopyRegions) {
-                tileCopyBeforeBarriers.push_back(RenderTextureBarrier(copy.dstTexture, RenderTextureLayout::COLOR_WRITE));
-                tileCopyAfterBarriers.push_back(RenderTextureBarrier(copy.dstTexture, RenderTextureLayout::SHADER_READ));
+            // Group the regions by their atlas so every atlas is only transitioned and set as the framebuffer once.
+            std::vector<CommandListCopyRegion> &copyRegions = cmdListCopies.cmdListCopyRegions;
+            std::stable_sort(copyRegions.begin(), copyRegions.end(), [](const CommandListCopyRegion &a, const CommandListCopyRegion &b) {
+                return std::less<TileCopyAtlas *>()(a.dstAtlas, b.dstAtlas);
+            });
+
+            const TileCopyAtlas *lastAtlas = nullptr;
+            for (const CommandListCopyRegion &copy : copyRegions) {
+                if (copy.dstAtlas != lastAtlas) {
+                    tileCopyBeforeBarriers.push_back(RenderTextureBarrier(copy.dstAtlas->texture.get(), RenderTextureLayout::COLOR_WRITE));
+                    tileCopyAfterBarriers.push_back(RenderTextureBarrier(copy.dstAtlas->texture.get(), RenderTextureLayout::SHADER_READ));
+                    lastAtlas = copy.dstAtlas;
+                }
             }
 
             for (RenderTarget *renderTarget : cmdListCopies.copyRegionTargets) {
@@ -954,10 +1155,18 @@ namespace RT64 {
             renderWorker->commandList->setVertexBuffers(0, nullptr, 0, nullptr);
 
             RenderDescriptorSet *lastDescriptorSet = nullptr;
-            for (const CommandListCopyRegion &copy : cmdListCopies.cmdListCopyRegions) {
-                renderWorker->commandList->setFramebuffer(copy.dstFramebuffer);
-                renderWorker->commandList->setViewports(RenderViewport(0.0f, 0.0f, copy.pushConstants.uvScale.x, copy.pushConstants.uvScale.y));
-                renderWorker->commandList->setScissors(RenderRect(0, 0, std::lround(copy.pushConstants.uvScale.x), std::lround(copy.pushConstants.uvScale.y)));
+            lastAtlas = nullptr;
+            for (const CommandListCopyRegion &copy : copyRegions) {
+                if (copy.dstAtlas != lastAtlas) {
+                    renderWorker->commandList->setFramebuffer(copy.dstAtlas->framebuffer.get());
+                    lastAtlas = copy.dstAtlas;
+                }
+
+                const TileCopyAtlas::Rect &r = copy.dstRect;
+                const int32_t copyWidth = std::lround(copy.pushConstants.uvScale.x);
+                const int32_t copyHeight = std::lround(copy.pushConstants.uvScale.y);
+                renderWorker->commandList->setViewports(RenderViewport(float(r.x), float(r.y), copy.pushConstants.uvScale.x, copy.pushConstants.uvScale.y));
+                renderWorker->commandList->setScissors(RenderRect(r.x, r.y, r.x + copyWidth, r.y + copyHeight));
                 if (copy.descriptorSet != lastDescriptorSet) {
                     renderWorker->commandList->setGraphicsDescriptorSet(copy.descriptorSet, 0);
                     lastDescriptorSet = copy.descriptorSet;
@@ -972,29 +1181,50 @@ namespace RT64 {
 
         const bool reinterpretTiles = !cmdListReinterpretations.cmdListDispatches.empty();
         if (reinterpretTiles) {
-            tileCopyBeforeBarriers.clear();
-            tileCopyAfterBarriers.clear();
+            reinterpretTileBatches(renderWorker, cmdListReinterpretations);
 
-            for (const CommandListReinterpretDispatch &dispatch : cmdListReinterpretations.cmdListDispatches) {
-                tileCopyBeforeBarriers.push_back(RenderTextureBarrier(dispatch.dstTexture, RenderTextureLayout::GENERAL));
-                tileCopyAfterBarriers.push_back(RenderTextureBarrier(dispatch.dstTexture, RenderTextureLayout::SHADER_READ));
-            }
+            // Every region of a batch is assigned to one layer of the dispatch. Threads outside of the region's resolution are discarded.
+            const ShaderRecord &shaderRecord = shaderLibrary->fbReinterpret;
+            const std::vector<CommandListReinterpretBatch> &batches = cmdListReinterpretations.cmdListBatches;
+            size_t segmentStart = 0;
+            while (segmentStart < batches.size()) {
+                size_t segmentEnd = segmentStart + 1;
+                while ((segmentEnd < batches.size()) && (batches[segmentEnd].segmentIndex == batches[segmentStart].segmentIndex)) {
+                    segmentEnd++;
+                }
 
-            renderWorker->commandList->barriers(RenderBarrierStage::COMPUTE, tileCopyBeforeBarriers);
+                // Each segment must be done writing to its atlases before the next one can read from them.
+                tileCopyBeforeBarriers.clear();
+                tileCopyAfterBarriers.clear();
 
-            const ShaderRecord &shaderRecord = shaderLibrary->fbReinterpret;
-            renderWorker->commandList->setPipeline(shaderRecord.pipeline.get());
-            renderWorker->commandList->setComputePipelineLayout(shaderRecord.pipelineLayout.get());
-            for (const CommandListReinterpretDispatch &dispatch : cmdListReinterpretations.cmdListDispatches) {
-                const interop::uint2 &res = dispatch.reinterpretCB.resolution;
-                const uint32_t dispatchX = (res.x + FB_COMMON_WORKGROUP_SIZE - 1) / FB_COMMON_WORKGROUP_SIZE;
-                const uint32_t dispatchY = (res.y + FB_COMMON_WORKGROUP_SIZE - 1) / FB_COMMON_WORKGROUP_SIZE;
-                renderWorker->commandList->setComputeDescriptorSet(dispatch.descriptorSet, 0);
-                renderWorker->commandList->setComputePushConstants(0, &dispatch.reinterpretCB);
-                renderWorker->commandList->dispatch(dispatchX, dispatchY, 1);
-            }
+                for (size_t i = segmentStart; i < segmentEnd; i++) {
+                    const CommandListReinterpretBatch &batch = batches[i];
+                    auto barrierIt = std::find_if(tileCopyBeforeBarriers.begin(), tileCopyBeforeBarriers.end(), [&batch](const RenderTextureBarrier &barrier) {
+                        return barrier.texture == batch.dstTexture;
+                    });
 
-            renderWorker->commandList->barriers(RenderBarrierStage::GRAPHICS_AND_COMPUTE, tileCopyAfterBarriers);
+                    if (barrierIt == tileCopyBeforeBarriers.end()) {
+                        tileCopyBeforeBarriers.push_back(RenderTextureBarrier(batch.dstTexture, RenderTextureLayout::GENERAL));
+                        tileCopyAfterBarriers.push_back(RenderTextureBarrier(batch.dstTexture, RenderTextureLayout::SHADER_READ));
+                    }
+                }
+
+                renderWorker->commandList->barriers(RenderBarrierStage::COMPUTE, tileCopyBeforeBarriers);
+                renderWorker->commandList->setPipeline(shaderRecord.pipeline.get());
+                renderWorker->commandList->setComputePipelineLayout(shaderRecord.pipelineLayout.get());
+                for (size_t i = segmentStart; i < segmentEnd; i++) {
+                    const CommandListReinterpretBatch &batch = batches[i];
+                    const interop::uint2 &res = batch.maxResolution;
+                    const uint32_t dispatchX = (res.x + FB_COMMON_WORKGROUP_SIZE - 1) / FB_COMMON_WORKGROUP_SIZE;
+                    const uint32_t dispatchY = (res.y + FB_COMMON_WORKGROUP_SIZE - 1) / FB_COMMON_WORKGROUP_SIZE;
+                    renderWorker->commandList->setComputeDescriptorSet(batch.descriptorSet, 0);
+                    renderWorker->commandList->setComputePushConstants(0, &batch.reinterpretCB);
+                    renderWorker->commandList->dispatch(dispatchX, dispatchY, batch.regionCount);
+                }
+
+                renderWorker->commandList->barriers(RenderBarrierStage::GRAPHICS_AND_COMPUTE, tileCopyAfterBarriers);
+                segmentStart = segmentEnd;
+            }
         }
     }
 
@@ -1008,16 +1238,24 @@ namespace RT64 {
     }
 
     void FramebufferManager::performDiscards(const std::vector<uint32_t> &discards) {
+        if (discards.empty()) {
+            return;
+        }
+
         for (uint32_t address : discards) {
             auto it = framebuffers.find(address);
             if (it != framebuffers.end()) {
                 framebuffers.erase(it);
             }
         }
+
+        updateMaxFramebufferBytes();
     }
 
     void FramebufferManager::destroyAllTileCopies() {
         tileCopies.clear();
+        copyAtlases.destroyAll();
+        reinterpretAtlases.destroyAll();
     }
 
     uint64_t FramebufferManager::nextWriteTimestamp() {
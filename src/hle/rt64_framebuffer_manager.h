@@ -20,6 +20,8 @@
 #include "rt64_framebuffer.h"
 #include "rt64_framebuffer_changes.h"
 #include "rt64_framebuffer_storage.h"
+#include "rt64_rdram_tracker.h"
+#include "rt64_tile_copy_atlas.h"
 
 namespace RT64 {
     struct FramebufferOperation {
@@ -42,6 +44,8 @@ namespace RT64 {
             struct {
                 uint32_t address;
                 uint64_t id;
+                uint32_t rowStart;
+                uint32_t rowCount;
             } writeChanges;
 
             struct {
@@ -74,9 +78,13 @@ namespace RT64 {
             bool syncRequired;
         };
 
+        // Tile copies don't own a texture. They're stored in a rect of an atlas instead, and the samplers offset the texels by the
+        // rect's origin. The texture width and height store the size of the rect.
         struct TileCopy {
             uint64_t id = 0;
-            std::unique_ptr<RenderTexture> texture;
+            TileCopyAtlas *atlas = nullptr;
+            TileCopyAtlas::Rect atlasRect;
+            bool reinterpretation = false;
             uint32_t textureWidth = 0;
             uint32_t textureHeight = 0;
             uint32_t address = 0;
@@ -95,7 +103,6 @@ namespace RT64 {
             bool readColorFromStorage = false;
             bool readDepthFromStorage = false;
             bool ignore = false;
-            std::unique_ptr<RenderFramebuffer> framebuffer;
         };
 
         struct CheckCopyResult {
@@ -117,8 +124,8 @@ namespace RT64 {
 
         struct CommandListCopyRegion {
             RenderTexture *srcTexture;
-            RenderTexture *dstTexture;
-            RenderFramebuffer *dstFramebuffer;
+            TileCopyAtlas *dstAtlas;
+            TileCopyAtlas::Rect dstRect;
             RenderDescriptorSet *descriptorSet;
             interop::TextureCopyCB pushConstants;
         };
@@ -135,8 +142,18 @@ namespace RT64 {
 
         struct CommandListReinterpretDispatch {
             RenderTexture *srcTexture;
+            TileCopyAtlas *dstAtlas;
+            RenderTexture *tlutTexture;
+            interop::FbReinterpretCB reinterpretCB;
+            interop::FbReinterpretRegion region;
+        };
+
+        struct CommandListReinterpretBatch {
             RenderTexture *dstTexture;
             interop::FbReinterpretCB reinterpretCB;
+            interop::uint2 maxResolution;
+            uint32_t regionCount;
+            uint32_t segmentIndex;
             RenderDescriptorSet *descriptorSet;
         };
 
@@ -144,32 +161,54 @@ namespace RT64 {
 
         struct CommandListReinterpretations {
             std::vector<CommandListReinterpretDispatch> cmdListDispatches;
+            std::vector<CommandListReinterpretBatch> cmdListBatches;
 
             void clear() {
                 cmdListDispatches.clear();
+                cmdListBatches.clear();
             }
         };
 
-        std::unordered_map<uint32_t, Framebuffer> framebuffers;
+        // Sorted by their starting address so range queries only need to visit the framebuffers that can reach the range. Framebuffers
+        // are never bigger than the largest size tracked, which determines how far back from the range the search must start.
+        std::map<uint32_t, Framebuffer> framebuffers;
+        uint32_t maxFramebufferBytes = 0;
         std::unordered_map<uint64_t, TileCopy> tileCopies;
+        // Reinterpreted tiles are written to by compute shaders while the tile copies they read from must remain readable, so they
+        // can't be stored in the same atlases.
+        TileCopyAtlasSet copyAtlases;
+        TileCopyAtlasSet reinterpretAtlases;
         std::unique_ptr<RenderTexture> dummyTLUTTexture;
         std::vector<std::unique_ptr<ReinterpretDescriptorSet>> descriptorReinterpretSets;
         uint32_t descriptorReinterpretSetsCount = 0;
-        std::list<RegionTMEM> activeRegionsTMEM;
+        // Regions can't be overwritten until the command list is done, so a new buffer is used whenever the current one runs out of space.
+        static const uint32_t ReinterpretRegionsPerBuffer = 256;
+        std::vector<std::unique_ptr<RenderBuffer>> reinterpretRegionBuffers;
+        uint32_t reinterpretRegionBuffersCount = 0;
+        uint32_t reinterpretRegionCursor = 0;
+        // Stored from oldest to newest, as newer regions take priority. The lookup stores the index of the newest region that covers
+        // each word of TMEM and is only rebuilt when it's needed after the regions were modified.
+        std::vector<RegionTMEM> activeRegionsTMEM;
+        std::vector<RegionTMEM> splitRegionsTMEM;
+        std::vector<int32_t> regionLookupTMEM;
+        bool regionLookupTMEMDirty = true;
         FramebufferChangePool scratchChangePool;
         uint64_t usedTimestamp = 0;
         uint64_t writeTimestamp = 0;
-
-        typedef std::list<RegionTMEM>::iterator RegionIterator;
+        uint32_t uploadedBytes = 0;
 
         FramebufferManager();
         ~FramebufferManager();
         Framebuffer &get(uint32_t address, uint8_t siz, uint32_t width, uint32_t height);
         Framebuffer *find(uint32_t address) const;
         Framebuffer *findMostRecentContaining(uint32_t addressStart, uint32_t addressEnd);
+        std::map<uint32_t, Framebuffer>::iterator findFirstOverlapping(uint32_t addressStart);
+        void updateMaxFramebufferBytes();
         void writeChanges(RenderWorker *renderWorker, const FramebufferChangePool &fbChangePool, const FramebufferOperation &op, RenderTargetManager &targetManager, const ShaderLibrary *shaderLibrary);
         void clearUsedTileCopies();
         uint64_t findTileCopyId(uint32_t width, uint32_t height);
+        void allocateTileCopy(RenderWorker *renderWorker, TileCopy &tileCopy, uint32_t width, uint32_t height, bool reinterpretation, bool usesHDR);
+        void releaseTileCopy(TileCopy &tileCopy);
         void createTileCopySetup(RenderWorker *renderWorker, const FramebufferOperation &op, hlslpp::float2 resolutionScale, RenderTargetManager &targetManager, std::unordered_set<RenderTarget *> *resizedTargets);
         void createTileCopyRecord(RenderWorker *renderWorker, const FramebufferOperation &op, const FramebufferStorage &fbStorage, RenderTargetManager &targetManager, 
             hlslpp::float2 resolutionScale, uint32_t maxFbPairIndex, CommandListCopies &cmdListCopies, const ShaderLibrary *shaderLibrary);
@@ -178,6 +217,8 @@ namespace RT64 {
         void reinterpretTileRecord(RenderWorker *renderWorker, const FramebufferOperation &op, TextureCache &textureCache, hlslpp::float2 resolutionScale,
             uint64_t submissionFrame, bool usesHDR, CommandListReinterpretations &cmdListReinterpretations);
 
+        void reinterpretTileBatches(RenderWorker *renderWorker, CommandListReinterpretations &cmdListReinterpretations);
+
         bool makeFramebufferTile(Framebuffer *fb, uint32_t addressStart, uint32_t addressEnd, uint32_t lineWidth, uint32_t tileHeight, FramebufferTile &outTile, bool RGBA32);
 
         FramebufferOperation makeTileCopyTMEM(uint64_t dstTileId, const FramebufferTile &fbTile);
@@ -186,10 +227,11 @@ namespace RT64 {
             interop::uint2 texelShift, interop::uint2 texelMask, uint64_t tlutHash, uint32_t tlutFormat);
 
         CheckCopyResult checkTileCopyTMEM(uint32_t tmem, uint32_t lineWidth, uint8_t siz, uint8_t fmt, uint16_t uls);
-        void insertRegionsTMEM(uint32_t addressStart, uint32_t tmemStart, uint32_t tmemWords, uint32_t tmemMask, bool RGBA32, bool syncRequired, std::vector<RegionIterator> *resultRegions);
+        void insertRegionsTMEM(uint32_t addressStart, uint32_t tmemStart, uint32_t tmemWords, uint32_t tmemMask, bool RGBA32, bool syncRequired, std::vector<uint32_t> *resultRegions);
         void discardRegionsTMEM(uint32_t tmemStart, uint32_t tmemWords, uint32_t tmemMask);
+        void updateRegionLookupTMEM();
         void storeRAM(FramebufferStorage &fbStorage, const uint8_t *RDRAM, uint32_t fbPairIndex);
-        void checkRAM(const uint8_t *RDRAM, std::vector<Framebuffer *> &differentFbs, bool updateHashes);
+        void checkRAM(const uint8_t *RDRAM, std::vector<Framebuffer *> &differentFbs, bool updateHashes, const RDRAMPages *dirtyPages = nullptr);
         void uploadRAM(RenderWorker *renderWorker, Framebuffer **differentFbs, size_t differentFbsCount, FramebufferChangePool &fbChangePool, const uint8_t *RDRAM, bool canDiscard, std::vector<FramebufferOperation> &fbOps,
             std::vector<uint32_t> &fbDiscards, const ShaderLibrary *shaderLibrary);
 
@@ -4,9 +4,13 @@
 
 #include "rt64_framebuffer_storage.h"
 
+#include <algorithm>
 #include <cassert>
 #include <cstring>
 
+#include "common/rt64_copy_hash.h"
+#include "xxHash/xxh3.h"
+
 namespace RT64 {
     // FramebufferStorage
 
@@ -16,46 +20,114 @@ namespace RT64 {
 
     void FramebufferStorage::reset() {
         rdramUsed = 0;
+        blockVector.clear();
         handleVector.clear();
+        handleIndexMap.clear();
+        lastHandleIndexMap.clear();
     }
 
     void FramebufferStorage::store(uint32_t fbPairIndex, uint32_t address, const uint8_t *data, uint32_t size) {
-        uint32_t dstIndex = rdramUsed;
-        rdramUsed += size;
-        if (rdramUsed > rdramData.size()) {
-            const uint32_t newSize = (rdramUsed * 3) / 2;
-            rdramData.resize(newSize, 0);
+        // Find the previous snapshot of the same address and size to share the blocks that didn't change with.
+        const Handle *previousHandle = nullptr;
+        auto lastIt = lastHandleIndexMap.find(address);
+        if (lastIt != lastHandleIndexMap.end()) {
+            const Handle &lastHandle = handleVector[lastIt->second];
+            if (lastHandle.size == size) {
+                previousHandle = &lastHandle;
+            }
         }
 
-        memcpy(rdramData.data() + dstIndex, data, size);
-
         Handle handle;
         handle.fbPairIndex = fbPairIndex;
         handle.address = address;
-        handle.rdramIndex = dstIndex;
         handle.size = size;
-        handleVector.emplace_back(handle);
-    }
+        handle.blockStart = uint32_t(blockVector.size());
+        handle.blockCount = (size + BlockSize - 1) / BlockSize;
 
-    const FramebufferStorage::Handle *FramebufferStorage::get(uint32_t maxFbPairIndex, uint32_t address) const {
-        const FramebufferStorage::Handle *maxHandle = nullptr;
-        for (const auto &handle : handleVector) {
-            if (handle.fbPairIndex > maxFbPairIndex) {
-                continue;
+        const uint32_t previousBlockStart = (previousHandle != nullptr) ? previousHandle->blockStart : 0;
+        for (uint32_t b = 0; b < handle.blockCount; b++) {
+            const uint32_t blockOffset = b * BlockSize;
+            const uint32_t blockBytes = std::min(BlockSize, size - blockOffset);
+            if ((rdramUsed + blockBytes) > rdramData.size()) {
+                const uint32_t newSize = ((rdramUsed + blockBytes) * 3) / 2;
+                rdramData.resize(newSize, 0);
             }
 
-            if (handle.address != address) {
-                continue;
+            // Blocks with a previous snapshot are only hashed, as they're copied only when their contents changed. Blocks without
+            // one must always be copied, so they're copied and hashed in the same pass instead.
+            Block block;
+            if (previousHandle != nullptr) {
+                const Block &previousBlock = blockVector[previousBlockStart + b];
+                block.hash = XXH3_64bits(data + blockOffset, blockBytes);
+                if (previousBlock.hash == block.hash) {
+                    block.rdramIndex = previousBlock.rdramIndex;
+                }
+                else {
+                    block.rdramIndex = rdramUsed;
+                    memcpy(rdramData.data() + rdramUsed, data + blockOffset, blockBytes);
+                    rdramUsed += blockBytes;
+                }
             }
+            else {
+                block.rdramIndex = rdramUsed;
+                block.hash = CopyAndHash(rdramData.data() + rdramUsed, data + blockOffset, blockBytes);
+                rdramUsed += blockBytes;
+            }
+
+            blockVector.emplace_back(block);
+        }
+
+        const uint32_t handleIndex = uint32_t(handleVector.size());
+        handleVector.emplace_back(handle);
+        handleIndexMap[{ address, fbPairIndex }] = handleIndex;
+        lastHandleIndexMap[address] = handleIndex;
+    }
 
-            maxHandle = &handle;
+    const FramebufferStorage::Handle *FramebufferStorage::get(uint32_t maxFbPairIndex, uint32_t address) const {
+        // Find the handle with the highest pair index that doesn't go over the maximum for this address.
+        auto it = handleIndexMap.upper_bound({ address, maxFbPairIndex });
+        if (it == handleIndexMap.begin()) {
+            return nullptr;
+        }
+
+        it--;
+        if (it->first.first != address) {
+            return nullptr;
         }
 
-        return maxHandle;
+        return &handleVector[it->second];
     }
 
     const uint8_t *FramebufferStorage::getRDRAM(const Handle &handle) const {
-        assert((handle.rdramIndex + handle.size) <= rdramData.size());
-        return rdramData.data() + handle.rdramIndex;
+        assert((handle.blockStart + handle.blockCount) <= blockVector.size());
+
+        if (handle.blockCount == 0) {
+            return rdramData.data();
+        }
+
+        // The blocks can be returned directly if they were all stored contiguously.
+        const uint32_t firstIndex = blockVector[handle.blockStart].rdramIndex;
+        bool contiguous = true;
+        for (uint32_t b = 1; (b < handle.blockCount) && contiguous; b++) {
+            contiguous = (blockVector[handle.blockStart + b].rdramIndex == (firstIndex + b * BlockSize));
+        }
+
+        if (contiguous) {
+            assert((firstIndex + handle.size) <= rdramData.size());
+            return rdramData.data() + firstIndex;
+        }
+
+        // Assemble the blocks shared with other snapshots into a contiguous buffer otherwise.
+        thread_local std::vector<uint8_t> assembledData;
+        assembledData.resize(handle.size);
+        for (uint32_t b = 0; b < handle.blockCount; b++) {
+            const uint32_t blockOffset = b * BlockSize;
+            const uint32_t blockBytes = std::min(BlockSize, handle.size - blockOffset);
+            const Block &block = blockVector[handle.blockStart + b];
+            assert((block.rdramIndex + blockBytes) <= rdramData.size());
+            memcpy(assembledData.data() + blockOffset, rdramData.data() + block.rdramIndex, blockBytes);
+        }
+
+        return assembledData.data();
     }
-};
\ No newline at end of file
+};
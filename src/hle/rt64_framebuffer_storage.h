@@ -6,6 +6,10 @@
 // at the start of a frame. Sometimes it's necessary for the high resolution renderer
 // to reload the contents from RDRAM in case the resources get resized and discarded.
 // The storage is the resource it can use to fix that.
+//
+// The contents are stored in blocks. When the same address is stored again, only the
+// blocks that are different from the previous snapshot of that address are copied and
+// the rest are shared with it instead.
 
 #pragma once
 
@@ -15,21 +19,34 @@
 
 namespace RT64 {
     struct FramebufferStorage {
+        static const uint32_t BlockSize = 4096;
+
         struct Handle {
             uint32_t fbPairIndex;
             uint32_t address;
-            uint32_t rdramIndex;
             uint32_t size;
+            uint32_t blockStart;
+            uint32_t blockCount;
+        };
+
+        struct Block {
+            uint32_t rdramIndex;
+            uint64_t hash;
         };
 
         uint32_t rdramUsed;
         std::vector<uint8_t> rdramData;
+        std::vector<Block> blockVector;
         std::vector<Handle> handleVector;
+        std::map<std::pair<uint32_t, uint32_t>, uint32_t> handleIndexMap;
+        std::map<uint32_t, uint32_t> lastHandleIndexMap;
 
         FramebufferStorage();
         void reset();
         void store(uint32_t fbPairIndex, uint32_t address, const uint8_t *data, uint32_t size);
         const Handle *get(uint32_t maxFbPairIndex, uint32_t address) const;
+
+        // The pointer is only valid until the next time this function is called from the same thread.
         const uint8_t *getRDRAM(const Handle &handle) const;
     };
-};
\ No newline at end of file
+};
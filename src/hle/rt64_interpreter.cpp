@@ -166,6 +166,7 @@ namespace RT64 {
         state->checkRDRAM();
 
         // Run the command interpreter.
+        state->rsp->vertexCacheStats = RSP::VertexCacheStats();
         DisplayList *dl = dlStart;
         uint8_t opCode;
         GBIFunction func;
@@ -0,0 +1,161 @@
+//
+// RT64
+//
+
+#include "rt64_interpreter_thread.h"
+
+#include <algorithm>
+#include <cstring>
+
+#include "common/rt64_elapsed_timer.h"
+#include "common/rt64_thread.h"
+
+namespace RT64 {
+    // InterpreterThread
+
+    InterpreterThread::InterpreterThread(Interpreter *interpreter, State *state, uint8_t *coreRDRAM) {
+        assert(interpreter != nullptr);
+        assert(state != nullptr);
+        assert(coreRDRAM != nullptr);
+
+        this->interpreter = interpreter;
+        this->state = state;
+        this->coreRDRAM = coreRDRAM;
+
+        // The entire mirror must be copied the first time it's used.
+        mirrorRDRAM.resize(RDRAMSize);
+        mirrorDirtyPages.setAll();
+
+        running = true;
+        thread = new std::thread(&InterpreterThread::threadLoop, this);
+    }
+
+    InterpreterThread::~InterpreterThread() {
+        {
+            std::unique_lock<std::mutex> taskLock(taskMutex);
+            running = false;
+        }
+
+        taskCondition.notify_all();
+        thread->join();
+        delete thread;
+    }
+
+    void InterpreterThread::threadLoop() {
+        Thread::setCurrentThreadName("RT64 Interpreter");
+
+        Task task;
+        while (running) {
+            {
+                std::unique_lock<std::mutex> taskLock(taskMutex);
+                taskCondition.wait(taskLock, [this]() {
+                    return !running || taskPending;
+                });
+
+                if (!running) {
+                    break;
+                }
+
+                task = pendingTask;
+                taskPending = false;
+                taskRunning = true;
+            }
+
+            // Redirect the state to the mirror for the duration of the task. The state will only use the core's
+            // RDRAM again once the task is done, which guarantees any other API calls read from the right memory.
+            uint8_t *mirrorData = mirrorRDRAM.data();
+            DisplayList *dlStart = reinterpret_cast<DisplayList *>(&mirrorData[task.dlStartAddress]);
+            DisplayList *dlEnd = (task.dlEndAddress > 0) ? reinterpret_cast<DisplayList *>(&mirrorData[task.dlEndAddress]) : nullptr;
+            ElapsedTimer taskTimer;
+            state->RDRAM = mirrorData;
+            state->deferInterrupts = true;
+            state->addRDRAMDirtyPages(task.dirtyPages);
+
+            if (task.isHLE) {
+                interpreter->processDisplayLists(task.dlStartAddress, dlStart);
+            }
+            else {
+                interpreter->processRDPLists(task.dlStartAddress, dlStart, dlEnd);
+            }
+
+            state->deferInterrupts = false;
+            state->RDRAM = coreRDRAM;
+
+            {
+                std::unique_lock<std::mutex> taskLock(taskMutex);
+                lastTaskMilliseconds = taskTimer.elapsedMilliseconds();
+                taskRunning = false;
+            }
+
+            idleCondition.notify_all();
+        }
+    }
+
+    void InterpreterThread::markDirtyPages(const RDRAMPages &dirtyPages) {
+        // Every page collected by the emulator thread must be marked, even if the task runs synchronously, as the mirror will be out of date otherwise.
+        mirrorDirtyPages.add(dirtyPages);
+    }
+
+    void InterpreterThread::updateMirror() {
+        assert(idle() && "The mirror can't be updated while a task is using it.");
+
+        // Since the interpreter can reach any address through segments, vertices, matrices and textures, every page written to since
+        // the last task must be copied. Consecutive pages are merged into a single copy.
+        mirrorCopiedPages = 0;
+        uint32_t runStart = 0;
+        uint32_t runLength = 0;
+        for (uint32_t p = 0; p <= RDRAMPages::PageCount; p++) {
+            const bool pageDirty = (p < RDRAMPages::PageCount) && (mirrorDirtyPages.words[p / 64] & (1ULL << (p % 64)));
+            if (pageDirty) {
+                if (runLength == 0) {
+                    runStart = p;
+                }
+
+                runLength++;
+            }
+            else if (runLength > 0) {
+                const uint32_t copyOffset = runStart << RDRAMPages::PageShift;
+                const uint32_t copySize = std::min(runLength << RDRAMPages::PageShift, RDRAMSize - copyOffset);
+                memcpy(&mirrorRDRAM[copyOffset], &coreRDRAM[copyOffset], copySize);
+                mirrorCopiedPages += runLength;
+                runLength = 0;
+            }
+        }
+
+        mirrorDirtyPages.clear();
+    }
+
+    void InterpreterThread::submit(uint32_t dlStartAddress, uint32_t dlEndAddress, bool isHLE, const RDRAMPages &dirtyPages) {
+        // Only one task can be in flight at a time, as the interpreter must process them in order.
+        wait();
+
+        snapshotProfiler.reset();
+        snapshotProfiler.start();
+        updateMirror();
+        snapshotProfiler.end();
+        snapshotProfiler.log();
+
+        {
+            std::unique_lock<std::mutex> taskLock(taskMutex);
+            pendingTask.dlStartAddress = dlStartAddress;
+            pendingTask.dlEndAddress = dlEndAddress;
+            pendingTask.isHLE = isHLE;
+            pendingTask.dirtyPages = dirtyPages;
+            taskPending = true;
+        }
+
+        taskCondition.notify_all();
+    }
+
+    void InterpreterThread::wait() {
+        std::unique_lock<std::mutex> taskLock(taskMutex);
+        idleCondition.wait(taskLock, [this]() {
+            return !taskPending && !taskRunning;
+        });
+    }
+
+    bool InterpreterThread::idle() {
+        std::unique_lock<std::mutex> taskLock(taskMutex);
+        return !taskPending && !taskRunning;
+    }
+};
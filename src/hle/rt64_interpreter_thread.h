@@ -0,0 +1,55 @@
+//
+// RT64
+//
+
+#pragma once
+
+#include <atomic>
+#include <condition_variable>
+#include <mutex>
+#include <thread>
+
+#include "common/rt64_profiling_timer.h"
+
+#include "rt64_interpreter.h"
+#include "rt64_rdram_tracker.h"
+
+namespace RT64 {
+    // Runs the interpreter on a dedicated thread so the emulator thread only needs to update a mirror of RDRAM and hand off the task.
+    // Only the pages written to since the last task are copied to the mirror. The State must only be accessed from other threads
+    // after calling wait().
+    struct InterpreterThread {
+        struct Task {
+            uint32_t dlStartAddress = 0;
+            uint32_t dlEndAddress = 0;
+            bool isHLE = false;
+            RDRAMPages dirtyPages;
+        };
+
+        Interpreter *interpreter;
+        State *state;
+        uint8_t *coreRDRAM;
+        std::vector<uint8_t> mirrorRDRAM;
+        RDRAMPages mirrorDirtyPages;
+        uint32_t mirrorCopiedPages = 0;
+        std::thread *thread = nullptr;
+        std::atomic<bool> running = false;
+        std::mutex taskMutex;
+        std::condition_variable taskCondition;
+        std::condition_variable idleCondition;
+        Task pendingTask;
+        bool taskPending = false;
+        bool taskRunning = false;
+        double lastTaskMilliseconds = 0.0;
+        ProfilingTimer snapshotProfiler = ProfilingTimer(120);
+
+        InterpreterThread(Interpreter *interpreter, State *state, uint8_t *coreRDRAM);
+        ~InterpreterThread();
+        void threadLoop();
+        void markDirtyPages(const RDRAMPages &dirtyPages);
+        void updateMirror();
+        void submit(uint32_t dlStartAddress, uint32_t dlEndAddress, bool isHLE, const RDRAMPages &dirtyPages);
+        void wait();
+        bool idle();
+    };
+};
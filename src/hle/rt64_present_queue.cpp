@@ -123,11 +123,12 @@ namespace RT64 {
         // modified while the present queue is retrieving the framebuffer or the target. These can
         // likely be solved by locking the access to the managers during modification.
         
-        // Perform any external write operations indicated by the event.
+        // Perform any external write operations indicated by the event. None of the submissions before the one that draws to the
+        // swap chain need to be waited on, as they're all executed in order by the same queue and waited on before the end.
         if (!present.fbOperations.empty()) {
             const std::scoped_lock lock(screenFbChangePoolMutex);
             {
-                RenderWorkerExecution workerExecution(ext.presentGraphicsWorker);
+                RenderWorkerExecution workerExecution(ext.presentGraphicsWorker, false);
                 fbManager.performOperations(ext.presentGraphicsWorker, &screenFbChangePool, nullptr, ext.shaderLibrary, nullptr,
                     present.fbOperations, targetManager, resolutionScale, 0, 0, nullptr);
             }
@@ -201,7 +202,7 @@ namespace RT64 {
                         RenderTarget &otherColorTarget = targetManager.get(otherColorTargetKey, true);
                         if (!otherColorTarget.isEmpty()) {
                             const FixedRect &r = presentFb->lastWriteRect;
-                            RenderWorkerExecution workerExecution(ext.presentGraphicsWorker);
+                            RenderWorkerExecution workerExecution(ext.presentGraphicsWorker, false);
                             colorTarget->copyFromTarget(ext.presentGraphicsWorker, &otherColorTarget, r.left(false), r.top(false), r.width(false, true), r.height(false, true), ext.shaderLibrary);
                         }
                     }
@@ -227,6 +228,9 @@ namespace RT64 {
                 lockedWorkloadMutex = true;
                 ext.sharedResources->workloadMutex.lock();
 
+                // The target might be recreated by the resize, so the operations must be finished first.
+                ext.presentGraphicsWorker->wait();
+
                 RenderTargetKey colorTargetKey(fbAddress, scratchFb.width, scratchFb.siz, Framebuffer::Type::Color);
                 colorTarget = &targetManager.get(colorTargetKey, true);
                 colorTarget->resize(ext.presentGraphicsWorker, scratchFb.width, scratchFb.height);
@@ -236,7 +240,7 @@ namespace RT64 {
                 scratchFb.nativeTarget.resetBufferHistory();
 
                 {
-                    RenderWorkerExecution workerExecution(ext.presentGraphicsWorker);
+                    RenderWorkerExecution workerExecution(ext.presentGraphicsWorker, false);
                     colorTarget->clearColorTarget(ext.presentGraphicsWorker);
                     FramebufferChange *colorFbChange = scratchFb.readChangeFromBytes(ext.presentGraphicsWorker, scratchFbChangePool, Framebuffer::Type::Color,
                         G_IM_FMT_RGBA, present.storage.data(), 0, scratchFb.height, ext.shaderLibrary);
@@ -302,7 +306,7 @@ namespace RT64 {
                 const uint32_t textureIndex = ext.swapChain->getTextureIndex();
                 RenderTexture *swapChainTexture = ext.swapChain->getTexture(textureIndex);
                 RenderFramebuffer *swapChainFramebuffer = swapChainFramebuffers[textureIndex].get();
-                RenderCommandList *commandList = ext.presentGraphicsWorker->commandList.get();
+                RenderCommandList *commandList = ext.presentGraphicsWorker->commandList;
                 commandList->begin();
                 commandList->barriers(RenderBarrierStage::GRAPHICS, RenderTextureBarrier(swapChainTexture, RenderTextureLayout::COLOR_WRITE));
                 commandList->setFramebuffer(swapChainFramebuffer);
@@ -355,10 +359,12 @@ namespace RT64 {
                     commandList->barriers(RenderBarrierStage::NONE, RenderTextureBarrier(swapChainTexture, RenderTextureLayout::PRESENT));
                     commandList->end();
                     ext.presentGraphicsWorker->execute();
-                    ext.presentGraphicsWorker->wait();
                 }
             }
 
+            // The workload queue can't use the targets again until all the work that was submitted for this frame is done.
+            ext.presentGraphicsWorker->wait();
+
             if (lockedWorkloadMutex) {
                 ext.sharedResources->workloadMutex.unlock();
                 lockedWorkloadMutex = false;
@@ -149,7 +149,7 @@ namespace RT64 {
             // Always tags regions in TMEM, regardless of whether it's possible to make a copy or not.
             uint32_t fbEnd = fb->addressStart + fb->imageRowBytes(fb->width) * fb->maxHeight;
             bool syncRequired = (fb->addressStart < addressEnd) && (fbEnd > addressStart);
-            fbManager.insertRegionsTMEM(fb->addressStart, tmemStart, std::min(tmemWords, uint32_t(RDP_TMEM_WORDS)), tmemMask, RGBA32, syncRequired, couldMakeTile ? &regionIterators : nullptr);
+            fbManager.insertRegionsTMEM(fb->addressStart, tmemStart, std::min(tmemWords, uint32_t(RDP_TMEM_WORDS)), tmemMask, RGBA32, syncRequired, couldMakeTile ? &regionIndices : nullptr);
 
             if (couldMakeTile) {
                 // Make a new tile copy resource.
@@ -158,9 +158,10 @@ namespace RT64 {
                 uint64_t newTileId = fbManager.findTileCopyId(newTileWidth, newTileHeight);
 
                 // If valid, store the FB tile and the copy ID in the relevant regions.
-                for (FramebufferManager::RegionIterator regionIt : regionIterators) {
-                    regionIt->fbTile = fbTile;
-                    regionIt->tileCopyId = newTileId;
+                for (uint32_t regionIndex : regionIndices) {
+                    FramebufferManager::RegionTMEM &region = fbManager.activeRegionsTMEM[regionIndex];
+                    region.fbTile = fbTile;
+                    region.tileCopyId = newTileId;
                 }
                 
                 // Queue the operation to make the tile copy.
@@ -132,7 +132,7 @@ namespace RT64 {
         std::vector<interop::float2> triTcWorkBuffer;
         bool crashed;
         CrashReason crashReason;
-        std::vector<FramebufferManager::RegionIterator> regionIterators;
+        std::vector<uint32_t> regionIndices;
 
         RDP(State *state);
         void setGBI();
@@ -11,14 +11,18 @@
 namespace RT64 {
     // TextureManager
 
-    uint64_t TextureManager::uploadTMEM(State *state, TextureCache *textureCache, uint64_t creationFrame, uint16_t byteOffset, uint16_t byteCount) {
+    uint64_t TextureManager::hashTMEM(const uint8_t *TMEM, uint16_t byteOffset, uint16_t byteCount) {
         XXH3_state_t xxh3;
         XXH3_64bits_reset(&xxh3);
-        const uint8_t *TMEM = reinterpret_cast<const uint8_t *>(state->rdp->TMEM);
         XXH3_64bits_update(&xxh3, &TMEM[byteOffset], byteCount);
         XXH3_64bits_update(&xxh3, &byteOffset, sizeof(byteOffset));
         XXH3_64bits_update(&xxh3, &byteCount, sizeof(byteCount));
-        const uint64_t hash = XXH3_64bits_digest(&xxh3);
+        return XXH3_64bits_digest(&xxh3);
+    }
+
+    uint64_t TextureManager::uploadTMEM(State *state, TextureCache *textureCache, uint64_t creationFrame, uint16_t byteOffset, uint16_t byteCount) {
+        const uint8_t *TMEM = reinterpret_cast<const uint8_t *>(state->rdp->TMEM);
+        const uint64_t hash = hashTMEM(TMEM, byteOffset, byteCount);
         if (hashSet.find(hash) == hashSet.end()) {
             hashSet.insert(hash);
             textureCache->queueGPUUploadTMEM(hash, creationFrame, TMEM, RDP_TMEM_BYTES, 0, 0, 0, LoadTile());
@@ -27,11 +31,10 @@ namespace RT64 {
         return hash;
     }
 
-    uint64_t TextureManager::uploadTexture(State *state, const LoadTile &loadTile, TextureCache *textureCache, uint64_t creationFrame, uint16_t width, uint16_t height, uint32_t tlut) {
+    uint64_t TextureManager::hashTexture(const uint8_t *TMEM, const LoadTile &loadTile, uint16_t width, uint16_t height, uint32_t tlut) {
         XXH3_state_t xxh3;
         XXH3_64bits_reset(&xxh3);
         const bool RGBA32 = (loadTile.siz == G_IM_SIZ_32b) && (loadTile.fmt == G_IM_FMT_RGBA);
-        const uint8_t *TMEM = reinterpret_cast<const uint8_t *>(state->rdp->TMEM);
         const uint32_t tmemSize = RGBA32 ? (RDP_TMEM_BYTES >> 1) : RDP_TMEM_BYTES;
         const uint32_t lastRowBytes = width << std::min(loadTile.siz, uint8_t(G_IM_SIZ_16b)) >> 1;
         const uint32_t bytesToHash = (loadTile.line << 3) * (height - 1) + lastRowBytes;
@@ -72,8 +75,12 @@ namespace RT64 {
         XXH3_64bits_update(&xxh3, &loadTile.line, sizeof(loadTile.line));
         XXH3_64bits_update(&xxh3, &loadTile.siz, sizeof(loadTile.siz));
         XXH3_64bits_update(&xxh3, &loadTile.fmt, sizeof(loadTile.fmt));
+        return XXH3_64bits_digest(&xxh3);
+    }
 
-        const uint64_t hash = XXH3_64bits_digest(&xxh3);
+    uint64_t TextureManager::uploadTexture(State *state, const LoadTile &loadTile, TextureCache *textureCache, uint64_t creationFrame, uint16_t width, uint16_t height, uint32_t tlut) {
+        const uint8_t *TMEM = reinterpret_cast<const uint8_t *>(state->rdp->TMEM);
+        const uint64_t hash = hashTexture(TMEM, loadTile, width, height, tlut);
         if (hashSet.find(hash) == hashSet.end()) {
             hashSet.insert(hash);
             textureCache->queueGPUUploadTMEM(hash, creationFrame, TMEM, RDP_TMEM_BYTES, width, height, tlut, loadTile);
@@ -18,6 +18,8 @@ namespace RT64 {
         uint64_t uploadTMEM(State *state, TextureCache *textureCache, uint64_t creationFrame, uint16_t byteOffset, uint16_t byteCount);
         uint64_t uploadTexture(State *state, const LoadTile &loadTile, TextureCache *textureCache, uint64_t creationFrame, uint16_t width, uint16_t height, uint32_t tlut);
         void removeHashes(const std::vector<uint64_t> &hashes);
+        static uint64_t hashTMEM(const uint8_t *TMEM, uint16_t byteOffset, uint16_t byteCount);
+        static uint64_t hashTexture(const uint8_t *TMEM, const LoadTile &loadTile, uint16_t width, uint16_t height, uint32_t tlut);
         static bool requiresRawTMEM(const LoadTile &loadTile, uint16_t width, uint16_t height);
     };
 };
\ No newline at end of file
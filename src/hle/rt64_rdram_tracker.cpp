@@ -0,0 +1,214 @@
+//
+// RT64
+//
+
+#include "rt64_rdram_tracker.h"
+
+#include <algorithm>
+#include <bitset>
+#include <cassert>
+#include <vector>
+
+#if defined(__linux__)
+#   include <fcntl.h>
+#   include <unistd.h>
+#endif
+
+#include "common/rt64_common.h"
+
+namespace RT64 {
+    // RDRAMPages
+
+    void RDRAMPages::clear() {
+        words.fill(0);
+    }
+
+    void RDRAMPages::setAll() {
+        words.fill(UINT64_MAX);
+    }
+
+    void RDRAMPages::set(uint32_t address, uint32_t size) {
+        if (size == 0) {
+            return;
+        }
+
+        const uint32_t pageStart = std::min(address >> PageShift, PageCount - 1);
+        const uint32_t pageEnd = std::min((address + size - 1) >> PageShift, PageCount - 1);
+        for (uint32_t p = pageStart; p <= pageEnd; p++) {
+            words[p / 64] |= (1ULL << (p % 64));
+        }
+    }
+
+    void RDRAMPages::add(const RDRAMPages &other) {
+        for (uint32_t w = 0; w < WordCount; w++) {
+            words[w] |= other.words[w];
+        }
+    }
+
+    bool RDRAMPages::test(uint32_t address, uint32_t size) const {
+        if (size == 0) {
+            return false;
+        }
+
+        const uint32_t pageStart = std::min(address >> PageShift, PageCount - 1);
+        const uint32_t pageEnd = std::min((address + size - 1) >> PageShift, PageCount - 1);
+        for (uint32_t p = pageStart; p <= pageEnd; p++) {
+            if (words[p / 64] & (1ULL << (p % 64))) {
+                return true;
+            }
+        }
+
+        return false;
+    }
+
+    uint32_t RDRAMPages::count() const {
+        uint32_t pageCount = 0;
+        for (uint64_t word : words) {
+            pageCount += uint32_t(std::bitset<64>(word).count());
+        }
+
+        return pageCount;
+    }
+
+    // RDRAMTracker
+
+    RDRAMTracker::RDRAMTracker() {
+        for (std::atomic<uint64_t> &word : notifiedWords) {
+            word = 0;
+        }
+    }
+
+    RDRAMTracker::~RDRAMTracker() {
+        closeSoftDirty();
+    }
+
+    void RDRAMTracker::setup(const uint8_t *RDRAM, uint32_t RDRAMSize, bool notificationsEnabled, bool softDirtyEnabled) {
+        assert(RDRAM != nullptr);
+
+        this->RDRAM = RDRAM;
+        this->RDRAMSize = RDRAMSize;
+
+        closeSoftDirty();
+
+        if (notificationsEnabled) {
+            mode = Mode::Notifications;
+        }
+        else if (softDirtyEnabled && setupSoftDirty()) {
+            RT64_LOG_PRINTF("Soft-dirty page tracking is enabled. Every page of the process will be write-protected once per frame.");
+            mode = Mode::SoftDirty;
+        }
+        else {
+            mode = Mode::Disabled;
+        }
+    }
+
+    void RDRAMTracker::notifyWrite(uint32_t address, uint32_t size) {
+        if ((mode != Mode::Notifications) || (size == 0)) {
+            return;
+        }
+
+        const uint32_t pageStart = std::min(address >> RDRAMPages::PageShift, RDRAMPages::PageCount - 1);
+        const uint32_t pageEnd = std::min((address + size - 1) >> RDRAMPages::PageShift, RDRAMPages::PageCount - 1);
+        for (uint32_t p = pageStart; p <= pageEnd; p++) {
+            notifiedWords[p / 64].fetch_or(1ULL << (p % 64), std::memory_order_relaxed);
+        }
+    }
+
+    void RDRAMTracker::collect(RDRAMPages &dstPages) {
+        switch (mode) {
+        case Mode::Notifications:
+            for (uint32_t w = 0; w < RDRAMPages::WordCount; w++) {
+                dstPages.words[w] |= notifiedWords[w].exchange(0, std::memory_order_relaxed);
+            }
+
+            break;
+        case Mode::SoftDirty:
+            collectSoftDirty(dstPages);
+            break;
+        case Mode::Disabled:
+        default:
+            dstPages.setAll();
+            break;
+        }
+    }
+
+    void RDRAMTracker::endFrame() {
+        // Stop relying on the soft-dirty bits entirely if they can't be cleared, as the writes after this point would be missed.
+        if ((mode == Mode::SoftDirty) && !clearSoftDirty()) {
+            RT64_LOG_PRINTF("Failed to clear the soft-dirty bits. RDRAM will be checked entirely instead.");
+            closeSoftDirty();
+            mode = Mode::Disabled;
+        }
+    }
+
+    bool RDRAMTracker::setupSoftDirty() {
+#   if defined(__linux__)
+        hostPageSize = uint32_t(sysconf(_SC_PAGESIZE));
+        pagemapFd = open("/proc/self/pagemap", O_RDONLY | O_CLOEXEC);
+        clearRefsFd = open("/proc/self/clear_refs", O_WRONLY | O_CLOEXEC);
+        if ((pagemapFd < 0) || (clearRefsFd < 0) || !clearSoftDirty()) {
+            RT64_LOG_PRINTF("Soft-dirty page tracking is not available. RDRAM will be checked entirely instead.");
+            closeSoftDirty();
+            return false;
+        }
+
+        return true;
+#   else
+        return false;
+#   endif
+    }
+
+    void RDRAMTracker::closeSoftDirty() {
+#   if defined(__linux__)
+        if (pagemapFd >= 0) {
+            close(pagemapFd);
+            pagemapFd = -1;
+        }
+
+        if (clearRefsFd >= 0) {
+            close(clearRefsFd);
+            clearRefsFd = -1;
+        }
+#   endif
+    }
+
+    bool RDRAMTracker::clearSoftDirty() {
+#   if defined(__linux__)
+        // Writing 4 clears the soft-dirty bits of every page in the process. This is expensive, so it must only be done once per frame.
+        const char clearCommand = '4';
+        return pwrite(clearRefsFd, &clearCommand, sizeof(clearCommand), 0) == sizeof(clearCommand);
+#   else
+        return false;
+#   endif
+    }
+
+    void RDRAMTracker::collectSoftDirty(RDRAMPages &dstPages) {
+#   if defined(__linux__)
+        // Each entry in the page map is 64 bits and bit 55 indicates the page was written to since the bits were last cleared.
+        const uint64_t SoftDirtyBit = 1ULL << 55;
+        const uintptr_t rdramStart = uintptr_t(RDRAM);
+        const uintptr_t rdramEnd = rdramStart + RDRAMSize;
+        const uintptr_t hostStart = rdramStart & ~uintptr_t(hostPageSize - 1);
+        const size_t hostPageCount = (rdramEnd - hostStart + hostPageSize - 1) / hostPageSize;
+        thread_local std::vector<uint64_t> pagemapEntries;
+        pagemapEntries.resize(hostPageCount);
+
+        const off_t pagemapOffset = off_t(hostStart / hostPageSize) * sizeof(uint64_t);
+        const ssize_t pagemapBytes = ssize_t(hostPageCount * sizeof(uint64_t));
+        if (pread(pagemapFd, pagemapEntries.data(), pagemapBytes, pagemapOffset) != pagemapBytes) {
+            dstPages.setAll();
+            return;
+        }
+
+        for (size_t i = 0; i < hostPageCount; i++) {
+            if (pagemapEntries[i] & SoftDirtyBit) {
+                const uintptr_t pageStart = std::max(hostStart + i * hostPageSize, rdramStart);
+                const uintptr_t pageEnd = std::min(hostStart + (i + 1) * hostPageSize, rdramEnd);
+                dstPages.set(uint32_t(pageStart - rdramStart), uint32_t(pageEnd - pageStart));
+            }
+        }
+#   else
+        dstPages.setAll();
+#   endif
+    }
+};
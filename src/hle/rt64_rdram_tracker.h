@@ -0,0 +1,61 @@
+//
+// RT64
+//
+
+#pragma once
+
+#include <array>
+#include <atomic>
+#include <stdint.h>
+
+namespace RT64 {
+    // Set of RDRAM pages that were written to.
+    struct RDRAMPages {
+        static const uint32_t PageShift = 12;
+        static const uint32_t PageSize = 1U << PageShift;
+        static const uint32_t PageCount = 0x800000U >> PageShift;
+        static const uint32_t WordCount = PageCount / 64;
+
+        std::array<uint64_t, WordCount> words = {};
+
+        void clear();
+        void setAll();
+        void set(uint32_t address, uint32_t size);
+        void add(const RDRAMPages &other);
+        bool test(uint32_t address, uint32_t size) const;
+        uint32_t count() const;
+    };
+
+    // Tracks the RDRAM pages written to by the emulator. The emulator can notify the writes directly, or on Linux, the soft-dirty
+    // bits of the pages can be used instead if the user opts into it. If neither is available, every page is considered to be
+    // written to when collected.
+    //
+    // Soft-dirty bits can only be cleared for the entire process, which forces a fault on the next write to any page the process
+    // owns. They're only cleared once per frame by endFrame(), so collecting in-between returns every page written since then.
+    struct RDRAMTracker {
+        enum class Mode {
+            Disabled,
+            Notifications,
+            SoftDirty
+        };
+
+        const uint8_t *RDRAM = nullptr;
+        uint32_t RDRAMSize = 0;
+        Mode mode = Mode::Disabled;
+        std::array<std::atomic<uint64_t>, RDRAMPages::WordCount> notifiedWords;
+        int pagemapFd = -1;
+        int clearRefsFd = -1;
+        uint32_t hostPageSize = 0;
+
+        RDRAMTracker();
+        ~RDRAMTracker();
+        void setup(const uint8_t *RDRAM, uint32_t RDRAMSize, bool notificationsEnabled, bool softDirtyEnabled);
+        void notifyWrite(uint32_t address, uint32_t size);
+        void collect(RDRAMPages &dstPages);
+        void endFrame();
+        bool setupSoftDirty();
+        void closeSoftDirty();
+        bool clearSoftDirty();
+        void collectSoftDirty(RDRAMPages &dstPages);
+    };
+};
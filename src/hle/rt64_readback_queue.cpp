@@ -0,0 +1,88 @@
+//
+// RT64
+//
+
+#include "rt64_readback_queue.h"
+
+#include <cassert>
+
+#include "common/rt64_thread.h"
+
+namespace RT64 {
+    // ReadbackQueue
+
+    ReadbackQueue::ReadbackQueue(RenderWorker *worker) {
+        assert(worker != nullptr);
+
+        this->worker = worker;
+
+        running = true;
+        thread = new std::thread(&ReadbackQueue::threadLoop, this);
+    }
+
+    ReadbackQueue::~ReadbackQueue() {
+        {
+            std::unique_lock<std::mutex> counterLock(counterMutex);
+            running = false;
+        }
+
+        submitCondition.notify_all();
+        thread->join();
+        delete thread;
+    }
+
+    void ReadbackQueue::threadLoop() {
+        Thread::setCurrentThreadName("RT64 Readback");
+
+        uint64_t waitCounter = 0;
+        while (true) {
+            {
+                std::unique_lock<std::mutex> counterLock(counterMutex);
+                submitCondition.wait(counterLock, [this]() {
+                    return !running || (submittedCounter > completedCounter);
+                });
+
+                // Any submission still in flight must be waited on before stopping, as the worker can't be destroyed while it's in use.
+                if (submittedCounter == completedCounter) {
+                    break;
+                }
+
+                waitCounter = submittedCounter;
+            }
+
+            worker->wait();
+
+            {
+                std::unique_lock<std::mutex> counterLock(counterMutex);
+                completedCounter = waitCounter;
+            }
+
+            completeCondition.notify_all();
+        }
+    }
+
+    uint64_t ReadbackQueue::execute() {
+        uint64_t counter;
+        {
+            std::unique_lock<std::mutex> counterLock(counterMutex);
+            assert((submittedCounter == completedCounter) && "The worker can't be executed again until the last submission is complete.");
+            worker->execute();
+            counter = ++submittedCounter;
+        }
+
+        submitCondition.notify_all();
+        return counter;
+    }
+
+    bool ReadbackQueue::isCompleted(uint64_t counter) {
+        std::unique_lock<std::mutex> counterLock(counterMutex);
+        return (counter <= completedCounter);
+    }
+
+    void ReadbackQueue::wait(uint64_t counter) {
+        std::unique_lock<std::mutex> counterLock(counterMutex);
+        completeCondition.wait(counterLock, [&]() {
+            return (counter <= completedCounter);
+        });
+    }
+};
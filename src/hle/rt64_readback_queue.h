@@ -0,0 +1,35 @@
+//
+// RT64
+//
+
+#pragma once
+
+#include <atomic>
+#include <condition_variable>
+#include <mutex>
+#include <thread>
+
+#include "render/rt64_render_worker.h"
+
+namespace RT64 {
+    // Waits on the fence of the worker's submissions on a dedicated thread, so the results of the GPU can be written back to RDRAM
+    // after the emulator has already resumed. The fence of a worker can only be waited on once, so this thread must be the sole waiter
+    // of any submission made through it, and the worker must not be used again until the submission is known to be complete.
+    struct ReadbackQueue {
+        RenderWorker *worker;
+        std::thread *thread = nullptr;
+        std::atomic<bool> running = false;
+        std::mutex counterMutex;
+        std::condition_variable submitCondition;
+        std::condition_variable completeCondition;
+        uint64_t submittedCounter = 0;
+        uint64_t completedCounter = 0;
+
+        ReadbackQueue(RenderWorker *worker);
+        ~ReadbackQueue();
+        void threadLoop();
+        uint64_t execute();
+        bool isCompleted(uint64_t counter);
+        void wait(uint64_t counter);
+    };
+};
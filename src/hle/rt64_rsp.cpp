@@ -55,6 +55,8 @@ namespace RT64 {
         used.reset();
         lights.fill({});
         segments.fill(0);
+        vertexCache.clear();
+        vertexCacheStats = VertexCacheStats();
         viewportStack[0] = {};
         textureState = {};
         curViewProjIndex = 0;
@@ -563,6 +565,37 @@ namespace RT64 {
         auto &posScreen = workload.drawData.posScreen;
         const auto &mvp = modelViewProjMatrix;
         const uint32_t globalIndex = workload.drawData.vertexCount();
+        const uint32_t vertexCount = dstMax - dstIndex;
+        viewProjIndices.insert(viewProjIndices.end(), vertexCount, curViewProjIndex);
+        worldIndices.insert(worldIndices.end(), vertexCount, curTransformIndex);
+        fogIndices.insert(fogIndices.end(), vertexCount, curFogIndex);
+        lightIndices.insert(lightIndices.end(), vertexCount, curLightIndex);
+        lightCounts.insert(lightCounts.end(), vertexCount, curLightCount);
+        lookAtIndices.insert(lookAtIndices.end(), vertexCount, curLookAtIndex);
+        for (uint32_t i = dstIndex; i < dstMax; i++) {
+            indices[i] = uint32_t(globalIndex) + (i - dstIndex);
+            used[i] = false;
+        }
+
+        if constexpr (addEmptyVelocity) {
+            velShorts.insert(velShorts.end(), vertexCount * 3, 0);
+        }
+
+        // The rest of the attributes only depend on the contents of the vertices and the state used to transform them, so they can be
+        // appended directly if the same vertices were loaded before under the same state.
+        const uint64_t vertexHash = hashVertexLoad(dstIndex, dstMax, usesTextureGen);
+        auto cacheIt = vertexCache.find(vertexHash);
+        if ((cacheIt != vertexCache.end()) && (cacheIt->second.vertexCount == vertexCount)) {
+            const VertexCacheEntry &entry = cacheIt->second;
+            posShorts.insert(posShorts.end(), entry.posShorts.begin(), entry.posShorts.end());
+            normColBytes.insert(normColBytes.end(), entry.normColBytes.begin(), entry.normColBytes.end());
+            tcFloats.insert(tcFloats.end(), entry.tcFloats.begin(), entry.tcFloats.end());
+            posTransformed.insert(posTransformed.end(), entry.posTransformed.begin(), entry.posTransformed.end());
+            posScreen.insert(posScreen.end(), entry.posScreen.begin(), entry.posScreen.end());
+            vertexCacheStats.hits++;
+            return;
+        }
+
         for (uint32_t i = dstIndex; i < dstMax; i++) {
             auto &v = vertices[i];
             posShorts.emplace_back(v.x);
@@ -572,20 +605,6 @@ namespace RT64 {
             normColBytes.emplace_back(v.color.g);
             normColBytes.emplace_back(v.color.b);
             normColBytes.emplace_back(v.color.a);
-            viewProjIndices.emplace_back(curViewProjIndex);
-            worldIndices.emplace_back(curTransformIndex);
-            fogIndices.emplace_back(curFogIndex);
-            lightIndices.emplace_back(curLightIndex);
-            lightCounts.emplace_back(curLightCount);
-            lookAtIndices.emplace_back(curLookAtIndex);
-            indices[i] = uint32_t(globalIndex) + (i - dstIndex);
-            used[i] = false;
-
-            if constexpr (addEmptyVelocity) {
-                velShorts.emplace_back(0);
-                velShorts.emplace_back(0);
-                velShorts.emplace_back(0);
-            }
         }
 
         for (uint32_t i = dstIndex; i < dstMax; i++) {
@@ -613,6 +632,38 @@ namespace RT64 {
                 tcFloats.emplace_back((float)((double)((vertices[i].t) * TextureTc) / Divisor));
             }
         }
+
+        // Store the attributes that were just computed in the cache.
+        if (vertexCache.size() >= RSP_VERTEX_CACHE_MAX_ENTRIES) {
+            vertexCache.clear();
+        }
+
+        VertexCacheEntry &entry = vertexCache[vertexHash];
+        entry.vertexCount = vertexCount;
+        entry.posShorts.assign(posShorts.end() - vertexCount * 3, posShorts.end());
+        entry.normColBytes.assign(normColBytes.end() - vertexCount * 4, normColBytes.end());
+        entry.tcFloats.assign(tcFloats.end() - vertexCount * 2, tcFloats.end());
+        entry.posTransformed.assign(posTransformed.end() - vertexCount, posTransformed.end());
+        entry.posScreen.assign(posScreen.end() - vertexCount, posScreen.end());
+        vertexCacheStats.misses++;
+    }
+
+    uint64_t RSP::hashVertexLoad(uint8_t dstIndex, uint8_t dstMax, bool usesTextureGen) const {
+        const interop::RSPViewport &viewport = viewportStack[viewportStackSize - 1];
+        const uint32_t geometryMode = geometryModeStack[geometryModeStackSize - 1];
+        const uint32_t vertexCount = dstMax - dstIndex;
+        XXH3_state_t xxh3;
+        XXH3_64bits_reset(&xxh3);
+        XXH3_64bits_update(&xxh3, &vertices[dstIndex], sizeof(Vertex) * vertexCount);
+        XXH3_64bits_update(&xxh3, &vertexCount, sizeof(vertexCount));
+        XXH3_64bits_update(&xxh3, &modelViewProjMatrix, sizeof(modelViewProjMatrix));
+        XXH3_64bits_update(&xxh3, &viewport.scale, sizeof(viewport.scale));
+        XXH3_64bits_update(&xxh3, &viewport.translate, sizeof(viewport.translate));
+        XXH3_64bits_update(&xxh3, &geometryMode, sizeof(geometryMode));
+        XXH3_64bits_update(&xxh3, &usesTextureGen, sizeof(usesTextureGen));
+        XXH3_64bits_update(&xxh3, &textureState.sc, sizeof(textureState.sc));
+        XXH3_64bits_update(&xxh3, &textureState.tc, sizeof(textureState.tc));
+        return XXH3_64bits_digest(&xxh3);
     }
 
     void RSP::modifyVertex(uint16_t dstIndex, uint16_t dstAttribute, uint32_t value) {
@@ -7,6 +7,8 @@
 #include <array>
 #include <bitset>
 #include <stdint.h>
+#include <unordered_map>
+#include <vector>
 
 #include "common/rt64_common.h"
 #include "gbi/rt64_display_list.h"
@@ -27,6 +29,7 @@
 #define RSP_MAX_VERTICES            256
 #define RSP_MAX_SEGMENTS            16
 #define RSP_MATRIX_ID_STACK_SIZE    256
+#define RSP_VERTEX_CACHE_MAX_ENTRIES 4096
 
 namespace RT64 {
     struct State;
@@ -121,6 +124,22 @@ namespace RT64 {
             float t;
         };
 
+        // Attributes computed by a vertex load that can be appended directly to the draw data when the same vertices are loaded again
+        // under the same state.
+        struct VertexCacheEntry {
+            uint32_t vertexCount = 0;
+            std::vector<int16_t> posShorts;
+            std::vector<uint8_t> normColBytes;
+            std::vector<float> tcFloats;
+            std::vector<hlslpp::float4> posTransformed;
+            std::vector<hlslpp::float3> posScreen;
+        };
+
+        struct VertexCacheStats {
+            uint32_t hits = 0;
+            uint32_t misses = 0;
+        };
+
         struct TextureState {
             uint8_t tile = 0;
             uint8_t levels = 0;
@@ -185,6 +204,8 @@ namespace RT64 {
         uint32_t pushMask;
         uint32_t shadingSmoothMask;
         std::array<uint32_t, RSP_MAX_SEGMENTS> segments;
+        std::unordered_map<uint64_t, VertexCacheEntry> vertexCache;
+        VertexCacheStats vertexCacheStats;
 
         struct {
             // Storage for struct data loaded by S2D commands.
@@ -238,6 +259,7 @@ namespace RT64 {
         void setVertexColorPD(uint32_t address);
         template<bool addEmptyVelocity>
         void setVertexCommon(uint8_t dstIndex, uint8_t dstMax);
+        uint64_t hashVertexLoad(uint8_t dstIndex, uint8_t dstMax, bool usesTextureGen) const;
         void modifyVertex(uint16_t dstIndex, uint16_t dstAttribute, uint32_t value);
         void setGeometryMode(uint32_t mask);
         void pushGeometryMode();
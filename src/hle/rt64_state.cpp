@@ -11,6 +11,7 @@
 #include "imgui/imgui.h"
 #include "implot/implot.h"
 
+#include "common/rt64_copy_hash.h"
 #include "common/rt64_elapsed_timer.h"
 #include "common/rt64_math.h"
 #include "preset/rt64_preset_draw_call.h"
@@ -68,7 +69,7 @@ namespace RT64 {
         this->ext = ext;
 
         rspProcessor = std::make_unique<RSPProcessor>(ext.device);
-        framebufferRenderer = std::make_unique<FramebufferRenderer>(ext.framebufferGraphicsWorker, false, ext.createdGraphicsAPI, ext.shaderLibrary);
+        framebufferRenderer = std::make_unique<FramebufferRenderer>(ext.framebufferGraphicsWorker, false, ext.createdGraphicsAPI, ext.shaderLibrary, 0);
         renderFramebufferManager = std::make_unique<RenderFramebufferManager>(ext.device);
 
         const RenderMultisampling multisampling = RasterShader::generateMultisamplingPattern(ext.userConfig->msaaSampleCount(), ext.device->getCapabilities().sampleLocations);
@@ -80,8 +81,19 @@ namespace RT64 {
         displayListAddress = 0;
         displayListCounter = 0;
         rdramCheckPending = true;
+        rdramCheckPages.setAll();
+        rdramScreenPages.setAll();
+        rdramCheckPageCount = 0;
+        framebufferUploadedBytes = 0;
+        pendingReadbacks.clear();
+        readbackCounter = 0;
+        readbackResolvePending = false;
+        readbackDirtyPages.clear();
         workloadCounter = 0;
         lastScreenHash = 0;
+        lastScreenAddress = 0;
+        lastScreenBytes = 0;
+        lastScreenFbAddress = UINT32_MAX;
         lastScreenFactorCounter = 0;
         lastWorkloadIndex = 0;
         addLightsOnFlush = false;
@@ -517,6 +529,16 @@ namespace RT64 {
     }
     
     void State::checkRDRAM() {
+        // Deferred readbacks are written back as soon as the emulator calls into the renderer again. Readbacks on demand must only be
+        // written back before checking RDRAM if the emulator wrote to the memory they cover, so the check can see the final contents.
+        // The pages written by the emulator in the meantime are kept as they are when the readbacks are written back.
+        if (readbackResolvePending) {
+            const bool deferredReadback = (ext.emulatorConfig->framebuffer.readback == EmulatorConfiguration::Framebuffer::Readback::Deferred);
+            if (deferredReadback || readbacksOverlap(rdramCheckPages)) {
+                resolveReadbacks();
+            }
+        }
+
         if (!rdramCheckPending) {
             return;
         }
@@ -529,8 +551,11 @@ namespace RT64 {
         const uint32_t fbPairIndex = workload.currentFramebufferPairIndex();
         {
             framebufferManager.storeRAM(workload.fbStorage, RDRAM, fbPairIndex);
-            framebufferManager.checkRAM(RDRAM, differentFbs, true);
+            framebufferManager.checkRAM(RDRAM, differentFbs, true, &rdramCheckPages);
+            rdramCheckPageCount = rdramCheckPages.count();
+            rdramCheckPages.clear();
             if (!differentFbs.empty()) {
+                waitForReadbacks();
                 RenderWorkerExecution execution(ext.framebufferGraphicsWorker);
                 framebufferManager.uploadRAM(ext.framebufferGraphicsWorker, differentFbs.data(), differentFbs.size(), workload.fbChangePool, RDRAM, true, drawFbOperations, drawFbDiscards, ext.shaderLibrary);
             }
@@ -656,6 +681,9 @@ namespace RT64 {
     }
     
     void State::fullSync() {
+        // Any readbacks that are still pending must be written back before rendering again.
+        resolveReadbacks();
+
         flush();
         submitFramebufferPair(FramebufferPair::FlushReason::ProcessDisplayListsEnd);
 
@@ -676,8 +704,7 @@ namespace RT64 {
         workload.extended.ditherNoiseStrength = extended.ditherNoiseStrength;
         
         // Validate all tile copies to be used during the rendering.
-        const bool extendedRenderToRAMSet = (extended.renderToRAM < UINT8_MAX);
-        const bool renderToRDRAM = extendedRenderToRAMSet ? (extended.renderToRAM != 0) : ext.emulatorConfig->framebuffer.renderToRAM;
+        const bool renderToRDRAM = renderToRAMEnabled();
         const bool warningsEnabled = ext.userConfig->developerMode;
         const bool linearFiltering = !ext.userConfig->threePointFiltering;
         const size_t callTileCount = workload.drawData.callTiles.size();
@@ -1199,7 +1226,7 @@ namespace RT64 {
                 resizedTargets.clear();
             };
 
-            auto renderAndSynchronize = [&](uint32_t maxFramebufferPair) {
+            auto renderAndSynchronize = [&](uint32_t maxFramebufferPair, bool deferReadback) {
                 // Preprocess all the framebuffer operations.
                 uint32_t pairCursor = framebufferPairCursor;
                 while (pairCursor < maxFramebufferPair) {
@@ -1406,16 +1433,49 @@ namespace RT64 {
 
                 ext.framebufferGraphicsWorker->commandList->end();
                 framebufferRenderer->waitForUploaders();
+
+                // The texture cache makes the textures available as soon as their uploads are submitted, so the queue must wait for them.
+                ext.textureCache->queueWaitForGPUUploads(ext.framebufferGraphicsWorker->commandQueue.get());
+
+                // The readback queue waits for the GPU instead and the results are written back to RDRAM once they're resolved.
+                if (deferReadback) {
+                    readbackCounter = ext.readbackQueue->execute();
+                    readbackResolvePending = true;
+                    readbackDirtyPages.clear();
+
+                    pairCursor = framebufferPairCursor;
+                    while (pairCursor < maxFramebufferPair) {
+                        if (getFramebufferPairs(pairCursor)) {
+                            pendingReadbacks.push_back({ colorFb->addressStart, colorFb->RAMBytes, colorWriteWidth, colorRowStart, std::min(colorRowEnd, colorFb->height) });
+
+                            if (depthWriteWidth > 0) {
+                                pendingReadbacks.push_back({ depthFb->addressStart, depthFb->RAMBytes, depthWriteWidth, depthRowStart, std::min(depthRowEnd, depthFb->height) });
+                            }
+                        }
+
+                        pairCursor++;
+                    }
+
+                    framebufferPairCursor = maxFramebufferPair;
+                    return;
+                }
+
                 ext.framebufferGraphicsWorker->execute();
+                readbackStallProfiler.start();
                 ext.framebufferGraphicsWorker->wait();
+                readbackStallProfiler.end();
 
                 pairCursor = framebufferPairCursor;
                 while (pairCursor < maxFramebufferPair) {
                     if (getFramebufferPairs(pairCursor)) {
                         colorFb->copyNativeToRAM(&RDRAM[colorFb->addressStart], colorWriteWidth, colorRowStart, std::min(colorRowEnd, colorFb->height));
+                        rdramCheckPages.set(colorFb->addressStart, colorFb->RAMBytes);
+                        rdramScreenPages.set(colorFb->addressStart, colorFb->RAMBytes);
 
                         if (depthWriteWidth > 0) {
                             depthFb->copyNativeToRAM(&RDRAM[depthFb->addressStart], depthWriteWidth, depthRowStart, std::min(depthRowEnd, depthFb->height));
+                            rdramCheckPages.set(depthFb->addressStart, depthFb->RAMBytes);
+                            rdramScreenPages.set(depthFb->addressStart, depthFb->RAMBytes);
                         }
                     }
 
@@ -1489,15 +1549,19 @@ namespace RT64 {
                 }
 
                 if (fbPair.syncRequired) {
-                    renderAndSynchronize(f);
+                    renderAndSynchronize(f, false);
                     renderSetup();
                 }
 
                 fullSyncFramebufferPairTiles(workload, fbPair, loadOpCursor, rdpTileCursor);
             }
 
-            // Render any remaining batches of framebuffers.
-            renderAndSynchronize(workload.fbPairCount);
+            // Render any remaining batches of framebuffers. Only the last synchronization can be deferred, as any others are
+            // required for the framebuffer pairs that come after it to read the results from RDRAM. Readbacks can only be
+            // deferred if the writes made by the emulator are tracked exactly, as the pages it writes to in the meantime must
+            // not be overwritten by the results.
+            const bool deferReadback = rdramWritesTracked && (ext.emulatorConfig->framebuffer.readback != EmulatorConfiguration::Framebuffer::Readback::Immediate);
+            renderAndSynchronize(workload.fbPairCount, deferReadback);
         }
         else {
             // Process all tiles.
@@ -1527,7 +1591,8 @@ namespace RT64 {
             textureManager.removeHashes(evictedTextureHashes);
         }
 
-        if (renderToRDRAM) {
+        // The rest of the work is done when the readbacks are resolved if they were deferred.
+        if (renderToRDRAM && !readbackResolvePending) {
             // Indicate to the texture cache it's safe to delete the textures if no locks are active.
             ext.textureCache->decrementLock();
 
@@ -1560,10 +1625,13 @@ namespace RT64 {
         dlCpuProfiler.log();
         screenCpuProfiler.log();
         screenCpuProfiler.reset();
+        readbackStallProfiler.log();
+        readbackStallProfiler.reset();
 
         // Inspect the current workload before submission.
         lastWorkloadIndex = ext.workloadQueue->writeCursor;
-        if (ext.userConfig->developerMode) {
+        if (ext.userConfig->developerMode && !deferInterrupts) {
+            // The inspector can't run on the interpreter thread, as it modifies the configuration the emulator thread reads.
             inspect();
         }
         
@@ -1615,7 +1683,7 @@ namespace RT64 {
         // Reset the next workload.
         workloadCursor = ext.workloadQueue->writeCursor;
         Workload &nextWorkload = ext.workloadQueue->workloads[workloadCursor];
-        nextWorkload.begin(workloadCounter++);
+        nextWorkload.begin(workloadCounter++, drawDataCapacity);
 
         // Indicate on the framebuffer manager that all tile copies are free to be used again.
         framebufferManager.clearUsedTileCopies();
@@ -1687,10 +1755,42 @@ namespace RT64 {
             }
         }
 
+        // Readbacks must be written back before the VI can read any of the memory they cover.
+        if (readbackResolvePending) {
+            const bool deferredReadback = !fromEarlyPresent && (ext.emulatorConfig->framebuffer.readback == EmulatorConfiguration::Framebuffer::Readback::Deferred);
+            const uint32_t screenFbMaxBytes = uint32_t(screenFbSize.x * screenFbSize.y) << 2;
+            if (deferredReadback || (viVisible && readbacksOverlap(screenFbAddress, screenFbMaxBytes))) {
+                resolveReadbacks();
+            }
+        }
+
         screenCpuProfiler.start();
         bool fbChangesMade = false;
         bool screenChangesMade = false;
+        uint32_t screenFbChecked = UINT32_MAX;
+        uint32_t screenBytesChecked = 0;
+        bool screenHashed = false;
         if (newVI.visible()) {
+            // Store the RAM required by the VI so the render thread can display it if necessary. The copy is hashed in the
+            // same pass, which also lets the framebuffer check below reuse the hash when it covers the same memory.
+            if (screenFbSiz >= G_IM_SIZ_16b) {
+                uint32_t screenFbBytes = uint32_t(screenFbSize.x * screenFbSize.y) << (screenFbSiz - 1);
+                present.storage.resize(screenFbBytes);
+
+                const bool screenUnchanged = (lastScreenAddress == screenFbAddress) && (lastScreenBytes == screenFbBytes) && !rdramScreenPages.test(screenFbAddress, screenFbBytes);
+                if (screenUnchanged) {
+                    memcpy(present.storage.data(), &RDRAM[screenFbAddress], screenFbBytes);
+                }
+                else {
+                    uint64_t newScreenHash = CopyAndHash(present.storage.data(), &RDRAM[screenFbAddress], screenFbBytes);
+                    screenChangesMade = (newScreenHash != lastScreenHash);
+                    lastScreenHash = newScreenHash;
+                    screenHashed = true;
+                }
+
+                screenBytesChecked = screenFbBytes;
+            }
+
             // See if there's an existing framebuffer that lines up with the VI. If there is, we support reading 
             // CPU changes directly to it and recreating them in the render thread at low resolution.
             RenderWorker *worker = ext.framebufferGraphicsWorker;
@@ -1699,10 +1799,21 @@ namespace RT64 {
                 // Check compatibility of the high resolution framebuffer with the VI first.
                 // Ensure both the siz and width are the same.
                 if ((screenFbSize.x == screenFb->width) && (screenFbSiz == screenFb->siz)) {
+                    // The hash only needs to be computed again if the framebuffer was written to since it was last checked.
+                    const bool screenFbUnchanged = (lastScreenFbAddress == screenFb->addressStart) && (screenFb->RAMHashBytes == screenFb->RAMBytes) &&
+                        !rdramScreenPages.test(screenFb->addressStart, screenFb->RAMBytes);
+
+                    const bool screenHashMatches = screenHashed && (screenFb->addressStart == screenFbAddress) && (screenFb->RAMBytes == screenBytesChecked);
                     const uint8_t *fbRAM = &RDRAM[screenFb->addressStart];
-                    uint64_t currentHash = XXH3_64bits(fbRAM, screenFb->RAMBytes);
+                    uint64_t currentHash = screenFb->RAMHash;
+                    if (!screenFbUnchanged) {
+                        currentHash = screenHashMatches ? lastScreenHash : XXH3_64bits(fbRAM, screenFb->RAMBytes);
+                    }
+
+                    screenFbChecked = screenFb->addressStart;
                     if (currentHash != screenFb->RAMHash) {
                         {
+                            waitForReadbacks();
                             RenderWorkerExecution workerExecution(worker);
                             thread_local std::vector<uint32_t> fbDiscards;
                             const std::scoped_lock lock(ext.presentQueue->screenFbChangePoolMutex);
@@ -1717,6 +1828,7 @@ namespace RT64 {
                         // Only update the hash if it's not a discard.
                         if (present.fbOperations.front().type == FramebufferOperation::Type::WriteChanges) {
                             screenFb->RAMHash = currentHash;
+                            screenFb->RAMHashBytes = screenFb->RAMBytes;
                             fbChangesMade = true;
                         }
                         else {
@@ -1729,16 +1841,17 @@ namespace RT64 {
                 }
             }
 
-            // Store the RAM required by the VI so the render thread can display it if necessary.
-            if (screenFbSiz >= G_IM_SIZ_16b) {
-                uint32_t screenFbBytes = uint32_t(screenFbSize.x * screenFbSize.y) << (screenFbSiz - 1);
-                present.storage.resize(screenFbBytes);
-                memcpy(present.storage.data(), &RDRAM[screenFbAddress], screenFbBytes);
-                uint64_t newScreenHash = XXH3_64bits(present.storage.data(), screenFbBytes);
-                screenChangesMade = (newScreenHash != lastScreenHash);
-                lastScreenHash = newScreenHash;
-            }
         }
+
+        // Only the RDRAM that was checked can be considered clean for the next time the screen is updated.
+        lastScreenFbAddress = screenFbChecked;
+        lastScreenAddress = screenFbAddress;
+        lastScreenBytes = screenBytesChecked;
+        rdramScreenPages.clear();
+
+        // Report the bytes of framebuffers that were uploaded from RAM since the last screen update.
+        framebufferUploadedBytes = framebufferManager.uploadedBytes;
+        framebufferManager.uploadedBytes = 0;
         
         // We only push a new present event to the timeline when it's necessary.
         if (fromEarlyPresent || viDifferent || fbChangesMade || screenChangesMade) {
@@ -1951,6 +2064,7 @@ namespace RT64 {
 
                     genConfigChanged = ImGui::Checkbox("Three-Point Filtering", &userConfig.threePointFiltering) || genConfigChanged;
                     genConfigChanged = ImGui::Checkbox("High Performance State", &userConfig.idleWorkActive) || genConfigChanged;
+                    genConfigChanged = ImGui::Checkbox("Threaded Display Lists", &userConfig.threadedDisplayLists) || genConfigChanged;
                     
                     // Emulator configuration.
                     ImGui::NewLine();
@@ -1965,6 +2079,7 @@ namespace RT64 {
                     ImGui::Indent();
                     emulatorConfigChanged = ImGui::Checkbox("Render to RAM", &emulatorConfig.framebuffer.renderToRAM) || emulatorConfigChanged;
                     emulatorConfigChanged = ImGui::Checkbox("Copy with GPU", &emulatorConfig.framebuffer.copyWithGPU) || emulatorConfigChanged;
+                    emulatorConfigChanged = ImGui::Combo("Readback", reinterpret_cast<int *>(&emulatorConfig.framebuffer.readback), "Immediate\0Deferred\0On Demand\0") || emulatorConfigChanged;
                     ImGui::Unindent();
 
                     // Enhancement configuration.
@@ -2102,6 +2217,8 @@ namespace RT64 {
                         const auto &matchingProfiler = ext.workloadQueue->matchingProfiler;
                         const auto &workloadProfiler = ext.workloadQueue->workloadProfiler;
                         const auto &dlApiProfiler = *ext.dlApiProfiler;
+                        const auto &dlEmulatorProfiler = *ext.dlEmulatorProfiler;
+                        const auto &dlThreadGainProfiler = *ext.dlThreadGainProfiler;
                         const auto &screenApiProfiler = *ext.screenApiProfiler;
                         ImPlot::SetupAxisLimits(ImAxis_Y1, 0.0, FrametimeLimit);
                         ImPlot::SetupAxis(ImAxis_Y1, "ms", ImPlotAxisFlags_AutoFit);
@@ -2111,10 +2228,12 @@ namespace RT64 {
                         ImPlot::PlotLine<double>("Workload", workloadProfiler.data(), static_cast<int>(workloadProfiler.size()), 1.0, 0.0, ImPlotLineFlags_None, workloadProfiler.index(), Stride);
                         ImPlot::PlotLine<double>("Display List (API)", dlApiProfiler.data(), static_cast<int>(dlApiProfiler.size()), 1.0, 0.0, ImPlotLineFlags_None, dlApiProfiler.index(), Stride);
                         ImPlot::PlotLine<double>("Display List (CPU)", dlCpuProfiler.data(), static_cast<int>(dlCpuProfiler.size()), 1.0, 0.0, ImPlotLineFlags_None, dlCpuProfiler.index(), Stride);
+                        ImPlot::PlotLine<double>("Display List (Emulator Thread)", dlEmulatorProfiler.data(), static_cast<int>(dlEmulatorProfiler.size()), 1.0, 0.0, ImPlotLineFlags_None, dlEmulatorProfiler.index(), Stride);
                         ImPlot::HideNextItem();
                         ImPlot::PlotLine<double>("Update Screen (API)", screenApiProfiler.data(), static_cast<int>(screenApiProfiler.size()), 1.0, 0.0, ImPlotLineFlags_None, screenApiProfiler.index(), Stride);
                         ImPlot::PlotLine<double>("Update Screen (VI Changed)", viChangedProfiler.data(), static_cast<int>(viChangedProfiler.size()), 1.0, 0.0, ImPlotLineFlags_None, viChangedProfiler.index(), Stride);
                         ImPlot::PlotLine<double>("Update Screen (CPU)", screenCpuProfiler.data(), static_cast<int>(screenCpuProfiler.size()), 1.0, 0.0, ImPlotLineFlags_None, screenCpuProfiler.index(), Stride);
+                        ImPlot::PlotLine<double>("Readback Stall", readbackStallProfiler.data(), static_cast<int>(readbackStallProfiler.size()), 1.0, 0.0, ImPlotLineFlags_None, readbackStallProfiler.index(), Stride);
                         ImPlot::EndPlot();
                         
                         const double averagePresent = presentProfiler.average();
@@ -2123,18 +2242,47 @@ namespace RT64 {
                         const double averageWorkload = workloadProfiler.average();
                         const double dlApiProfilerAverage = dlApiProfiler.average();
                         const double dlCpuProfilerAverage = dlCpuProfiler.average();
+                        const double dlEmulatorProfilerAverage = dlEmulatorProfiler.average();
+                        const double dlThreadGainProfilerAverage = dlThreadGainProfiler.average();
                         const double screenApiProfilerAverage = screenApiProfiler.average();
                         const double viChangedProfilerAverage = viChangedProfiler.average();
                         const double screenCpuProfilerAverage = screenCpuProfiler.average();
+                        const double readbackStallProfilerAverage = readbackStallProfiler.average();
                         ImGui::Text("Average Present (OS): %fms (%.1f FPS)\n", averagePresent, 1000.0 / averagePresent);
                         ImGui::Text("Average Renderer: %fms (%.1f FPS)\n", averageRenderer, 1000.0 / averageRenderer);
                         ImGui::Text("Average Matching (CPU): %fms (%.1f FPS)\n", averageMatching, 1000.0 / averageMatching);
                         ImGui::Text("Average Workload: %fms (%.1f FPS)\n", averageWorkload, 1000.0 / averageWorkload);
                         ImGui::Text("Average Display List (API): %fms (%.1f FPS)\n", dlApiProfilerAverage, 1000.0 / dlApiProfilerAverage);
                         ImGui::Text("Average Display List (CPU): %fms (%.1f FPS)\n", dlCpuProfilerAverage, 1000.0 / dlCpuProfilerAverage);
+                        ImGui::Text("Average Display List (Emulator Thread): %fms\n", dlEmulatorProfilerAverage);
+                        ImGui::Text("Average Display List (Thread Gain): %fms\n", dlThreadGainProfilerAverage);
                         ImGui::Text("Average Update Screen (API): %fms (%.1f FPS)\n", screenApiProfilerAverage, 1000.0 / screenApiProfilerAverage);
                         ImGui::Text("Average Update Screen (VI Changed): %fms (%.1f FPS)\n", viChangedProfilerAverage, 1000.0 / viChangedProfilerAverage);
                         ImGui::Text("Average Update Screen (CPU): %fms (%.1f FPS)\n", screenCpuProfilerAverage, 1000.0 / screenCpuProfilerAverage);
+                        ImGui::Text("Average Readback Stall: %fms\n", readbackStallProfilerAverage);
+
+                        ImGui::Text("RDRAM Pages Checked: %u / %u\n", rdramCheckPageCount, RDRAMPages::PageCount);
+                        ImGui::Text("Framebuffer Bytes Uploaded: %u\n", framebufferUploadedBytes);
+                        uint64_t fbChangeResidentBytes = 0;
+                        for (const Workload &queueWorkload : ext.workloadQueue->workloads) {
+                            fbChangeResidentBytes += queueWorkload.fbChangePool.stats.residentBytes;
+                        }
+
+                        const FramebufferChangePool::Stats &fbChangeStats = workload.fbChangePool.stats;
+                        ImGui::Text("Framebuffer Change Pool: %u hits, %u misses, %.2f MiB resident\n", fbChangeStats.hits, fbChangeStats.misses, fbChangeResidentBytes / (1024.0 * 1024.0));
+                        ImGui::Text("Draw Data Allocations: %u on reserve, %u on growth\n", drawDataCapacity.reserveAllocations, drawDataCapacity.growthAllocations);
+                        const RenderDescriptorSetStats descriptorSetStats = ext.device->getDescriptorSetStats();
+                        ImGui::Text("Descriptor Sets: %u live in %u pools\n", descriptorSetStats.setCount, descriptorSetStats.poolCount);
+                        const RSP::VertexCacheStats &vertexCacheStats = rsp->vertexCacheStats;
+                        const uint32_t vertexCacheLoads = vertexCacheStats.hits + vertexCacheStats.misses;
+                        const float vertexCacheHitRate = (vertexCacheLoads > 0) ? (100.0f * vertexCacheStats.hits / vertexCacheLoads) : 0.0f;
+                        ImGui::Text("Vertex Cache: %u hits, %u misses (%.1f%%), %u entries\n", vertexCacheStats.hits, vertexCacheStats.misses, vertexCacheHitRate, uint32_t(rsp->vertexCache.size()));
+                        if (ext.workloadQueue->framebufferRenderer != nullptr) {
+                            const FramebufferRenderer::Stats &rendererStats = ext.workloadQueue->framebufferRenderer->stats;
+                            ImGui::Text("Raster Draws: %u calls submitted in %u draws\n", rendererStats.rasterCalls, rendererStats.rasterDraws);
+                            ImGui::Text("Parallel Framebuffers: %u\n", rendererStats.parallelFramebuffers);
+                            ImGui::Text("Render Passes: %u (%u depth access switches)\n", rendererStats.renderPasses, rendererStats.depthTransitions);
+                        }
                     }
 
                     bool changed = false;
@@ -2294,6 +2442,7 @@ namespace RT64 {
     void State::advanceWorkload(Workload &workload, bool paused) {
         workload.workloadId = ++workloadId;
         workload.presentId = presentId;
+        workload.readbackCounter = readbackCounter;
         workload.debuggerCamera = debuggerInspector.camera;
         workload.debuggerRenderer = debuggerInspector.renderer;
         workload.paused = paused;
@@ -2308,6 +2457,12 @@ namespace RT64 {
     }
 
     void State::dpInterrupt() {
+        // The emulator's interrupt check can only be called from its own thread. Store it so it's raised once control goes back to it.
+        if (deferInterrupts) {
+            deferredInterrupts |= MI_INTR_DP;
+            return;
+        }
+
         *MI_INTR_REG |= MI_INTR_DP;
         checkInterrupts();
     }
@@ -2317,10 +2472,137 @@ namespace RT64 {
         checkInterrupts();
     }
 
+    void State::addRDRAMDirtyPages(const RDRAMPages &dirtyPages) {
+        rdramCheckPages.add(dirtyPages);
+        rdramScreenPages.add(dirtyPages);
+
+        // Pages written by the emulator while readbacks are pending have newer contents than the results of the readbacks.
+        if (readbackResolvePending) {
+            readbackDirtyPages.add(dirtyPages);
+        }
+    }
+
+    bool State::raiseDeferredInterrupts() {
+        const uint32_t interrupts = deferredInterrupts.exchange(0);
+        if (interrupts != 0) {
+            *MI_INTR_REG |= interrupts;
+            checkInterrupts();
+        }
+
+        return (interrupts & MI_INTR_DP) != 0;
+    }
+
+    bool State::renderToRAMEnabled() const {
+        const bool extendedRenderToRAMSet = (extended.renderToRAM < UINT8_MAX);
+        return extendedRenderToRAMSet ? (extended.renderToRAM != 0) : ext.emulatorConfig->framebuffer.renderToRAM;
+    }
+
     void State::advanceFramebufferRenderer() {
         framebufferRenderer->advanceFrame(false);
     }
 
+    void State::waitForReadbacks() {
+        if (ext.readbackQueue->isCompleted(readbackCounter)) {
+            return;
+        }
+
+        readbackStallProfiler.start();
+        ext.readbackQueue->wait(readbackCounter);
+        readbackStallProfiler.end();
+    }
+
+    void State::resolveReadbacks() {
+        if (!readbackResolvePending) {
+            return;
+        }
+
+        waitForReadbacks();
+
+        for (const PendingReadback &readback : pendingReadbacks) {
+            Framebuffer *fb = framebufferManager.find(readback.address);
+            if (fb == nullptr) {
+                RT64_LOG_PRINTF("Readback of framebuffer 0x%X was dropped as the framebuffer no longer exists.", readback.address);
+                continue;
+            }
+
+            // Preserve the contents of the pages the emulator wrote to after the readback was queued, as they're newer than the results.
+            const uint32_t addressEnd = std::min(fb->addressStart + fb->RAMBytes, RDRAMSize + 1);
+            auto forEachPreservedRange = [&](auto callback) {
+                const uint32_t pageStart = fb->addressStart >> RDRAMPages::PageShift;
+                const uint32_t pageEnd = (addressEnd + RDRAMPages::PageSize - 1) >> RDRAMPages::PageShift;
+                uint32_t preservedOffset = 0;
+                for (uint32_t p = pageStart; p < pageEnd; p++) {
+                    if (readbackDirtyPages.test(p << RDRAMPages::PageShift, 1)) {
+                        const uint32_t rangeStart = std::max(p << RDRAMPages::PageShift, fb->addressStart);
+                        const uint32_t rangeEnd = std::min((p + 1) << RDRAMPages::PageShift, addressEnd);
+                        callback(rangeStart, rangeEnd - rangeStart, preservedOffset);
+                        preservedOffset += rangeEnd - rangeStart;
+                    }
+                }
+
+                return preservedOffset;
+            };
+
+            const uint32_t preservedBytes = forEachPreservedRange([&](uint32_t address, uint32_t size, uint32_t offset) {
+                readbackPreservedRAM.resize(offset + size);
+                memcpy(&readbackPreservedRAM[offset], &RDRAM[address], size);
+            });
+
+            fb->copyNativeToRAM(&RDRAM[fb->addressStart], readback.rowWidth, readback.rowStart, readback.rowEnd);
+
+            if (preservedBytes > 0) {
+                forEachPreservedRange([&](uint32_t address, uint32_t size, uint32_t offset) {
+                    memcpy(&RDRAM[address], &readbackPreservedRAM[offset], size);
+                });
+            }
+
+            rdramCheckPages.set(fb->addressStart, fb->RAMBytes);
+            rdramScreenPages.set(fb->addressStart, fb->RAMBytes);
+
+            // The tracking of the framebuffers was already reset when the workload was submitted, so only the ones that were written are hashed.
+            fb->hashRAM(&RDRAM[fb->addressStart]);
+        }
+
+        pendingReadbacks.clear();
+        readbackDirtyPages.clear();
+        readbackResolvePending = false;
+
+        // Indicate to the texture cache it's safe to delete the textures if no locks are active.
+        ext.textureCache->decrementLock();
+
+        advanceFramebufferRenderer();
+
+        // Indicate the next time a display list is parsed, RDRAM should be checked.
+        rdramCheckPending = true;
+    }
+
+    bool State::readbacksOverlap(uint32_t address, uint32_t size) const {
+        const uint32_t addressEnd = address + size;
+        for (const PendingReadback &readback : pendingReadbacks) {
+            if ((address < (readback.address + readback.bytes)) && (readback.address < addressEnd)) {
+                return true;
+            }
+        }
+
+        return false;
+    }
+
+    bool State::readbacksOverlap(const RDRAMPages &pages) const {
+        for (const PendingReadback &readback : pendingReadbacks) {
+            if (pages.test(readback.address, readback.bytes)) {
+                return true;
+            }
+        }
+
+        return false;
+    }
+
+    void State::notifyRDRAMRead(uint32_t address, uint32_t size) {
+        if (readbackResolvePending && readbacksOverlap(address, size)) {
+            resolveReadbacks();
+        }
+    }
+
     void State::flushFramebufferOperations(FramebufferPair &fbPair) {
         if (!drawFbOperations.empty()) {
             fbPair.startFbOperations.insert(fbPair.startFbOperations.end(), drawFbOperations.begin(), drawFbOperations.end());
@@ -2370,6 +2652,8 @@ namespace RT64 {
     }
 
     void State::dumpRDRAM(const std::string &path) {
+        resolveReadbacks();
+
         FILE *fp = fopen(path.c_str(), "wb");
         fwrite(RDRAM, RDRAMSize, 1, fp);
         fclose(fp);
@@ -29,6 +29,7 @@
 #include "rt64_rdp.h"
 #include "rt64_rsp.h"
 #include "rt64_rdp_tmem.h"
+#include "rt64_readback_queue.h"
 #include "rt64_workload_queue.h"
 
 namespace RT64 {
@@ -38,6 +39,14 @@ namespace RT64 {
     const uint32_t RDRAMSize = 0x7FFFFF;
 
     struct State {
+        struct PendingReadback {
+            uint32_t address;
+            uint32_t bytes;
+            uint32_t rowWidth;
+            uint32_t rowStart;
+            uint32_t rowEnd;
+        };
+
         struct External {
             Application *app;
             ApplicationWindow *appWindow;
@@ -51,6 +60,7 @@ namespace RT64 {
             BufferUploader *tilesUploader;
             WorkloadQueue *workloadQueue;
             PresentQueue *presentQueue;
+            ReadbackQueue *readbackQueue;
             SharedQueueResources *sharedQueueResources;
             RasterShaderCache *rasterShaderCache;
             TextureCache *textureCache;
@@ -58,6 +68,8 @@ namespace RT64 {
             EnhancementConfiguration *enhancementConfig;
             UserConfiguration *userConfig;
             ProfilingTimer *dlApiProfiler;
+            ProfilingTimer *dlEmulatorProfiler;
+            ProfilingTimer *dlThreadGainProfiler;
             ProfilingTimer *screenApiProfiler;
             UserConfiguration::GraphicsAPI createdGraphicsAPI;
 #       if RT_ENABLED
@@ -71,6 +83,9 @@ namespace RT64 {
         uint8_t *RDRAM;
         uint32_t *MI_INTR_REG;
         void (*checkInterrupts)();
+        std::atomic<uint32_t> deferredInterrupts = 0;
+        bool deferInterrupts = false;
+        bool rdramWritesTracked = false;
         Microcode microcode;
         std::unique_ptr<RSP> rsp;
         std::unique_ptr<RDP> rdp;
@@ -83,6 +98,7 @@ namespace RT64 {
         std::unique_ptr<RSPProcessor> rspProcessor;
         std::vector<interop::PointLight> scriptLights;
         uint64_t workloadCounter;
+        DrawDataCapacity drawDataCapacity;
         std::vector<uint64_t> evictedTextureHashes;
         std::unique_ptr<RenderTarget> dummyDepthTarget;
         DrawCall drawCall;
@@ -96,9 +112,21 @@ namespace RT64 {
         uint32_t displayListAddress;
         uint64_t displayListCounter;
         bool rdramCheckPending;
+        RDRAMPages rdramCheckPages;
+        RDRAMPages rdramScreenPages;
+        uint32_t rdramCheckPageCount;
+        uint32_t framebufferUploadedBytes;
+        std::vector<PendingReadback> pendingReadbacks;
+        uint64_t readbackCounter;
+        bool readbackResolvePending;
+        RDRAMPages readbackDirtyPages;
+        std::vector<uint8_t> readbackPreservedRAM;
         uint32_t lastWorkloadIndex;
         VI lastScreenVI;
         uint64_t lastScreenHash;
+        uint32_t lastScreenAddress;
+        uint32_t lastScreenBytes;
+        uint32_t lastScreenFbAddress;
         uint32_t lastScreenFactorCounter;
         VIHistory viHistory;
         PresetDrawCallLibrary drawCallLibrary;
@@ -114,6 +142,7 @@ namespace RT64 {
         ProfilingTimer dlCpuProfiler = ProfilingTimer(120);
         ProfilingTimer screenCpuProfiler = ProfilingTimer(120);
         ProfilingTimer viChangedProfiler = ProfilingTimer(120);
+        ProfilingTimer readbackStallProfiler = ProfilingTimer(120);
         bool configurationSaveQueued = false;
         uint64_t workloadId = 0;
         uint64_t presentId = 0;
@@ -149,7 +178,15 @@ namespace RT64 {
         void advancePresent(Present &present, bool paused);
         void dpInterrupt();
         void spInterrupt();
+        bool raiseDeferredInterrupts();
+        void addRDRAMDirtyPages(const RDRAMPages &dirtyPages);
+        bool renderToRAMEnabled() const;
         void advanceFramebufferRenderer();
+        void waitForReadbacks();
+        void resolveReadbacks();
+        bool readbacksOverlap(uint32_t address, uint32_t size) const;
+        bool readbacksOverlap(const RDRAMPages &pages) const;
+        void notifyRDRAMRead(uint32_t address, uint32_t size);
         void flushFramebufferOperations(FramebufferPair &fbPair);
         bool hasFramebufferOperationsPending() const;
         void pushReturnAddress(DisplayList *dl);
@@ -0,0 +1,180 @@
+//
+// RT64
+//
+
+#include "rt64_tile_copy_atlas.h"
+
+#include <algorithm>
+#include <cassert>
+
+namespace RT64 {
+    // TileCopyAtlas
+
+    TileCopyAtlas::TileCopyAtlas(RenderDevice *device, uint32_t width, uint32_t height, RenderFormat format) {
+        assert(device != nullptr);
+
+        this->width = width;
+        this->height = height;
+
+        RenderTextureFlags textureFlags = RenderTextureFlag::STORAGE | RenderTextureFlag::UNORDERED_ACCESS;
+        textureFlags |= RenderTextureFlag::RENDER_TARGET;
+        texture = device->createTexture(RenderTextureDesc::Texture2D(width, height, 1, format, textureFlags));
+
+        const RenderTexture *framebufferTexture = texture.get();
+        framebuffer = device->createFramebuffer(RenderFramebufferDesc(&framebufferTexture, 1));
+    }
+
+    bool TileCopyAtlas::allocate(uint32_t rectWidth, uint32_t rectHeight, Rect &outRect) {
+        assert(rectWidth > 0);
+        assert(rectHeight > 0);
+
+        if ((rectWidth > width) || (rectHeight > height)) {
+            return false;
+        }
+
+        // Reuse the smallest released rect the new rect fits in. Tile copies are usually recreated with the same sizes every frame, so
+        // this is an exact match most of the time. The unused space is split off into new rects like a guillotine allocator would.
+        size_t bestReleased = releasedRects.size();
+        uint64_t bestReleasedArea = UINT64_MAX;
+        for (size_t i = 0; i < releasedRects.size(); i++) {
+            const Rect &released = releasedRects[i];
+            const uint64_t releasedArea = uint64_t(released.width) * uint64_t(released.height);
+            if ((released.width >= rectWidth) && (released.height >= rectHeight) && (releasedArea < bestReleasedArea)) {
+                bestReleased = i;
+                bestReleasedArea = releasedArea;
+            }
+        }
+
+        if (bestReleased < releasedRects.size()) {
+            const Rect released = releasedRects[bestReleased];
+            releasedRects[bestReleased] = releasedRects.back();
+            releasedRects.pop_back();
+
+            // Split along the axis with the most space left so the biggest of the two remaining rects is as large as possible.
+            const uint32_t leftWidth = released.width - rectWidth;
+            const uint32_t leftHeight = released.height - rectHeight;
+            const bool splitHorizontally = (leftWidth < leftHeight);
+            Rect rightRect = { released.x + rectWidth, released.y, leftWidth, splitHorizontally ? rectHeight : released.height };
+            Rect bottomRect = { released.x, released.y + rectHeight, splitHorizontally ? released.width : rectWidth, leftHeight };
+            if ((rightRect.width > 0) && (rightRect.height > 0)) {
+                releasedRects.emplace_back(rightRect);
+            }
+
+            if ((bottomRect.width > 0) && (bottomRect.height > 0)) {
+                releasedRects.emplace_back(bottomRect);
+            }
+
+            outRect = { released.x, released.y, rectWidth, rectHeight };
+            allocatedRects++;
+            return true;
+        }
+
+        // Search for the shelf that wastes the least amount of rows. Shelves that would waste more than half of the rect's height are
+        // only used if a new shelf can't be opened.
+        Shelf *bestShelf = nullptr;
+        Shelf *wastefulShelf = nullptr;
+        for (Shelf &shelf : shelves) {
+            if ((shelf.height < rectHeight) || ((width - shelf.cursorX) < rectWidth)) {
+                continue;
+            }
+
+            if ((shelf.height - rectHeight) > (rectHeight / 2)) {
+                if ((wastefulShelf == nullptr) || (shelf.height < wastefulShelf->height)) {
+                    wastefulShelf = &shelf;
+                }
+            }
+            else if ((bestShelf == nullptr) || (shelf.height < bestShelf->height)) {
+                bestShelf = &shelf;
+            }
+        }
+
+        if ((bestShelf == nullptr) && ((height - shelvesHeight) >= rectHeight)) {
+            Shelf newShelf;
+            newShelf.y = shelvesHeight;
+            newShelf.height = rectHeight;
+            shelves.emplace_back(newShelf);
+            shelvesHeight += rectHeight;
+            bestShelf = &shelves.back();
+        }
+
+        if (bestShelf == nullptr) {
+            bestShelf = wastefulShelf;
+        }
+
+        if (bestShelf == nullptr) {
+            return false;
+        }
+
+        outRect.x = bestShelf->cursorX;
+        outRect.y = bestShelf->y;
+        outRect.width = rectWidth;
+        outRect.height = rectHeight;
+        bestShelf->cursorX += rectWidth;
+        allocatedRects++;
+        return true;
+    }
+
+    void TileCopyAtlas::release(const Rect &rect) {
+        assert(allocatedRects > 0);
+
+        allocatedRects--;
+        if (allocatedRects == 0) {
+            shelves.clear();
+            releasedRects.clear();
+            shelvesHeight = 0;
+        }
+        else {
+            releasedRects.emplace_back(rect);
+        }
+    }
+
+    // TileCopyAtlasSet
+
+    TileCopyAtlas *TileCopyAtlasSet::allocate(RenderDevice *device, uint32_t rectWidth, uint32_t rectHeight, RenderFormat format, TileCopyAtlas::Rect &outRect) {
+        for (const std::unique_ptr<TileCopyAtlas> &atlas : atlases) {
+            if (atlas->allocate(rectWidth, rectHeight, outRect)) {
+                return atlas.get();
+            }
+        }
+
+        const uint32_t atlasWidth = std::max(rectWidth, uint32_t(AtlasSize));
+        const uint32_t atlasHeight = std::max(rectHeight, uint32_t(AtlasSize));
+        atlases.emplace_back(std::make_unique<TileCopyAtlas>(device, atlasWidth, atlasHeight, format));
+
+        // The new atlas is big enough to always fit the rect.
+        TileCopyAtlas *newAtlas = atlases.back().get();
+        newAtlas->allocate(rectWidth, rectHeight, outRect);
+        return newAtlas;
+    }
+
+    void TileCopyAtlasSet::release(TileCopyAtlas *atlas, const TileCopyAtlas::Rect &rect) {
+        assert(atlas != nullptr);
+
+        atlas->release(rect);
+        if (atlas->allocatedRects > 0) {
+            return;
+        }
+
+        // Keep one empty atlas of the default size around so a tile copy that is resized doesn't recreate it right away. Any other
+        // empty atlases are freed.
+        bool emptyAtlasKept = false;
+        auto it = atlases.begin();
+        while (it != atlases.end()) {
+            const TileCopyAtlas &setAtlas = *(*it);
+            if (setAtlas.allocatedRects > 0) {
+                it++;
+            }
+            else if (!emptyAtlasKept && (setAtlas.width == AtlasSize) && (setAtlas.height == AtlasSize)) {
+                emptyAtlasKept = true;
+                it++;
+            }
+            else {
+                it = atlases.erase(it);
+            }
+        }
+    }
+
+    void TileCopyAtlasSet::destroyAll() {
+        atlases.clear();
+    }
+};
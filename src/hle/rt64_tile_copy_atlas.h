@@ -0,0 +1,55 @@
+//
+// RT64
+//
+
+#pragma once
+
+#include <memory>
+#include <vector>
+
+#include "rhi/rt64_render_interface.h"
+
+namespace RT64 {
+    // Texture shared by many tile copies. Rects are packed into horizontal shelves from top to bottom. Released rects are reused by
+    // any rect that fits in them and the space left over is split off, and the shelves are discarded entirely once every rect in
+    // the atlas has been released.
+    struct TileCopyAtlas {
+        struct Rect {
+            uint32_t x = 0;
+            uint32_t y = 0;
+            uint32_t width = 0;
+            uint32_t height = 0;
+        };
+
+        struct Shelf {
+            uint32_t y = 0;
+            uint32_t height = 0;
+            uint32_t cursorX = 0;
+        };
+
+        std::unique_ptr<RenderTexture> texture;
+        std::unique_ptr<RenderFramebuffer> framebuffer;
+        uint32_t width = 0;
+        uint32_t height = 0;
+        std::vector<Shelf> shelves;
+        std::vector<Rect> releasedRects;
+        uint32_t shelvesHeight = 0;
+        uint32_t allocatedRects = 0;
+
+        TileCopyAtlas(RenderDevice *device, uint32_t width, uint32_t height, RenderFormat format);
+        bool allocate(uint32_t rectWidth, uint32_t rectHeight, Rect &outRect);
+        void release(const Rect &rect);
+    };
+
+    // Atlases of the same format. Rects that don't fit in the default size get an atlas of their own. Atlases are freed once
+    // they're empty, except for one of the default size that is kept for the next allocations.
+    struct TileCopyAtlasSet {
+        static const uint32_t AtlasSize = 2048;
+
+        std::vector<std::unique_ptr<TileCopyAtlas>> atlases;
+
+        TileCopyAtlas *allocate(RenderDevice *device, uint32_t rectWidth, uint32_t rectHeight, RenderFormat format, TileCopyAtlas::Rect &outRect);
+        void release(TileCopyAtlas *atlas, const TileCopyAtlas::Rect &rect);
+        void destroyAll();
+    };
+};
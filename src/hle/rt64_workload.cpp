@@ -4,6 +4,8 @@
 
 #include "rt64_workload.h"
 
+#include <algorithm>
+
 namespace RT64 {
     // Common functions.
 
@@ -11,6 +13,60 @@ namespace RT64 {
         return (value + powerOf2Alignment - 1) & ~(powerOf2Alignment - 1);
     }
 
+    // DrawDataCapacity
+
+    void DrawDataCapacity::update(DrawData &drawData, const std::vector<size_t> &reservedCapacities) {
+        uint32_t vectorIndex = 0;
+        growthAllocations = 0;
+        drawData.forEachVector([&](const auto &vector) {
+            if (vectorIndex >= highWaterMarks.size()) {
+                highWaterMarks.resize(vectorIndex + 1, 0);
+            }
+
+            size_t &highWaterMark = highWaterMarks[vectorIndex];
+            const size_t size = vector.size();
+            if (size >= highWaterMark) {
+                highWaterMark = size;
+            }
+            else {
+                highWaterMark -= (highWaterMark - size) >> DecayShift;
+            }
+
+            // Any vector that ended up with more capacity than it was reserved with had to be reallocated while it was filled.
+            if ((vectorIndex < reservedCapacities.size()) && (vector.capacity() > reservedCapacities[vectorIndex])) {
+                growthAllocations++;
+            }
+
+            vectorIndex++;
+        });
+    }
+
+    void DrawDataCapacity::reserve(DrawData &drawData, std::vector<size_t> &reservedCapacities) {
+        uint32_t vectorIndex = 0;
+        reserveAllocations = 0;
+        reservedCapacities.resize(highWaterMarks.size());
+        drawData.forEachVector([&](auto &vector) {
+            if (vectorIndex >= highWaterMarks.size()) {
+                return;
+            }
+
+            // Leave some headroom on top of the high-water mark so small increases don't cause a reallocation.
+            const size_t targetCapacity = highWaterMarks[vectorIndex] + (highWaterMarks[vectorIndex] / 8);
+            if (vector.capacity() < targetCapacity) {
+                vector.reserve(targetCapacity);
+                reserveAllocations++;
+            }
+            else if (vector.capacity() > (std::max(targetCapacity, size_t(1024)) * ShrinkFactor)) {
+                vector.shrink_to_fit();
+                vector.reserve(targetCapacity);
+                reserveAllocations++;
+            }
+
+            reservedCapacities[vectorIndex] = vector.capacity();
+            vectorIndex++;
+        });
+    }
+
     // Workload
 
     void Workload::reset() {
@@ -280,6 +336,15 @@ namespace RT64 {
         this->submissionFrame = submissionFrame;
     }
 
+    void Workload::begin(uint64_t submissionFrame, DrawDataCapacity &drawDataCapacity) {
+        // The sizes of the draw data are still intact from the last time this workload was used.
+        drawDataCapacity.update(drawData, drawDataCapacities);
+
+        begin(submissionFrame);
+
+        drawDataCapacity.reserve(drawData, drawDataCapacities);
+    }
+
     bool Workload::addFramebufferPair(uint32_t colorAddress, uint8_t colorFmt, uint8_t colorSiz, uint16_t colorWidth, uint32_t depthAddress) {
         uint32_t fbPairIndex;
         bool addedPair = false;
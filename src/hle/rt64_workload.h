@@ -74,6 +74,60 @@ namespace RT64 {
         std::vector<uint32_t> worldTransformPhysicalAddresses;
         std::vector<uint32_t> worldTransformVertexIndices;
 
+        // Calls the callback with every vector in the draw data.
+        template<typename T>
+        void forEachVector(T &&callback) {
+            callback(posShorts);
+            callback(velShorts);
+            callback(tcFloats);
+            callback(normColBytes);
+            callback(viewProjIndices);
+            callback(worldIndices);
+            callback(fogIndices);
+            callback(lightIndices);
+            callback(lightCounts);
+            callback(lookAtIndices);
+            callback(faceIndices);
+            callback(modifyPosUints);
+            callback(posTransformed);
+            callback(posScreen);
+            callback(rdpParams);
+            callback(extraParams);
+            callback(renderParams);
+            callback(viewTransforms);
+            callback(projTransforms);
+            callback(viewProjTransforms);
+            callback(modViewTransforms);
+            callback(modProjTransforms);
+            callback(modViewProjTransforms);
+            callback(prevViewTransforms);
+            callback(prevProjTransforms);
+            callback(prevViewProjTransforms);
+            callback(worldTransforms);
+            callback(prevWorldTransforms);
+            callback(invTWorldTransforms);
+            callback(lerpWorldTransforms);
+            callback(rdpTiles);
+            callback(lerpRdpTiles);
+            callback(gpuTiles);
+            callback(callTiles);
+            callback(rspViewports);
+            callback(viewportOrigins);
+            callback(rspFog);
+            callback(rspLights);
+            callback(rspLookAt);
+            callback(loadOperations);
+            callback(triPosFloats);
+            callback(triTcFloats);
+            callback(triColorFloats);
+            callback(transformGroups);
+            callback(worldTransformGroups);
+            callback(viewProjTransformGroups);
+            callback(worldTransformSegmentedAddresses);
+            callback(worldTransformPhysicalAddresses);
+            callback(worldTransformVertexIndices);
+        }
+
         uint32_t vertexCount() const {
             return uint32_t(worldIndices.size());
         }
@@ -96,6 +150,23 @@ namespace RT64 {
         }
     };
 
+    // Keeps a decaying high-water mark of the size of every vector in the draw data, so the vectors of a workload can be reserved
+    // when it begins instead of being grown while the display lists are processed.
+    struct DrawDataCapacity {
+        // The high-water mark moves 1 / 2^DecayShift of the way towards the last size when the size is lower.
+        static const uint32_t DecayShift = 4;
+
+        // Vectors are only shrunk when their capacity is this many times bigger than the high-water mark.
+        static const uint32_t ShrinkFactor = 4;
+
+        std::vector<size_t> highWaterMarks;
+        uint32_t reserveAllocations = 0;
+        uint32_t growthAllocations = 0;
+
+        void update(DrawData &drawData, const std::vector<size_t> &reservedCapacities);
+        void reserve(DrawData &drawData, std::vector<size_t> &reservedCapacities);
+    };
+
     struct DrawRanges {
         typedef std::pair<size_t, size_t> Range;
 
@@ -216,8 +287,10 @@ namespace RT64 {
         std::multimap<uint32_t, uint32_t> transformIdMap;
         std::multimap<uint32_t, uint32_t> physicalAddressTransformMap;
         std::vector<uint32_t> transformIgnoredIds;
+        std::vector<size_t> drawDataCapacities;
         uint64_t workloadId = 0;
         uint64_t presentId = 0;
+        uint64_t readbackCounter = 0;
         bool paused = false;
 
         struct {
@@ -235,6 +308,7 @@ namespace RT64 {
         void updateOutputBuffers(RenderWorker *worker);
         void nextDrawDataRanges();
         void begin(uint64_t submissionFrame);
+        void begin(uint64_t submissionFrame, DrawDataCapacity &drawDataCapacity);
         bool addFramebufferPair(uint32_t colorAddress, uint8_t colorFmt, uint8_t colorSiz, uint16_t colorWidth, uint32_t depthAddress);
         int currentFramebufferPairIndex() const;
     };
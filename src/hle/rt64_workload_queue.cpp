@@ -103,7 +103,10 @@ namespace RT64 {
 
         rspProcessor = std::make_unique<RSPProcessor>(ext.device);
         vertexProcessor = std::make_unique<VertexProcessor>(ext.device);
-        framebufferRenderer = std::make_unique<FramebufferRenderer>(ext.workloadGraphicsWorker, true, ext.createdGraphicsAPI, ext.shaderLibrary);
+
+        // Framebuffers are recorded in parallel on a small portion of the system's available threads, as the shader compilation threads already use half of them.
+        const uint32_t recordingThreads = std::max(std::thread::hardware_concurrency() / 4U, 1U);
+        framebufferRenderer = std::make_unique<FramebufferRenderer>(ext.workloadGraphicsWorker, true, ext.createdGraphicsAPI, ext.shaderLibrary, recordingThreads);
         renderFramebufferManager = std::make_unique<RenderFramebufferManager>(ext.device);
 
         projectionProcessor.setup(ext.workloadGraphicsWorker);
@@ -759,8 +762,10 @@ namespace RT64 {
                     fbPair.endFbOperations, targetManager, fixedResScale, f, workload.submissionFrame);
             }
 
+            framebufferRenderer->waitForRecordings();
             ext.workloadGraphicsWorker->commandList->end();
             framebufferRenderer->waitForUploaders();
+            ext.textureCache->queueWaitForGPUUploads(ext.workloadGraphicsWorker->commandQueue.get());
             ext.workloadGraphicsWorker->execute();
             ext.workloadGraphicsWorker->wait();
             workerMutex.unlock();
@@ -822,6 +827,9 @@ namespace RT64 {
                 const Workload &workload = workloads[processCursor];
                 ext.presentQueue->waitForPresentId(workload.presentId);
 
+                // The buffers of the workload can't be used until the GPU is done with any readbacks that were deferred.
+                ext.readbackQueue->wait(workload.readbackCounter);
+
                 if (!threadsRunning) {
                     continue;
                 }
@@ -1105,7 +1113,6 @@ namespace RT64 {
         Thread::setCurrentThreadName("RT64 Idle");
 
         const ShaderRecord &idle = ext.shaderLibrary->idle;
-        RenderCommandList *commandList = ext.workloadGraphicsWorker->commandList.get();
         while (threadsRunning) {
             {
                 std::unique_lock<std::mutex> idleLock(idleMutex);
@@ -1116,6 +1123,7 @@ namespace RT64 {
 
             if (threadsRunning) {
                 if (workerMutex.try_lock()) {
+                    RenderCommandList *commandList = ext.workloadGraphicsWorker->commandList;
                     commandList->begin();
                     commandList->setPipeline(idle.pipeline.get());
                     commandList->setComputePipelineLayout(idle.pipelineLayout.get());
@@ -15,6 +15,7 @@
 #include "render/rt64_tile_processor.h"
 #include "render/rt64_transform_processor.h"
 
+#include "rt64_readback_queue.h"
 #include "rt64_shared_queue_resources.h"
 #include "rt64_workload.h"
 
@@ -34,6 +35,7 @@ namespace RT64 {
             BufferUploader *workloadVelocityUploader = nullptr;
             BufferUploader *workloadTilesUploader = nullptr;
             PresentQueue *presentQueue = nullptr;
+            ReadbackQueue *readbackQueue = nullptr;
             SharedQueueResources *sharedResources = nullptr;
             RasterShaderCache *rasterShaderCache = nullptr;
             TextureCache *textureCache = nullptr;
@@ -57,7 +57,7 @@ namespace RT64 {
         BufferUploader(RenderDevice *device);
         ~BufferUploader();
         void threadLoop();
-        void threadUpload(const Upload &upload);
+        static void threadUpload(const Upload &upload);
         void updateResources(RenderWorker *worker, std::vector<Upload> &blankUploads); // Upload data does not need to be filled in with valid data, only the sizes.
         void commandListBeforeBarriers(RenderWorker *worker);
         void commandListCopyResources(RenderWorker *worker);
@@ -48,20 +48,6 @@ namespace RT64 {
         }
     };
 
-    struct FramebufferClearChangesDescriptorSet : RenderDescriptorSetBase {
-        uint32_t gOutputCount;
-
-        FramebufferClearChangesDescriptorSet(RenderDevice *device = nullptr) {
-            builder.begin();
-            gOutputCount = builder.addReadWriteStructuredBuffer(0);
-            builder.end();
-
-            if (device != nullptr) {
-                create(device);
-            }
-        }
-    };
-
     struct FramebufferDrawChangesDescriptorSet : RenderDescriptorSetBase {
         uint32_t gColor;
         uint32_t gDepth;
@@ -83,13 +69,11 @@ namespace RT64 {
     struct FramebufferReadChangesDescriptorBufferSet : RenderDescriptorSetBase {
         uint32_t gNewInput;
         uint32_t gCurInput;
-        uint32_t gOutputCount;
 
         FramebufferReadChangesDescriptorBufferSet(RenderDevice *device = nullptr) {
             builder.begin();
             gNewInput = builder.addFormattedBuffer(1);
             gCurInput = builder.addFormattedBuffer(2);
-            gOutputCount = builder.addReadWriteStructuredBuffer(3);
             builder.end();
 
             if (device != nullptr) {
@@ -437,12 +421,14 @@ namespace RT64 {
         uint32_t gInputColor;
         uint32_t gInputTLUT;
         uint32_t gOutput;
+        uint32_t gRegions;
 
         ReinterpretDescriptorSet(RenderDevice *device = nullptr) {
             builder.begin();
             gInputColor = builder.addTexture(1);
             gInputTLUT = builder.addTexture(2);
             gOutput = builder.addReadWriteTexture(3);
+            gRegions = builder.addStructuredBuffer(4);
             builder.end();
 
             if (device != nullptr) {
@@ -8,6 +8,7 @@
 
 #include "common/rt64_elapsed_timer.h"
 #include "common/rt64_math.h"
+#include "common/rt64_thread.h"
 #include "hle/rt64_color_converter.h"
 #include "gbi/rt64_f3d.h"
 #include "shared/rt64_framebuffer_params.h"
@@ -150,13 +151,77 @@ namespace RT64 {
         return hlslpp::normalize(viewI[2].xyz);
     }
 
+    static bool isBatchableDrawCall(const InstanceDrawCall &drawCall) {
+        switch (drawCall.type) {
+        case InstanceDrawCall::Type::IndexedTriangles:
+        case InstanceDrawCall::Type::RawTriangles:
+        case InstanceDrawCall::Type::RegularRect:
+            return !drawCall.triangles.viewport.isEmpty() && !drawCall.triangles.postBlendDitherNoise;
+        default:
+            return false;
+        }
+    }
+
+    static bool isBatchCompatible(const InstanceDrawCall &first, const InstanceDrawCall &next) {
+        if (first.type != next.type) {
+            return false;
+        }
+
+        const auto &a = first.triangles;
+        const auto &b = next.triangles;
+        if ((a.pipeline != b.pipeline) || (a.viewport != b.viewport) || (a.scissor != b.scissor)) {
+            return false;
+        }
+
+        if ((first.type == InstanceDrawCall::Type::IndexedTriangles) && (a.vertexTestZ != b.vertexTestZ)) {
+            return false;
+        }
+
+        // Calls must require the same kind of depth access, as switching it in between them would start a new pass.
+        const interop::OtherMode aOtherMode = a.shaderDesc.otherMode;
+        const interop::OtherMode bOtherMode = b.shaderDesc.otherMode;
+        const bool aDepthDecal = (aOtherMode.zMode() == ZMODE_DEC);
+        const bool bDepthDecal = (bOtherMode.zMode() == ZMODE_DEC);
+        const bool aDepthWrite = !aDepthDecal && aOtherMode.zUpd();
+        const bool bDepthWrite = !bDepthDecal && bOtherMode.zUpd();
+        return (aDepthDecal == bDepthDecal) && (aDepthWrite == bDepthWrite);
+    }
+
+    // Must match the depth access switches performed by submitRasterScene.
+    static RasterScene::DepthAccess depthAccessFromDrawCall(const InstanceDrawCall &drawCall) {
+        switch (drawCall.type) {
+        case InstanceDrawCall::Type::IndexedTriangles:
+        case InstanceDrawCall::Type::RawTriangles:
+        case InstanceDrawCall::Type::RegularRect: {
+            if (drawCall.triangles.viewport.isEmpty()) {
+                return RasterScene::DepthAccess::None;
+            }
+
+            const interop::OtherMode otherMode = drawCall.triangles.shaderDesc.otherMode;
+            if (otherMode.zMode() == ZMODE_DEC) {
+                return RasterScene::DepthAccess::Read;
+            }
+            else if (otherMode.zUpd()) {
+                return RasterScene::DepthAccess::Write;
+            }
+            else {
+                return RasterScene::DepthAccess::None;
+            }
+        }
+        case InstanceDrawCall::Type::VertexTestZ:
+            return RasterScene::DepthAccess::Read;
+        default:
+            return RasterScene::DepthAccess::None;
+        }
+    }
+
     // RasterScene
 
     RasterScene::RasterScene() { }
 
     // FramebufferRenderer
     
-    FramebufferRenderer::FramebufferRenderer(RenderWorker *worker, bool rtSupport, UserConfiguration::GraphicsAPI graphicsAPI, const ShaderLibrary *shaderLibrary) {
+    FramebufferRenderer::FramebufferRenderer(RenderWorker *worker, bool rtSupport, UserConfiguration::GraphicsAPI graphicsAPI, const ShaderLibrary *shaderLibrary, uint32_t recordingThreadCount) {
         assert(worker != nullptr);
 
         this->shaderLibrary = shaderLibrary;
@@ -164,6 +229,7 @@ namespace RT64 {
         frameParams.frameCount = 0;
         frameParams.viewUbershaders = false;
         frameParams.ditherNoiseStrength = 1.0f;
+        multiDrawIndirect = worker->device->getCapabilities().multiDrawIndirect;
 
         shaderUploader = std::make_unique<BufferUploader>(worker->device);
         descCommonSet = std::make_unique<FramebufferRendererDescriptorCommonSet>(shaderLibrary->linearClampSampler.get(), shaderLibrary->linearMirrorSampler.get(), worker->device->getCapabilities().raytracing, worker->device);
@@ -174,9 +240,25 @@ namespace RT64 {
             rtResources = std::make_unique<RaytracingResources>(worker, graphicsAPI);
     }
 #   endif
+
+        recordingThreadsRunning = true;
+        for (uint32_t t = 0; t < recordingThreadCount; t++) {
+            recordingThreads.emplace_back(std::make_unique<std::thread>(&FramebufferRenderer::recordingThreadLoop, this));
+        }
     }
 
     FramebufferRenderer::~FramebufferRenderer() {
+        {
+            std::unique_lock<std::mutex> recordingLock(recordingMutex);
+            recordingThreadsRunning = false;
+        }
+
+        recordingQueueChanged.notify_all();
+        for (std::unique_ptr<std::thread> &thread : recordingThreads) {
+            thread->join();
+        }
+
+        recordingThreads.clear();
         dummyDepthTargetView.reset();
         dummyDepthTarget.reset();
     }
@@ -185,6 +267,10 @@ namespace RT64 {
         instanceDrawCallVector.clear();
         renderIndicesVector.clear();
         rspSmoothNormalVector.clear();
+        drawArgumentsVector.clear();
+        drawIndexedArgumentsVector.clear();
+        stats = frameStats;
+        frameStats = Stats();
         frameParams.viewUbershaders = ubershadersVisible;
         frameParams.ditherNoiseStrength = ditherNoiseStrength;
         framebufferCount = 0;
@@ -215,12 +301,32 @@ namespace RT64 {
 #endif
 
     void FramebufferRenderer::updateTextureCache(TextureCache *textureCache) {
-        const std::unique_lock<std::mutex> textureMapLock(textureCache->textureMapMutex);
-        textureCacheVersions = textureCache->textureMap.versions;
-        textureCacheTextures = textureCache->textureMap.textures;
-        textureCacheFreeSpaces = textureCache->textureMap.freeSpaces;
+        textureCacheChanges.clear();
+
+        {
+            const std::unique_lock<std::mutex> textureMapLock(textureCache->textureMapMutex);
+            const TextureMap &textureMap = textureCache->textureMap;
+            if (!textureMap.readChanges(textureCacheChangeCursor, textureCacheChanges)) {
+                // The renderer fell too far behind the change log, so every texture in the map must be written again.
+                textureCacheTextures = textureMap.textures;
+                textureCacheDirtyIndices.clear();
+                for (uint32_t i = 0; i < textureCacheTextures.size(); i++) {
+                    textureCacheDirtyIndices.emplace_back(i);
+                }
+            }
+
+            textureCacheTextures.resize(textureMap.getMaxIndex(), nullptr);
+        }
+
+        // Evicted textures don't need their descriptors to be written, as no tiles can refer to their slots anymore.
+        for (const TextureMap::Change &change : textureCacheChanges) {
+            textureCacheTextures[change.index] = change.texture;
+            if (change.texture != nullptr) {
+                textureCacheDirtyIndices.emplace_back(change.index);
+            }
+        }
+
         textureCacheSize = static_cast<uint32_t>(textureCacheTextures.size());
-        textureCacheGlobalVersion = textureCache->textureMap.globalVersion;
         dynamicTextureViewVector.clear();
         dynamicTextureBarrierVector.clear();
     }
@@ -245,6 +351,8 @@ namespace RT64 {
                     gpuTile.ulScale.y = tileCopy.ulScaleT ? gpuTile.tcScale.y : 1.0f;
                     gpuTile.texelShift = tileCopy.texelShift;
                     gpuTile.texelMask = tileCopy.texelMask;
+                    gpuTile.texelOffset = { tileCopy.atlasRect.x, tileCopy.atlasRect.y };
+                    gpuTile.texelLimit = { tileCopy.textureWidth, tileCopy.textureHeight };
                     gpuTile.textureIndex = getTextureIndex(tileCopy);
                     gpuTile.flags.alphaIsCvg = !callTile.reinterpretTile;
                     gpuTile.flags.highRes = true;
@@ -263,6 +371,8 @@ namespace RT64 {
                 gpuTile.ulScale.y = 1.0f;
                 gpuTile.texelShift = { 0, 0 };
                 gpuTile.texelMask = { UINT_MAX, UINT_MAX };
+                gpuTile.texelOffset = { 0, 0 };
+                gpuTile.texelLimit = { UINT_MAX, UINT_MAX };
                 gpuTile.textureIndex = textureIndex;
                 gpuTile.flags.alphaIsCvg = false;
                 gpuTile.flags.highRes = false;
@@ -272,16 +382,9 @@ namespace RT64 {
     }
 
     uint32_t FramebufferRenderer::getDestinationIndex() {
-        uint32_t dstIndex;
-        if (textureCacheFreeSpaces.empty()) {
-            dstIndex = textureCacheSize++;
-        }
-        else {
-            dstIndex = textureCacheFreeSpaces.back();
-            textureCacheFreeSpaces.pop_back();
-        }
-
-        return dstIndex;
+        // Dynamic views are placed past the end of the texture cache. Any texture that is added to these slots later is always
+        // present in the change log, so the descriptors overwritten by the views are guaranteed to be written again.
+        return textureCacheSize++;
     }
     
     uint32_t FramebufferRenderer::getTextureIndex(RenderTarget *renderTarget) {
@@ -293,11 +396,11 @@ namespace RT64 {
     }
     
     uint32_t FramebufferRenderer::getTextureIndex(const FramebufferManager::TileCopy &tileCopy) {
-        assert(tileCopy.texture != nullptr);
+        assert(tileCopy.atlas != nullptr);
 
         uint32_t dstIndex = getDestinationIndex();
-        dynamicTextureViewVector.emplace_back(DynamicTextureView{ tileCopy.texture.get(), dstIndex, nullptr });
-        dynamicTextureBarrierVector.emplace_back(RenderTextureBarrier(tileCopy.texture.get(), RenderTextureLayout::SHADER_READ));
+        dynamicTextureViewVector.emplace_back(DynamicTextureView{ tileCopy.atlas->texture.get(), dstIndex, nullptr });
+        dynamicTextureBarrierVector.emplace_back(RenderTextureBarrier(tileCopy.atlas->texture.get(), RenderTextureLayout::SHADER_READ));
         return dstIndex;
     }
     
@@ -305,10 +408,15 @@ namespace RT64 {
         assert(worker != nullptr);
         assert(drawBuffers != nullptr);
         
+        // The set doubles its size when it grows so the cost of writing the resident textures to the new set is amortized.
         if ((descTextureSet == nullptr) || (descTextureSet->textureCacheSize < (textureCacheSize + 1))) {
-            descTextureSet = std::make_unique<FramebufferRendererDescriptorTextureSet>(worker->device, ((textureCacheSize + 1) * 3) / 2);
-            descriptorTextureVersions.clear();
-            descriptorTextureGlobalVersion = 0;
+            const uint32_t previousSize = (descTextureSet != nullptr) ? descTextureSet->textureCacheSize : 0;
+            const uint32_t newSize = std::max(((textureCacheSize + 1) * 3) / 2, previousSize * 2);
+            descTextureSet = std::make_unique<FramebufferRendererDescriptorTextureSet>(worker->device, newSize);
+            textureCacheDirtyIndices.clear();
+            for (uint32_t i = 0; i < textureCacheTextures.size(); i++) {
+                textureCacheDirtyIndices.emplace_back(i);
+            }
         }
 
 #   if RT_ENABLED
@@ -368,36 +476,25 @@ namespace RT64 {
         descCommonSet->setBuffer(descCommonSet->GPUTiles, drawBuffers->gpuTilesBuffer.get(), RenderBufferStructuredView(sizeof(interop::GPUTile)));
         descCommonSet->setBuffer(descCommonSet->DynamicRenderParams, drawBuffers->renderParamsBuffer.get(), RenderBufferStructuredView(sizeof(interop::RenderParams)));
 
-        // Make sure the versions vector matches the texture cache size.
-        descriptorTextureVersions.resize(textureCacheSize, 0);
-
-        // Update texture vector with static textures from the cache and dynamic resource views.
-        if (descriptorTextureGlobalVersion != textureCacheGlobalVersion) {
-            const uint32_t textureVersionSize = static_cast<uint32_t>(textureCacheVersions.size());
-            for (uint32_t i = 0; i < textureVersionSize; i++) {
-                if (textureCacheVersions[i] == descriptorTextureVersions[i]) {
-                    continue;
-                }
-
-                descriptorTextureVersions[i] = textureCacheVersions[i];
-                if (textureCacheTextures[i] == nullptr) {
-                    continue;
-                }
-
-                if (textureCacheTextures[i]->texture == nullptr) {
-                    descTextureSet->setTexture(i, textureCacheTextures[i]->tmem.get(), RenderTextureLayout::SHADER_READ);
-                }
-                else {
-                    descTextureSet->setTexture(i, textureCacheTextures[i]->texture.get(), RenderTextureLayout::SHADER_READ);
-                }
+        // Update texture vector with the textures that changed in the cache and the dynamic resource views.
+        for (uint32_t textureIndex : textureCacheDirtyIndices) {
+            const Texture *texture = textureCacheTextures[textureIndex];
+            if (texture == nullptr) {
+                continue;
             }
 
-            descriptorTextureGlobalVersion = textureCacheGlobalVersion;
+            if (texture->texture == nullptr) {
+                descTextureSet->setTexture(textureIndex, texture->tmem.get(), RenderTextureLayout::SHADER_READ);
+            }
+            else {
+                descTextureSet->setTexture(textureIndex, texture->texture.get(), RenderTextureLayout::SHADER_READ);
+            }
         }
 
+        textureCacheDirtyIndices.clear();
+
         for (const DynamicTextureView &dynamicView : dynamicTextureViewVector) {
             descTextureSet->setTexture(dynamicView.dstIndex, dynamicView.texture, RenderTextureLayout::SHADER_READ, dynamicView.textureView);
-            descriptorTextureVersions[dynamicView.dstIndex] = 0;
         }
     }
 
@@ -438,7 +535,7 @@ namespace RT64 {
 #   endif
     }
 
-    bool FramebufferRenderer::submitDepthAccess(RenderWorker *worker, RenderFramebufferStorage *fbStorage, bool readOnly, bool &depthState) {
+    bool FramebufferRenderer::submitDepthAccess(RenderCommandList *commandList, RenderFramebufferStorage *fbStorage, bool readOnly, bool &depthState, Stats &recordStats) {
         if (depthState == readOnly) {
             return false;
         }
@@ -446,13 +543,15 @@ namespace RT64 {
         RenderFramebuffer *renderFramebuffer = readOnly ? fbStorage->colorWriteDepthRead.get() : fbStorage->colorDepthWrite.get();
         const RenderTextureLayout depthReadState = RenderTextureLayout::DEPTH_READ;
         const RenderTextureLayout depthWriteState = RenderTextureLayout::DEPTH_WRITE;
-        worker->commandList->barriers(RenderBarrierStage::GRAPHICS, RenderTextureBarrier(fbStorage->depthTarget->texture.get(), readOnly ? depthReadState : RenderTextureLayout::DEPTH_WRITE));
-        worker->commandList->setFramebuffer(renderFramebuffer);
+        commandList->barriers(RenderBarrierStage::GRAPHICS, RenderTextureBarrier(fbStorage->depthTarget->texture.get(), readOnly ? depthReadState : RenderTextureLayout::DEPTH_WRITE));
+        commandList->setFramebuffer(renderFramebuffer);
         depthState = readOnly;
+        recordStats.renderPasses++;
+        recordStats.depthTransitions++;
         return true;
     }
     
-    void FramebufferRenderer::submitRasterScene(RenderWorker *worker, const Framebuffer &framebuffer, RenderFramebufferStorage *fbStorage, const RasterScene &rasterScene, bool &depthState) {
+    void FramebufferRenderer::submitRasterScene(RenderCommandList *commandList, const Framebuffer &framebuffer, RenderFramebufferStorage *fbStorage, const RasterScene &rasterScene, bool &depthState, Stats &recordStats) {
         InstanceDrawCall::Type previousCallType = InstanceDrawCall::Type::Unknown;
         bool previousVertexTestZ = false;
         const RenderPipeline *previousPipeline = nullptr;
@@ -468,37 +567,58 @@ namespace RT64 {
             previousPipeline = nullptr;
             previousViewport = RenderViewport();
             previousScissor = RenderRect();
-            worker->commandList->setGraphicsPipelineLayout(rendererPipelineLayout);
-            worker->commandList->setGraphicsDescriptorSet(descCommonSet->get(), 0);
-            worker->commandList->setGraphicsDescriptorSet(descTextureSet->get(), 1);
-            worker->commandList->setGraphicsDescriptorSet(descTextureSet->get(), 2);
-            worker->commandList->setGraphicsDescriptorSet(depthState ? descRealFbSet : descDummyFbSet, 3);
+            commandList->setGraphicsPipelineLayout(rendererPipelineLayout);
+            commandList->setVertexBuffers(3, &renderIndexInstanceView, 1, &vertexInputSlots[3]);
+            commandList->setGraphicsDescriptorSet(descCommonSet->get(), 0);
+            commandList->setGraphicsDescriptorSet(descTextureSet->get(), 1);
+            commandList->setGraphicsDescriptorSet(descTextureSet->get(), 2);
+            commandList->setGraphicsDescriptorSet(depthState ? descRealFbSet : descDummyFbSet, 3);
         };
 
         auto switchToDepthRead = [&]() {
-            if (submitDepthAccess(worker, fbStorage, true, depthState)) {
-                worker->commandList->setGraphicsDescriptorSet(descRealFbSet, 3);
+            if (submitDepthAccess(commandList, fbStorage, true, depthState, recordStats)) {
+                commandList->setGraphicsDescriptorSet(descRealFbSet, 3);
             }
         };
 
         auto switchToDepthWrite = [&]() {
-            if (submitDepthAccess(worker, fbStorage, false, depthState)) {
-                worker->commandList->setGraphicsDescriptorSet(descDummyFbSet, 3);
+            if (submitDepthAccess(commandList, fbStorage, false, depthState, recordStats)) {
+                commandList->setGraphicsDescriptorSet(descDummyFbSet, 3);
+            }
+        };
+
+        // The render index is sourced from the instance buffer through the start instance of the draw.
+        auto drawCallTriangles = [&](const InstanceDrawCall &drawCall, uint32_t renderIndex) {
+            if (drawCall.type == InstanceDrawCall::Type::IndexedTriangles) {
+                commandList->drawIndexedInstanced(drawCall.triangles.faceCount * 3, 1, drawCall.triangles.indexStart, 0, renderIndex);
+            }
+            else {
+                commandList->drawInstanced(drawCall.triangles.faceCount * 3, 1, drawCall.triangles.indexStart, renderIndex);
             }
+
+            recordStats.rasterDraws++;
         };
 
-        auto drawCallTriangles = [&](const InstanceDrawCall &drawCall) {
+        auto drawBatchTriangles = [&](const InstanceDrawCall &drawCall, const RasterScene::Batch &batch) {
             if (drawCall.type == InstanceDrawCall::Type::IndexedTriangles) {
-                worker->commandList->drawIndexedInstanced(drawCall.triangles.faceCount * 3, 1, drawCall.triangles.indexStart, 0, 0);
+                const uint64_t argumentOffset = batch.argumentStart * sizeof(RenderDrawIndexedIndirectArguments);
+                commandList->drawIndexedInstancedIndirect(RenderBufferReference(drawIndexedArgumentsBuffer.get(), argumentOffset), batch.instanceCount);
             }
             else {
-                worker->commandList->drawInstanced(drawCall.triangles.faceCount * 3, 1, drawCall.triangles.indexStart, 0);
+                const uint64_t argumentOffset = batch.argumentStart * sizeof(RenderDrawIndirectArguments);
+                commandList->drawInstancedIndirect(RenderBufferReference(drawArgumentsBuffer.get(), argumentOffset), batch.instanceCount);
             }
+
+            recordStats.rasterDraws++;
         };
 
         switchToGraphicsPipeline();
         
-        for (uint32_t i : rasterScene.instanceIndices) {
+        uint32_t batchCursor = 0;
+        const uint32_t batchCount = uint32_t(rasterScene.batches.size());
+        const uint32_t sceneInstanceCount = uint32_t(rasterScene.instanceIndices.size());
+        for (uint32_t k = 0; k < sceneInstanceCount; k++) {
+            const uint32_t i = rasterScene.instanceIndices[k];
             const InstanceDrawCall &drawCall = instanceDrawCallVector[i];
             switch (drawCall.type) {
             case InstanceDrawCall::Type::IndexedTriangles: 
@@ -509,14 +629,14 @@ namespace RT64 {
                 if (typeDifferent || testZDifferent) {
                     switch (drawCall.type) {
                     case InstanceDrawCall::Type::IndexedTriangles:
-                        worker->commandList->setVertexBuffers(0, indexedVertexViews.data(), uint32_t(indexedVertexViews.size()), vertexInputSlots.data());
-                        worker->commandList->setIndexBuffer(drawCall.triangles.vertexTestZ ? &testZIndexBufferView : &indexBufferView);
+                        commandList->setVertexBuffers(0, indexedVertexViews.data(), uint32_t(indexedVertexViews.size()), vertexInputSlots.data());
+                        commandList->setIndexBuffer(drawCall.triangles.vertexTestZ ? &testZIndexBufferView : &indexBufferView);
                         previousVertexTestZ = drawCall.triangles.vertexTestZ;
                         break;
                     case InstanceDrawCall::Type::RawTriangles:
                     case InstanceDrawCall::Type::RegularRect:
-                        worker->commandList->setVertexBuffers(0, rawVertexViews.data(), uint32_t(rawVertexViews.size()), vertexInputSlots.data());
-                        worker->commandList->setIndexBuffer(nullptr);
+                        commandList->setVertexBuffers(0, rawVertexViews.data(), uint32_t(rawVertexViews.size()), vertexInputSlots.data());
+                        commandList->setIndexBuffer(nullptr);
                         break;
                     default:
                         assert(false && "Unknown draw call type.");
@@ -547,29 +667,42 @@ namespace RT64 {
                 
                 if (previousViewport != triangles.viewport) {
                     rasterParams.halfPixelOffset = { 1.0f / triangles.viewport.width, -1.0f / triangles.viewport.height};
-                    worker->commandList->setViewports(triangles.viewport);
+                    commandList->setGraphicsPushConstants(0, &rasterParams);
+                    commandList->setViewports(triangles.viewport);
                     previousViewport = triangles.viewport;
                 }
 
                 if (previousScissor != triangles.scissor) {
-                    worker->commandList->setScissors(triangles.scissor);
+                    commandList->setScissors(triangles.scissor);
                     previousScissor = triangles.scissor;
                 }
 
                 if (previousPipeline != triangles.pipeline) {
-                    worker->commandList->setPipeline(triangles.pipeline);
+                    commandList->setPipeline(triangles.pipeline);
                     previousPipeline = triangles.pipeline;
                 }
                 
-                rasterParams.renderIndex = i;
-                worker->commandList->setGraphicsPushConstants(0, &rasterParams);
-                drawCallTriangles(drawCall);
+                while ((batchCursor < batchCount) && (rasterScene.batches[batchCursor].instanceStart < k)) {
+                    batchCursor++;
+                }
+
+                // Every call in the batch shares the state that was just set, so they can all be submitted at once.
+                if ((batchCursor < batchCount) && (rasterScene.batches[batchCursor].instanceStart == k)) {
+                    const RasterScene::Batch &batch = rasterScene.batches[batchCursor];
+                    drawBatchTriangles(drawCall, batch);
+                    recordStats.rasterCalls += batch.instanceCount;
+                    k += batch.instanceCount - 1;
+                    break;
+                }
+
+                drawCallTriangles(drawCall, i);
+                recordStats.rasterCalls++;
 
                 if (triangles.postBlendDitherNoise) {
-                    worker->commandList->setPipeline(postBlendDitherNoiseAddPipeline);
-                    drawCallTriangles(drawCall);
-                    worker->commandList->setPipeline(postBlendDitherNoiseSubPipeline);
-                    drawCallTriangles(drawCall);
+                    commandList->setPipeline(postBlendDitherNoiseAddPipeline);
+                    drawCallTriangles(drawCall, i);
+                    commandList->setPipeline(postBlendDitherNoiseSubPipeline);
+                    drawCallTriangles(drawCall, i);
                     previousPipeline = nullptr;
                 }
 
@@ -577,7 +710,7 @@ namespace RT64 {
             };
             case InstanceDrawCall::Type::FillRect: {
                 const auto &clearRect = drawCall.clearRect;
-                worker->commandList->clearColor(0, clearRect.color, &clearRect.rect, 1);
+                commandList->clearColor(0, clearRect.color, &clearRect.rect, 1);
                 break;
             };
             case InstanceDrawCall::Type::VertexTestZ: {
@@ -588,14 +721,14 @@ namespace RT64 {
 
                 const bool useMSAA = (fbStorage->colorTarget->multisampling.sampleCount > 0);
                 const auto &rspVertexTestZ = useMSAA ? shaderLibrary->rspVertexTestZMS : shaderLibrary->rspVertexTestZ;
-                worker->commandList->barriers(RenderBarrierStage::COMPUTE, RenderBufferBarrier(testZIndexBuffer, RenderBufferAccess::WRITE));
-                worker->commandList->setPipeline(rspVertexTestZ.pipeline.get());
-                worker->commandList->setComputePipelineLayout(rspVertexTestZ.pipelineLayout.get());
-                worker->commandList->setComputePushConstants(0, &testZCB);
-                worker->commandList->setComputeDescriptorSet(vertexTestZSet->get(), 0);
-                worker->commandList->setComputeDescriptorSet(descRealFbSet, 1);
-                worker->commandList->dispatch(1, 1, 1);
-                worker->commandList->barriers(RenderBarrierStage::GRAPHICS, RenderBufferBarrier(testZIndexBuffer, RenderBufferAccess::READ));
+                commandList->barriers(RenderBarrierStage::COMPUTE, RenderBufferBarrier(testZIndexBuffer, RenderBufferAccess::WRITE));
+                commandList->setPipeline(rspVertexTestZ.pipeline.get());
+                commandList->setComputePipelineLayout(rspVertexTestZ.pipelineLayout.get());
+                commandList->setComputePushConstants(0, &testZCB);
+                commandList->setComputeDescriptorSet(vertexTestZSet->get(), 0);
+                commandList->setComputeDescriptorSet(descRealFbSet, 1);
+                commandList->dispatch(1, 1, 1);
+                commandList->barriers(RenderBarrierStage::GRAPHICS, RenderBufferBarrier(testZIndexBuffer, RenderBufferAccess::READ));
 
                 switchToGraphicsPipeline();
                 break;
@@ -605,10 +738,65 @@ namespace RT64 {
                 break;
             }
         }
+    }
 
-        // Mark targets for resolve.
-        fbStorage->colorTarget->markForResolve();
-        fbStorage->depthTarget->markForResolve();
+    void FramebufferRenderer::buildRasterSceneBatches(RasterScene &rasterScene) {
+        rasterScene.batches.clear();
+
+        if (!multiDrawIndirect) {
+            return;
+        }
+
+        RasterScene::Batch batch;
+        const InstanceDrawCall *batchDrawCall = nullptr;
+        auto finishBatch = [&]() {
+            // Single calls are cheaper to submit as regular draws.
+            if (batch.instanceCount > 1) {
+                const bool indexed = (batchDrawCall->type == InstanceDrawCall::Type::IndexedTriangles);
+                batch.argumentStart = uint32_t(indexed ? drawIndexedArgumentsVector.size() : drawArgumentsVector.size());
+                for (uint32_t k = batch.instanceStart; k < (batch.instanceStart + batch.instanceCount); k++) {
+                    const uint32_t renderIndex = rasterScene.instanceIndices[k];
+                    const auto &triangles = instanceDrawCallVector[renderIndex].triangles;
+                    if (indexed) {
+                        RenderDrawIndexedIndirectArguments &arguments = drawIndexedArgumentsVector.emplace_back();
+                        arguments.indexCountPerInstance = triangles.faceCount * 3;
+                        arguments.instanceCount = 1;
+                        arguments.startIndexLocation = triangles.indexStart;
+                        arguments.startInstanceLocation = renderIndex;
+                    }
+                    else {
+                        RenderDrawIndirectArguments &arguments = drawArgumentsVector.emplace_back();
+                        arguments.vertexCountPerInstance = triangles.faceCount * 3;
+                        arguments.instanceCount = 1;
+                        arguments.startVertexLocation = triangles.indexStart;
+                        arguments.startInstanceLocation = renderIndex;
+                    }
+                }
+
+                rasterScene.batches.emplace_back(batch);
+            }
+
+            batchDrawCall = nullptr;
+        };
+
+        const uint32_t sceneInstanceCount = uint32_t(rasterScene.instanceIndices.size());
+        for (uint32_t k = 0; k < sceneInstanceCount; k++) {
+            const InstanceDrawCall &drawCall = instanceDrawCallVector[rasterScene.instanceIndices[k]];
+            if (!isBatchableDrawCall(drawCall)) {
+                finishBatch();
+            }
+            else if ((batchDrawCall != nullptr) && isBatchCompatible(*batchDrawCall, drawCall)) {
+                batch.instanceCount++;
+            }
+            else {
+                finishBatch();
+                batchDrawCall = &drawCall;
+                batch.instanceStart = k;
+                batch.instanceCount = 1;
+            }
+        }
+
+        finishBatch();
     }
 
     void FramebufferRenderer::updateMultisampling() {
@@ -1195,11 +1383,43 @@ namespace RT64 {
         RenderTarget *colorTarget = targetDrawCall.fbStorage->colorTarget;
         RenderTarget *depthTarget = targetDrawCall.fbStorage->depthTarget;
         startBarriers.emplace_back(RenderTextureBarrier(colorTarget->texture.get(), RenderTextureLayout::COLOR_WRITE));
-        startBarriers.emplace_back(RenderTextureBarrier(depthTarget->texture.get(), RenderTextureLayout::DEPTH_WRITE));
-        worker->commandList->barriers(RenderBarrierStage::GRAPHICS, startBarriers);
 
+        // Start with the depth access required by the first scene so the depth target doesn't need to be switched right away.
         bool depthState = false;
-        worker->commandList->setFramebuffer(targetDrawCall.fbStorage->colorDepthWrite.get());
+        if (!targetDrawCall.sceneIndices.empty() && !targetDrawCall.sceneIndices.front().second) {
+            const RasterScene &firstRasterScene = targetDrawCall.rasterScenes[targetDrawCall.sceneIndices.front().first];
+            depthState = (firstRasterScene.firstDepthAccess == RasterScene::DepthAccess::Read);
+        }
+
+        startBarriers.emplace_back(RenderTextureBarrier(depthTarget->texture.get(), depthState ? RenderTextureLayout::DEPTH_READ : RenderTextureLayout::DEPTH_WRITE));
+        worker->commandList->barriers(RenderBarrierStage::GRAPHICS, startBarriers);
+
+        if (isParallelRecordingPossible(targetDrawCall)) {
+            // The secondary command list is bound to the framebuffer here so the layouts of the targets are still the ones the scenes will
+            // be submitted with. None of the scenes require barriers, so the recording threads never modify the state of any resource.
+            RenderCommandList *secondaryCommandList = worker->getSecondaryCommandList(recordingCount);
+            secondaryCommandList->begin();
+            secondaryCommandList->setFramebuffer(targetDrawCall.fbStorage->colorDepthWrite.get());
+            frameStats.renderPasses++;
+            colorTarget->markForResolve();
+            depthTarget->markForResolve();
+
+            {
+                std::unique_lock<std::mutex> recordingLock(recordingMutex);
+                Recording &recording = recordingVector[recordingCount++];
+                recording.framebufferIndex = framebufferIndex;
+                recording.commandList = secondaryCommandList;
+                recording.stats = Stats();
+            }
+
+            recordingQueueChanged.notify_one();
+            worker->insertCommandList(secondaryCommandList);
+            return;
+        }
+
+        RenderFramebuffer *renderFramebuffer = depthState ? targetDrawCall.fbStorage->colorWriteDepthRead.get() : targetDrawCall.fbStorage->colorDepthWrite.get();
+        worker->commandList->setFramebuffer(renderFramebuffer);
+        frameStats.renderPasses++;
         for (const auto pair : targetDrawCall.sceneIndices) {
 #       if RT_ENABLED
             if (pair.second) {
@@ -1220,11 +1440,14 @@ namespace RT64 {
 
                     RenderFramebufferStorage *fbStorage = rtResources->interleavedFramebufferStorageVector[i].get();
                     worker->commandList->setFramebuffer(fbStorage->colorDepthWrite.get());
+                    frameStats.renderPasses++;
                     worker->commandList->clearColor();
                     worker->commandList->clearDepth();
 
-                    submitDepthAccess(worker, fbStorage, false, interleavedDepthState);
-                    submitRasterScene(worker, framebuffer, fbStorage, targetDrawCall.rasterScenes[sceneIndex], interleavedDepthState);
+                    submitDepthAccess(worker->commandList, fbStorage, false, interleavedDepthState, frameStats);
+                    submitRasterScene(worker->commandList, framebuffer, fbStorage, targetDrawCall.rasterScenes[sceneIndex], interleavedDepthState, frameStats);
+                    fbStorage->colorTarget->markForResolve();
+                    fbStorage->depthTarget->markForResolve();
 
                     // Resolve the interleaved scene.
                     // TODO: Depth textures need to be thrown into a separate view vector for multisampled textures.
@@ -1238,19 +1461,99 @@ namespace RT64 {
                     worker->commandList->barriers(RenderBarrierStage::COMPUTE, interleavedBarriers);
                 }
 
-                submitDepthAccess(worker, targetDrawCall.fbStorage, true, depthState);
+                submitDepthAccess(worker->commandList, targetDrawCall.fbStorage, true, depthState, frameStats);
                 submitRaytracingScene(worker, targetDrawCall.fbStorage->colorTarget, rtScene);
             }
             else 
 #       endif
             {
                 const RasterScene &rasterScene = targetDrawCall.rasterScenes[pair.first];
-                submitDepthAccess(worker, targetDrawCall.fbStorage, false, depthState);
-                submitRasterScene(worker, framebuffer, targetDrawCall.fbStorage, rasterScene, depthState);
+                submitRasterScene(worker->commandList, framebuffer, targetDrawCall.fbStorage, rasterScene, depthState, frameStats);
+                colorTarget->markForResolve();
+                depthTarget->markForResolve();
             }
         }
     }
 
+    bool FramebufferRenderer::isParallelRecordingPossible(const RenderTargetDrawCall &targetDrawCall) const {
+        if (recordingThreads.empty()) {
+            return false;
+        }
+
+        uint32_t callCount = 0;
+        for (const auto pair : targetDrawCall.sceneIndices) {
+            if (pair.second) {
+                return false;
+            }
+
+            const RasterScene &rasterScene = targetDrawCall.rasterScenes[pair.first];
+            const bool depthReadRequired = (rasterScene.firstDepthAccess == RasterScene::DepthAccess::Read) || (rasterScene.depthTransitions > 0);
+            if (depthReadRequired) {
+                return false;
+            }
+
+            callCount += uint32_t(rasterScene.instanceIndices.size());
+        }
+
+        return (callCount >= ParallelRecordingMinimumCalls);
+    }
+
+    void FramebufferRenderer::recordingThreadLoop() {
+        Thread::setCurrentThreadName("RT64 Recording");
+
+        while (true) {
+            Recording *recording = nullptr;
+            {
+                std::unique_lock<std::mutex> recordingLock(recordingMutex);
+                recordingQueueChanged.wait(recordingLock, [this]() {
+                    return !recordingThreadsRunning || (recordingCursor < recordingCount);
+                });
+
+                if (recordingCursor == recordingCount) {
+                    break;
+                }
+
+                recording = &recordingVector[recordingCursor++];
+            }
+
+            const Framebuffer &framebuffer = framebufferVector[recording->framebufferIndex];
+            const RenderTargetDrawCall &targetDrawCall = framebuffer.renderTargetDrawCall;
+            bool depthState = false;
+            for (const auto pair : targetDrawCall.sceneIndices) {
+                submitRasterScene(recording->commandList, framebuffer, targetDrawCall.fbStorage, targetDrawCall.rasterScenes[pair.first], depthState, recording->stats);
+            }
+
+            recording->commandList->end();
+
+            {
+                std::unique_lock<std::mutex> recordingLock(recordingMutex);
+                recordingsCompleted++;
+            }
+
+            recordingCompleted.notify_all();
+        }
+    }
+
+    void FramebufferRenderer::waitForRecordings() {
+        std::unique_lock<std::mutex> recordingLock(recordingMutex);
+        recordingCompleted.wait(recordingLock, [this]() {
+            return (recordingsCompleted == recordingCount);
+        });
+
+        for (uint32_t i = 0; i < recordingCount; i++) {
+            const Stats &recordingStats = recordingVector[i].stats;
+            frameStats.rasterCalls += recordingStats.rasterCalls;
+            frameStats.rasterDraws += recordingStats.rasterDraws;
+            frameStats.renderPasses += recordingStats.renderPasses;
+            frameStats.depthTransitions += recordingStats.depthTransitions;
+        }
+
+        frameStats.parallelFramebuffers += recordingCount;
+        recordingCount = 0;
+        recordingCursor = 0;
+        recordingsCompleted = 0;
+    }
+
     void FramebufferRenderer::waitForUploaders() {
         shaderUploader->wait();
 
@@ -1326,6 +1629,7 @@ namespace RT64 {
         vertexInputSlots[0] = RenderInputSlot(0, PosStride);
         vertexInputSlots[1] = RenderInputSlot(1, TcStride);
         vertexInputSlots[2] = RenderInputSlot(2, ColStride);
+        vertexInputSlots[3] = RenderInputSlot(3, sizeof(uint32_t), RenderInputSlotClassification::PER_INSTANCE_DATA);
         indexedVertexViews[0] = RenderVertexBufferView(RenderBufferReference(screenPosRes), PosStride * vertexCount);
         indexedVertexViews[1] = RenderVertexBufferView(RenderBufferReference(tcRes), TcStride * vertexCount);
         indexedVertexViews[2] = RenderVertexBufferView(RenderBufferReference(shadedColRes), ColStride * vertexCount);
@@ -1339,6 +1643,28 @@ namespace RT64 {
         RasterScene rasterScene;
         auto checkRasterScene = [&](RasterScene &rasterScene) {
             if (!rasterScene.instanceIndices.empty()) {
+                buildRasterSceneBatches(rasterScene);
+
+                // Switching the depth access only when a call requires the opposite one results in the minimum amount of switches.
+                RasterScene::DepthAccess lastDepthAccess = RasterScene::DepthAccess::None;
+                rasterScene.firstDepthAccess = RasterScene::DepthAccess::None;
+                rasterScene.depthTransitions = 0;
+                for (uint32_t instanceIndex : rasterScene.instanceIndices) {
+                    const RasterScene::DepthAccess depthAccess = depthAccessFromDrawCall(instanceDrawCallVector[instanceIndex]);
+                    if (depthAccess == RasterScene::DepthAccess::None) {
+                        continue;
+                    }
+
+                    if (lastDepthAccess == RasterScene::DepthAccess::None) {
+                        rasterScene.firstDepthAccess = depthAccess;
+                    }
+                    else if (depthAccess != lastDepthAccess) {
+                        rasterScene.depthTransitions++;
+                    }
+
+                    lastDepthAccess = depthAccess;
+                }
+
                 uint32_t sceneIndex = static_cast<uint32_t>(targetDrawCall.rasterScenes.size());
                 targetDrawCall.rasterScenes.push_back(rasterScene);
                 targetDrawCall.sceneIndices.push_back({ sceneIndex, false });
@@ -1424,6 +1750,13 @@ namespace RT64 {
                 renderIndices.rdpTileIndex = call.callDesc.tileIndex;
                 renderIndices.rdpTileCount = call.callDesc.tileCount;
                 renderIndices.highlightColor = call.debuggerDesc.highlightColor;
+
+                // Indicate if post blend dither noise should be applied to the rect. The pixel shader applies it unless the call
+                // uses alpha blending, in which case the noise must be drawn in separate passes after the call.
+                const interop::OtherMode &shaderOtherMode = call.shaderDesc.otherMode;
+                const bool rgbDitherNoise = (shaderOtherMode.rgbDither() == G_CD_NOISE);
+                const bool postBlendDitherNoise = p.postBlendNoise && (proj.type == Projection::Type::Rectangle) && rgbDitherNoise && !shaderOtherMode.zCmp() && !shaderOtherMode.zUpd();
+                renderIndices.postBlendDitherNoise = postBlendDitherNoise;
                 renderIndicesVector.push_back(renderIndices);
 
                 uint32_t cycleType = call.callDesc.otherMode.cycleType();
@@ -1584,10 +1917,8 @@ namespace RT64 {
 
                             triangles.viewport = convertViewportRect(fixedRect, p.resolutionScale, p.fbWidth, invRatioScale, extOriginPercentage, horizontalMisalignment, call.callDesc.rectLeftOrigin, call.callDesc.rectRightOrigin);
 
-                            if (p.postBlendNoise) {
-                                // Indicate if post blend dither noise should be applied.
-                                bool rgbDitherNoise = (call.shaderDesc.otherMode.rgbDither() == G_CD_NOISE);
-                                triangles.postBlendDitherNoise = rgbDitherNoise && !call.shaderDesc.otherMode.zCmp() && !call.shaderDesc.otherMode.zUpd();
+                            if (postBlendDitherNoise) {
+                                triangles.postBlendDitherNoise = (shaderOtherMode.cycleType() != G_CYC_COPY) && interop::Blender::usesAlphaBlend(shaderOtherMode);
                             }
 
                             break;
@@ -1682,9 +2013,24 @@ namespace RT64 {
     }
 
     void FramebufferRenderer::endFramebuffers(RenderWorker *worker, const DrawBuffers *drawBuffers, const OutputBuffers *outputBuffers, bool rtEnabled) {
+        // The recordings can't be resized while the recording threads are using them.
+        assert((recordingCount == 0) && "Recordings from the previous workload must be waited on first.");
+        if (recordingVector.size() < framebufferCount) {
+            recordingVector.resize(framebufferCount);
+        }
+
+        // Each render index is stored at its own position, so draws can select it as instance data with their start instance.
+        const size_t renderIndexCount = renderIndicesVector.size();
+        for (size_t i = renderIndexInstanceVector.size(); i < renderIndexCount; i++) {
+            renderIndexInstanceVector.emplace_back(uint32_t(i));
+        }
+
         bool shaderViewRtEnabled = false;
         std::vector<BufferUploader::Upload> shaderUploads = {
-            { renderIndicesVector.data(), { 0, renderIndicesVector.size() }, sizeof(interop::RenderIndices), RenderBufferFlag::STORAGE, { }, &renderIndicesBuffer},
+            { renderIndicesVector.data(), { 0, renderIndexCount }, sizeof(interop::RenderIndices), RenderBufferFlag::STORAGE, { }, &renderIndicesBuffer},
+            { renderIndexInstanceVector.data(), { 0, renderIndexCount }, sizeof(uint32_t), RenderBufferFlag::VERTEX, { }, &renderIndexInstanceBuffer},
+            { drawArgumentsVector.data(), { 0, drawArgumentsVector.size() }, sizeof(RenderDrawIndirectArguments), RenderBufferFlag::INDIRECT, { }, &drawArgumentsBuffer},
+            { drawIndexedArgumentsVector.data(), { 0, drawIndexedArgumentsVector.size() }, sizeof(RenderDrawIndexedIndirectArguments), RenderBufferFlag::INDIRECT, { }, &drawIndexedArgumentsBuffer},
             { &frameParams, { 0, 1 }, sizeof(interop::FrameParams), RenderBufferFlag::CONSTANT, { }, &frameParamsBuffer}
         };
 
@@ -1738,6 +2084,7 @@ namespace RT64 {
 #   endif
 
         shaderUploader->submit(worker, shaderUploads);
+        renderIndexInstanceView = RenderVertexBufferView(renderIndexInstanceBuffer.get(), uint32_t(renderIndexInstanceBuffer.allocatedSize));
         updateShaderViews(worker, drawBuffers, outputBuffers, shaderViewRtEnabled);
     }
 
@@ -4,7 +4,10 @@
 
 #pragma once
 
+#include <condition_variable>
+#include <mutex>
 #include <stdint.h>
+#include <thread>
 
 #include "common/rt64_user_configuration.h"
 #include "hle/rt64_framebuffer_manager.h"
@@ -36,7 +39,26 @@ namespace RT64 {
     };
 
     struct RasterScene {
+        enum class DepthAccess {
+            None,
+            Read,
+            Write
+        };
+
+        // Run of consecutive calls in the scene that share all their state and are submitted as a single multi-draw.
+        struct Batch {
+            uint32_t instanceStart = 0;
+            uint32_t instanceCount = 0;
+            uint32_t argumentStart = 0;
+        };
+
         std::vector<uint32_t> instanceIndices;
+        std::vector<Batch> batches;
+
+        // Depth access required by the first call that needs a specific one and the minimum amount of switches between read-only and
+        // write access the rest of the calls need when starting from it. Every switch breaks the render pass and requires a barrier.
+        DepthAccess firstDepthAccess = DepthAccess::None;
+        uint32_t depthTransitions = 0;
 
         RasterScene();
     };
@@ -58,24 +80,49 @@ namespace RT64 {
     };
 
     struct FramebufferRenderer {
-        std::vector<uint32_t> textureCacheVersions;
+        struct Stats {
+            uint32_t rasterCalls = 0;
+            uint32_t rasterDraws = 0;
+            uint32_t parallelFramebuffers = 0;
+            uint32_t renderPasses = 0;
+            uint32_t depthTransitions = 0;
+        };
+
+        // Framebuffer scenes recorded by the recording threads into a secondary command list of the worker.
+        struct Recording {
+            uint32_t framebufferIndex = 0;
+            RenderCommandList *commandList = nullptr;
+            Stats stats;
+        };
+
+        // Framebuffers with fewer calls than this are cheaper to record directly on the worker's command list.
+        static const uint32_t ParallelRecordingMinimumCalls = 32;
+
         std::vector<const Texture *> textureCacheTextures;
-        std::vector<uint32_t> textureCacheFreeSpaces;
+        std::vector<TextureMap::Change> textureCacheChanges;
+        std::vector<uint32_t> textureCacheDirtyIndices;
+        uint64_t textureCacheChangeCursor = 0;
         uint32_t textureCacheSize;
-        uint32_t textureCacheGlobalVersion;
         std::vector<InstanceDrawCall> instanceDrawCallVector;
         std::vector<interop::RenderIndices> renderIndicesVector;
         std::vector<DynamicTextureView> dynamicTextureViewVector;
         std::vector<RenderTextureBarrier> dynamicTextureBarrierVector;
         std::unique_ptr<BufferUploader> shaderUploader;
         std::vector<RSPSmoothNormalGenerationCB> rspSmoothNormalVector;
-        std::array<RenderInputSlot, 3> vertexInputSlots;
+        std::vector<uint32_t> renderIndexInstanceVector;
+        std::vector<RenderDrawIndirectArguments> drawArgumentsVector;
+        std::vector<RenderDrawIndexedIndirectArguments> drawIndexedArgumentsVector;
+        std::array<RenderInputSlot, 4> vertexInputSlots;
         std::array<RenderVertexBufferView, 3> indexedVertexViews;
         std::array<RenderVertexBufferView, 3> rawVertexViews;
+        RenderVertexBufferView renderIndexInstanceView;
         RenderIndexBufferView indexBufferView;
         RenderBuffer *testZIndexBuffer;
         RenderIndexBufferView testZIndexBufferView;
         BufferPair renderIndicesBuffer;
+        BufferPair renderIndexInstanceBuffer;
+        BufferPair drawArgumentsBuffer;
+        BufferPair drawIndexedArgumentsBuffer;
         BufferPair interleavedRastersBuffer;
         uint32_t interleavedRastersCount = 0;
         BufferPair frameParamsBuffer;
@@ -87,12 +134,22 @@ namespace RT64 {
         std::unique_ptr<RenderTexture> dummyDepthTarget;
         std::unique_ptr<RenderTextureView> dummyDepthTargetView;
         bool dummyDepthTargetTransitioned = false;
-        std::vector<uint32_t> descriptorTextureVersions;
-        uint32_t descriptorTextureGlobalVersion;
         std::unique_ptr<RSPSmoothNormalDescriptorSet> smoothDescSet;
         std::unique_ptr<RSPVertexTestZDescriptorSet> vertexTestZSet;
         interop::FrameParams frameParams;
         const ShaderLibrary *shaderLibrary = nullptr;
+        bool multiDrawIndirect = false;
+        Stats frameStats;
+        Stats stats;
+        std::vector<std::unique_ptr<std::thread>> recordingThreads;
+        std::vector<Recording> recordingVector;
+        uint32_t recordingCount = 0;
+        uint32_t recordingCursor = 0;
+        uint32_t recordingsCompleted = 0;
+        bool recordingThreadsRunning = false;
+        std::mutex recordingMutex;
+        std::condition_variable recordingQueueChanged;
+        std::condition_variable recordingCompleted;
 
 #   if RT_ENABLED
         const RenderTexture *blueNoiseTexture = nullptr;
@@ -139,7 +196,7 @@ namespace RT64 {
             uint32_t maxGameCall;
         };
 
-        FramebufferRenderer(RenderWorker *worker, bool rtSupport, UserConfiguration::GraphicsAPI graphicsAPI, const ShaderLibrary *shaderLibrary);
+        FramebufferRenderer(RenderWorker *worker, bool rtSupport, UserConfiguration::GraphicsAPI graphicsAPI, const ShaderLibrary *shaderLibrary, uint32_t recordingThreadCount);
         ~FramebufferRenderer();
         void resetFramebuffers(RenderWorker *worker, bool ubershadersVisible, float ditherNoiseStrength, const RenderMultisampling &multisampling);
         void updateTextureCache(TextureCache *textureCache);
@@ -153,12 +210,16 @@ namespace RT64 {
         void updateRSPVertexTestZSet(RenderWorker *worker, const DrawBuffers *drawBuffers, const OutputBuffers *outputBuffers);
         void updateShaderViews(RenderWorker *worker, const DrawBuffers *drawBuffers, const OutputBuffers *outputBuffers, bool raytracingEnabled);
         void submitRSPSmoothNormalCompute(RenderWorker *worker, const OutputBuffers *outputBuffers);
-        bool submitDepthAccess(RenderWorker *worker, RenderFramebufferStorage *fbStorage, bool readOnly, bool &depthState);
-        void submitRasterScene(RenderWorker *worker, const Framebuffer &framebuffer, RenderFramebufferStorage *fbStorage, const RasterScene &rasterScene, bool &depthState);
+        bool submitDepthAccess(RenderCommandList *commandList, RenderFramebufferStorage *fbStorage, bool readOnly, bool &depthState, Stats &recordStats);
+        void submitRasterScene(RenderCommandList *commandList, const Framebuffer &framebuffer, RenderFramebufferStorage *fbStorage, const RasterScene &rasterScene, bool &depthState, Stats &recordStats);
+        void buildRasterSceneBatches(RasterScene &rasterScene);
         void addFramebuffer(const DrawParams &p);
         void endFramebuffers(RenderWorker *worker, const DrawBuffers *drawBuffers, const OutputBuffers *outputBuffers, bool rtEnabled);
         void recordSetup(RenderWorker *worker, std::vector<BufferUploader *> bufferUploaders, RSPProcessor *rspProcessor, VertexProcessor *vertexProcessor, const OutputBuffers *outputBuffers, bool rtEnabled);
         void recordFramebuffer(RenderWorker *worker, uint32_t framebufferIndex);
+        bool isParallelRecordingPossible(const RenderTargetDrawCall &targetDrawCall) const;
+        void recordingThreadLoop();
+        void waitForRecordings();
         void waitForUploaders();
         void advanceFrame(bool rtEnabled);
 
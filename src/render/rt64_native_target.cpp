@@ -2,8 +2,18 @@
 // RT64
 //
 
+#include <algorithm>
+#include <bitset>
 #include <cstring>
 
+#if defined(__SSE2__) || defined(_M_X64)
+#   include <emmintrin.h>
+#   define NATIVE_TARGET_SSE2
+#elif defined(__aarch64__) || defined(_M_ARM64)
+#   include <arm_neon.h>
+#   define NATIVE_TARGET_NEON
+#endif
+
 #include "rt64_native_target.h"
 
 #include "gbi/rt64_f3d.h"
@@ -13,6 +23,58 @@
 #include "rt64_render_worker.h"
 
 namespace RT64 {
+    // Returns the amount of bytes that belong to elements that are different between both buffers.
+    template<uint32_t ElementSize>
+    static uint32_t countDifferentElementBytes(const uint8_t *newData, const uint8_t *curData, uint32_t byteCount) {
+        uint32_t differentBytes = 0;
+        uint32_t i = 0;
+#   if defined(NATIVE_TARGET_SSE2)
+        for (; (i + 16) <= byteCount; i += 16) {
+            const __m128i newVector = _mm_loadu_si128(reinterpret_cast<const __m128i *>(newData + i));
+            const __m128i curVector = _mm_loadu_si128(reinterpret_cast<const __m128i *>(curData + i));
+            __m128i equalVector;
+            if constexpr (ElementSize == 4) {
+                equalVector = _mm_cmpeq_epi32(newVector, curVector);
+            }
+            else if constexpr (ElementSize == 2) {
+                equalVector = _mm_cmpeq_epi16(newVector, curVector);
+            }
+            else {
+                equalVector = _mm_cmpeq_epi8(newVector, curVector);
+            }
+
+            const uint32_t equalMask = uint32_t(_mm_movemask_epi8(equalVector));
+            if (equalMask != 0xFFFFU) {
+                differentBytes += uint32_t(std::bitset<16>(~equalMask & 0xFFFFU).count());
+            }
+        }
+#   elif defined(NATIVE_TARGET_NEON)
+        for (; (i + 16) <= byteCount; i += 16) {
+            const uint8x16_t newVector = vld1q_u8(newData + i);
+            const uint8x16_t curVector = vld1q_u8(curData + i);
+            uint8x16_t equalVector;
+            if constexpr (ElementSize == 4) {
+                equalVector = vreinterpretq_u8_u32(vceqq_u32(vreinterpretq_u32_u8(newVector), vreinterpretq_u32_u8(curVector)));
+            }
+            else if constexpr (ElementSize == 2) {
+                equalVector = vreinterpretq_u8_u16(vceqq_u16(vreinterpretq_u16_u8(newVector), vreinterpretq_u16_u8(curVector)));
+            }
+            else {
+                equalVector = vceqq_u8(newVector, curVector);
+            }
+
+            differentBytes += vaddvq_u8(vshrq_n_u8(vmvnq_u8(equalVector), 7));
+        }
+#   endif
+        for (; (i + ElementSize) <= byteCount; i += ElementSize) {
+            if (memcmp(newData + i, curData + i, ElementSize) != 0) {
+                differentBytes += ElementSize;
+            }
+        }
+
+        return differentBytes;
+    }
+
     // NativeTarget
 
     NativeTarget::NativeTarget() { }
@@ -60,43 +122,32 @@ namespace RT64 {
         return rowSize * height;
     }
 
-    uint32_t NativeTarget::copyFromRAM(RenderWorker *worker, FramebufferChange &emptyFbChange, uint32_t width, uint32_t height, uint32_t rowStart, uint8_t siz, uint8_t fmt, const uint8_t *data, bool invalidateTargets, const ShaderLibrary *shaderLibrary) {
-        assert(worker != nullptr);
-
-        // Create the buffers for change count readback if they've not been created yet.
-        if ((changeCountBuffer == nullptr) || (changeReadbackBuffer == nullptr)) {
-            changeCountBuffer = worker->device->createBuffer(RenderBufferDesc::DefaultBuffer(sizeof(uint32_t), RenderBufferFlag::STORAGE | RenderBufferFlag::UNORDERED_ACCESS));
-            changeReadbackBuffer = worker->device->createBuffer(RenderBufferDesc::ReadbackBuffer(sizeof(uint32_t)));
-            clearDescSet = std::make_unique<FramebufferClearChangesDescriptorSet>(worker->device);
-            clearDescSet->setBuffer(clearDescSet->gOutputCount, changeCountBuffer.get(), RenderBufferStructuredView(sizeof(uint32_t)));
-        }
-
-        // Determine the correct type of texture to use.
-        RenderTexture *colorOrDepthRes = nullptr;
-        RenderTexture *booleanRes = emptyFbChange.booleanTexture.get();
-        switch (emptyFbChange.type) {
-        case FramebufferChange::Type::Color:
-            colorOrDepthRes = emptyFbChange.pixelTexture.get();
+    uint32_t NativeTarget::countDifferentPixels(const uint8_t *newData, uint32_t newSize, const uint8_t *curData, uint32_t curSize, uint8_t siz) {
+        assert(newData != nullptr);
+        assert((curData != nullptr) || (curSize == 0));
+
+        // Pixels are compared with the same element size used by the native buffer views.
+        const uint32_t elementSize = std::max(getNativeSize(1, 1, siz), 1U);
+        const uint32_t comparedSize = std::min(newSize, curSize);
+        uint32_t differentBytes = 0;
+        switch (elementSize) {
+        case 4:
+            differentBytes = countDifferentElementBytes<4>(newData, curData, comparedSize);
             break;
-        case FramebufferChange::Type::Depth:
-            colorOrDepthRes = emptyFbChange.pixelTexture.get();
+        case 2:
+            differentBytes = countDifferentElementBytes<2>(newData, curData, comparedSize);
             break;
         default:
-            assert(false && "Invalid framebuffer change type.");
+            differentBytes = countDifferentElementBytes<1>(newData, curData, comparedSize);
             break;
         }
 
-        // Copy to the native upload resource.
-        const bool hasCurrentResource = !invalidateTargets && (readBufferHistoryCount > 0);
-        const uint32_t bufferSize = getNativeSize(width, height, siz);
-        while (readBufferHistoryCount >= readBufferHistory.size()) {
-            readBufferHistory.emplace_back();
-        }
-
-        ReadBuffer &readBuffer = readBufferHistory[readBufferHistoryCount];
-        ReadBuffer *previousReadBuffer = hasCurrentResource ? &readBufferHistory[readBufferHistoryCount - 1] : nullptr;
-        readBufferHistoryCount++;
+        // Anything past the end of the previous contents is considered different.
+        differentBytes += newSize - comparedSize;
+        return differentBytes / elementSize;
+    }
 
+    void NativeTarget::setupReadBuffer(RenderWorker *worker, ReadBuffer &readBuffer, ReadBuffer *previousReadBuffer, uint32_t bufferSize, uint8_t siz) {
         if (readBuffer.nativeBufferSize < bufferSize) {
             createReadBuffer(worker, readBuffer, bufferSize);
         }
@@ -115,7 +166,6 @@ namespace RT64 {
         }
 
         readBuffer.readDescSet->setBuffer(readBuffer.readDescSet->gNewInput, readBuffer.nativeBuffer.get(), readBuffer.nativeBufferSize, readBuffer.nativeBufferView.get());
-        readBuffer.readDescSet->setBuffer(readBuffer.readDescSet->gOutputCount, changeCountBuffer.get(), RenderBufferStructuredView(sizeof(uint32_t)));
 
         if (previousReadBuffer != nullptr) {
             const RenderBufferFormattedView *previousBufferView = nullptr;
@@ -133,20 +183,61 @@ namespace RT64 {
 
             readBuffer.readDescSet->setBuffer(readBuffer.readDescSet->gCurInput, previousReadBuffer->nativeBuffer.get(), previousReadBuffer->nativeBufferSize, previousBufferView);
         }
+    }
+
+    uint32_t NativeTarget::copyFromRAM(RenderWorker *worker, FramebufferChange &emptyFbChange, uint32_t width, uint32_t height, uint32_t rowStart, uint8_t siz, uint8_t fmt, const uint8_t *data, bool invalidateTargets, const ShaderLibrary *shaderLibrary) {
+        assert(worker != nullptr);
+
+        // Determine the correct type of texture to use.
+        RenderTexture *colorOrDepthRes = nullptr;
+        RenderTexture *booleanRes = emptyFbChange.booleanTexture.get();
+        switch (emptyFbChange.type) {
+        case FramebufferChange::Type::Color:
+            colorOrDepthRes = emptyFbChange.pixelTexture.get();
+            break;
+        case FramebufferChange::Type::Depth:
+            colorOrDepthRes = emptyFbChange.pixelTexture.get();
+            break;
+        default:
+            assert(false && "Invalid framebuffer change type.");
+            break;
+        }
+
+        // Copy to the native upload resource.
+        const bool hasCurrentResource = !invalidateTargets && (readBufferHistoryCount > 0);
+        const uint32_t bufferSize = getNativeSize(width, height, siz);
+        while (readBufferHistoryCount >= readBufferHistory.size()) {
+            readBufferHistory.emplace_back();
+        }
+
+        ReadBuffer &readBuffer = readBufferHistory[readBufferHistoryCount];
+        ReadBuffer *previousReadBuffer = hasCurrentResource ? &readBufferHistory[readBufferHistoryCount - 1] : nullptr;
+        readBufferHistoryCount++;
+
+        setupReadBuffer(worker, readBuffer, previousReadBuffer, bufferSize, siz);
+        readBuffer.contentWidth = width;
+        readBuffer.contentRows = (rowStart == 0) ? height : 0;
+        readBuffer.contentSiz = siz;
 
         void *dstData = readBuffer.nativeUploadBuffer->map();
         memcpy(dstData, data, bufferSize);
         readBuffer.nativeUploadBuffer->unmap();
 
+        // The amount of changes is counted on the CPU against a copy of the previous contents, so the commands can be recorded
+        // without waiting on the GPU. Reading back from the upload buffer would be too slow, as it's usually write-combined memory.
+        // Any contents written by the GPU are copied into it when they're read back. Pixels the copy doesn't cover count as modified.
+        uint32_t modifiedCount = 0;
         if (hasCurrentResource) {
-            // Clear the change count resource with a compute shader.
-            worker->commandList->barriers(RenderBarrierStage::COMPUTE, RenderBufferBarrier(changeCountBuffer.get(), RenderBufferAccess::WRITE));
-            worker->commandList->setPipeline(shaderLibrary->fbChangesClear.pipeline.get());
-            worker->commandList->setComputePipelineLayout(shaderLibrary->fbChangesClear.pipelineLayout.get());
-            worker->commandList->setComputeDescriptorSet(clearDescSet->get(), 0);
-            worker->commandList->dispatch(1, 1, 1);
-            worker->commandList->barriers(RenderBarrierStage::COMPUTE, RenderBufferBarrier(changeCountBuffer.get(), RenderBufferAccess::WRITE));
+            const std::vector<uint8_t> &previousData = previousReadBuffer->nativeData;
+            modifiedCount = countDifferentPixels(data, bufferSize, previousData.data(), uint32_t(previousData.size()), siz);
+        }
+        // Consider all pixels as modified.
+        else {
+            modifiedCount = width * height;
         }
+
+        readBuffer.nativeData.resize(bufferSize);
+        memcpy(readBuffer.nativeData.data(), data, bufferSize);
         
         // Copy the native upload resource to the dedicated resource.
         worker->commandList->barriers(RenderBarrierStage::COPY, RenderBufferBarrier(readBuffer.nativeBuffer.get(), RenderBufferAccess::WRITE));
@@ -179,7 +270,6 @@ namespace RT64 {
         const uint32_t BlockSize = FB_COMMON_WORKGROUP_SIZE;
         uint32_t dispatchX = (width + BlockSize - 1) / BlockSize;
         uint32_t dispatchY = (height + BlockSize - 1) / BlockSize;
-        RenderBufferBarrier counterBarrier = RenderBufferBarrier(changeCountBuffer.get(), RenderBufferAccess::WRITE);
         RenderTextureBarrier beforeBarriers[] = {
             RenderTextureBarrier(emptyFbChange.pixelTexture.get(), RenderTextureLayout::GENERAL),
             RenderTextureBarrier(emptyFbChange.booleanTexture.get(), RenderTextureLayout::GENERAL)
@@ -191,7 +281,7 @@ namespace RT64 {
         };
 
         const ShaderRecord &shaderReadRecord = hasCurrentResource ? shaderLibrary->fbReadAnyChanges : shaderLibrary->fbReadAnyFull;
-        worker->commandList->barriers(RenderBarrierStage::COMPUTE, &counterBarrier, 1, beforeBarriers, uint32_t(std::size(beforeBarriers)));
+        worker->commandList->barriers(RenderBarrierStage::COMPUTE, beforeBarriers, uint32_t(std::size(beforeBarriers)));
         worker->commandList->setPipeline(shaderReadRecord.pipeline.get());
         worker->commandList->setComputePipelineLayout(shaderReadRecord.pipelineLayout.get());
         worker->commandList->setComputeDescriptorSet(readBuffer.readDescSet->get(), 0);
@@ -200,35 +290,103 @@ namespace RT64 {
         worker->commandList->dispatch(dispatchX, dispatchY, 1);
         worker->commandList->barriers(RenderBarrierStage::ALL, afterBarriers, uint32_t(std::size(afterBarriers)));
 
-        if (hasCurrentResource) {
-            // Copy the modified count resource to the readback.
-            RenderBufferBarrier beforeCopyBarriers[] = {
-                RenderBufferBarrier(changeCountBuffer.get(), RenderBufferAccess::READ),
-                RenderBufferBarrier(changeReadbackBuffer.get(), RenderBufferAccess::WRITE)
-            };
+        return modifiedCount;
+    }
 
-            worker->commandList->barriers(RenderBarrierStage::COPY, beforeCopyBarriers, uint32_t(std::size(beforeCopyBarriers)));
-            worker->commandList->copyBuffer(changeReadbackBuffer.get(), changeCountBuffer.get());
-        }
-        
-        // Read the modified count by executing and waiting.
-        uint32_t modifiedCount = 0;
-        if (hasCurrentResource) {
-            worker->commandList->end();
-            worker->execute();
-            worker->wait();
-            worker->commandList->begin();
-            RenderRange readRange(0, sizeof(uint32_t));
-            uint32_t *readbackData = reinterpret_cast<uint32_t *>(changeReadbackBuffer->map(0, &readRange));
-            modifiedCount = *readbackData;
-            changeReadbackBuffer->unmap();
+    bool NativeTarget::canCopyRowsFromRAM(uint32_t width, uint32_t height, uint8_t siz) const {
+        if (readBufferHistoryCount == 0) {
+            return false;
         }
-        // Consider all pixels as modified.
-        else {
-            modifiedCount = width * height;
+
+        const ReadBuffer &previousReadBuffer = readBufferHistory[readBufferHistoryCount - 1];
+        const uint32_t bufferSize = getNativeSize(width, height, siz);
+        return (previousReadBuffer.contentWidth == width) && (previousReadBuffer.contentSiz == siz) && (previousReadBuffer.contentRows >= height) &&
+            (previousReadBuffer.nativeBufferSize >= bufferSize) && (previousReadBuffer.nativeData.size() >= bufferSize);
+    }
+
+    void NativeTarget::copyRowsFromRAM(RenderWorker *worker, FramebufferChange &emptyFbChange, uint32_t width, uint32_t height, uint32_t rowStart, uint32_t rowCount, uint8_t siz, uint8_t fmt, const uint8_t *data, const ShaderLibrary *shaderLibrary) {
+        assert(worker != nullptr);
+        assert(canCopyRowsFromRAM(width, height, siz));
+        assert((rowStart + rowCount) <= height);
+
+        const uint32_t bufferSize = getNativeSize(width, height, siz);
+        while (readBufferHistoryCount >= readBufferHistory.size()) {
+            readBufferHistory.emplace_back();
         }
 
-        return modifiedCount;
+        ReadBuffer &readBuffer = readBufferHistory[readBufferHistoryCount];
+        ReadBuffer *previousReadBuffer = &readBufferHistory[readBufferHistoryCount - 1];
+        readBufferHistoryCount++;
+
+        setupReadBuffer(worker, readBuffer, previousReadBuffer, bufferSize, siz);
+        readBuffer.contentWidth = width;
+        readBuffer.contentRows = height;
+        readBuffer.contentSiz = siz;
+
+        // Only the rows that were modified are uploaded. The rest of the buffer is carried over from the previous read.
+        const uint32_t rowsOffset = getNativeSize(width, rowStart, siz);
+        const uint32_t rowsSize = getNativeSize(width, rowCount, siz);
+        void *dstData = readBuffer.nativeUploadBuffer->map();
+        memcpy(dstData, data, rowsSize);
+        readBuffer.nativeUploadBuffer->unmap();
+
+        // The CPU copy of the contents must match what the native buffer will hold for the next comparison.
+        const std::vector<uint8_t> &previousData = previousReadBuffer->nativeData;
+        assert(previousData.size() >= bufferSize);
+        readBuffer.nativeData.resize(bufferSize);
+        memcpy(readBuffer.nativeData.data(), previousData.data(), bufferSize);
+        memcpy(readBuffer.nativeData.data() + rowsOffset, data, rowsSize);
+
+        RenderBufferBarrier beforeCopyBarriers[] = {
+            RenderBufferBarrier(previousReadBuffer->nativeBuffer.get(), RenderBufferAccess::READ),
+            RenderBufferBarrier(readBuffer.nativeBuffer.get(), RenderBufferAccess::WRITE)
+        };
+
+        worker->commandList->barriers(RenderBarrierStage::COPY, beforeCopyBarriers, uint32_t(std::size(beforeCopyBarriers)));
+        worker->commandList->copyBufferRegion(readBuffer.nativeBuffer.get(), previousReadBuffer->nativeBuffer.get(), bufferSize);
+        worker->commandList->barriers(RenderBarrierStage::COPY, RenderBufferBarrier(readBuffer.nativeBuffer.get(), RenderBufferAccess::WRITE));
+        worker->commandList->copyBufferRegion(readBuffer.nativeBuffer->at(rowsOffset), readBuffer.nativeUploadBuffer.get(), rowsSize);
+
+        RenderBufferBarrier afterCopyBarriers[] = {
+            RenderBufferBarrier(previousReadBuffer->nativeBuffer.get(), RenderBufferAccess::READ),
+            RenderBufferBarrier(readBuffer.nativeBuffer.get(), RenderBufferAccess::READ)
+        };
+
+        worker->commandList->barriers(RenderBarrierStage::COMPUTE, afterCopyBarriers, uint32_t(std::size(afterCopyBarriers)));
+
+        // Compare the modified rows against the previous read. The amount of changes is not counted, as the caller already
+        // knows which rows were modified.
+        interop::FbCommonCB nativeCB;
+        nativeCB.offset = { 0, rowStart };
+        nativeCB.resolution = { width, rowCount };
+        nativeCB.fmt = fmt;
+        nativeCB.siz = siz;
+        nativeCB.ditherPattern = 0;
+        nativeCB.ditherRandomSeed = 0;
+        nativeCB.usesHDR = shaderLibrary->usesHDR;
+
+        const uint32_t BlockSize = FB_COMMON_WORKGROUP_SIZE;
+        uint32_t dispatchX = (width + BlockSize - 1) / BlockSize;
+        uint32_t dispatchY = (rowCount + BlockSize - 1) / BlockSize;
+        RenderTextureBarrier beforeBarriers[] = {
+            RenderTextureBarrier(emptyFbChange.pixelTexture.get(), RenderTextureLayout::GENERAL),
+            RenderTextureBarrier(emptyFbChange.booleanTexture.get(), RenderTextureLayout::GENERAL)
+        };
+
+        RenderTextureBarrier afterBarriers[] = {
+            RenderTextureBarrier(emptyFbChange.pixelTexture.get(), RenderTextureLayout::SHADER_READ),
+            RenderTextureBarrier(emptyFbChange.booleanTexture.get(), RenderTextureLayout::SHADER_READ)
+        };
+
+        const ShaderRecord &shaderReadRecord = shaderLibrary->fbReadAnyChanges;
+        worker->commandList->barriers(RenderBarrierStage::COMPUTE, beforeBarriers, uint32_t(std::size(beforeBarriers)));
+        worker->commandList->setPipeline(shaderReadRecord.pipeline.get());
+        worker->commandList->setComputePipelineLayout(shaderReadRecord.pipelineLayout.get());
+        worker->commandList->setComputeDescriptorSet(readBuffer.readDescSet->get(), 0);
+        worker->commandList->setComputeDescriptorSet(emptyFbChange.readChangesSet->get(), 1);
+        worker->commandList->setComputePushConstants(0, &nativeCB);
+        worker->commandList->dispatch(dispatchX, dispatchY, 1);
+        worker->commandList->barriers(RenderBarrierStage::ALL, afterBarriers, uint32_t(std::size(afterBarriers)));
     }
 
     void NativeTarget::copyToNative(RenderWorker *worker, RenderTarget *srcTarget, uint32_t rowWidth, uint32_t rowStart, uint32_t rowEnd, uint8_t siz, uint8_t fmt, uint32_t ditherPattern, uint32_t ditherRandomSeed, const ShaderLibrary *shaderLibrary) {
@@ -328,8 +486,36 @@ namespace RT64 {
 
             worker->commandList->barriers(RenderBarrierStage::COPY, copyBarriers, uint32_t(std::size(copyBarriers)));
             worker->commandList->copyBufferRegion(readBuffer->nativeBuffer.get(), smallerReadBuffer->nativeBuffer.get(), smallerReadBuffer->nativeBufferSize);
+            readBuffer->contentWidth = smallerReadBuffer->contentWidth;
+            readBuffer->contentRows = smallerReadBuffer->contentRows;
+            readBuffer->contentSiz = smallerReadBuffer->contentSiz;
+            readBuffer->nativeData = smallerReadBuffer->nativeData;
+        }
+
+        // Keep track of how many rows starting from the top of the buffer are known to hold valid contents.
+        const bool sameContentLayout = (readBuffer->contentWidth == rowWidth) && (readBuffer->contentSiz == siz);
+        if (sameContentLayout && (rowStart <= readBuffer->contentRows)) {
+            readBuffer->contentRows = std::max(readBuffer->contentRows, rowEnd);
+        }
+        else if (!sameContentLayout) {
+            readBuffer->contentRows = (rowStart == 0) ? rowEnd : 0;
         }
 
+        // The CPU copy of the contents keeps the rows above the ones written by the GPU, which are copied into it by copyToRAM once
+        // they're read back. It's discarded if those rows are not valid for the new layout.
+        const uint32_t keptSize = getNativeSize(rowWidth, rowStart, siz);
+        if (!sameContentLayout || (readBuffer->nativeData.size() < keptSize)) {
+            readBuffer->nativeData.clear();
+        }
+
+        if ((readBuffer->nativeData.size() >= keptSize) && (readBuffer->nativeData.size() < bufferSize)) {
+            readBuffer->nativeData.resize(bufferSize);
+        }
+
+        readBuffer->contentWidth = rowWidth;
+        readBuffer->contentSiz = siz;
+        writeBuffer.readBufferIndex = readBufferHistoryCount - 1;
+
         worker->commandList->barriers(RenderBarrierStage::COMPUTE,
             RenderBufferBarrier(readBuffer->nativeBuffer.get(), RenderBufferAccess::WRITE),
             RenderTextureBarrier(srcTarget->getResolvedTexture(), RenderTextureLayout::SHADER_READ)
@@ -366,6 +552,15 @@ namespace RT64 {
         RenderRange readRange = { bufferOffset, bufferOffset + bufferSize };
         uint8_t *readbackData = reinterpret_cast<uint8_t *>(writeBuffer.nativeReadbackBuffer->map(0, &readRange));
         memcpy(data, readbackData + bufferOffset, bufferSize);
+
+        // Update the CPU copy of the read buffer the rows were written to, so the next read can count the changes against it.
+        if (writeBuffer.readBufferIndex < readBufferHistoryCount) {
+            std::vector<uint8_t> &nativeData = readBufferHistory[writeBuffer.readBufferIndex].nativeData;
+            if (nativeData.size() >= (bufferOffset + bufferSize)) {
+                memcpy(nativeData.data() + bufferOffset, readbackData + bufferOffset, bufferSize);
+            }
+        }
+
         writeBuffer.nativeReadbackBuffer->unmap();
         writeBufferHistoryIndex++;
     }
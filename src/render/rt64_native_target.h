@@ -24,7 +24,11 @@ namespace RT64 {
             std::unique_ptr<RenderBufferFormattedView> nativeBufferNextView;
             std::unique_ptr<RenderBufferFormattedView> nativeBufferWriteView;
             std::unique_ptr<FramebufferReadChangesDescriptorBufferSet> readDescSet;
+            std::vector<uint8_t> nativeData;
             uint32_t nativeBufferSize = 0;
+            uint32_t contentWidth = 0;
+            uint32_t contentRows = 0;
+            uint8_t contentSiz = 0;
             uint8_t nativeBufferViewFormat = 0;
             uint8_t nativeBufferNextViewFormat = 0;
             uint8_t nativeBufferWriteViewFormat = 0;
@@ -34,11 +38,9 @@ namespace RT64 {
             std::unique_ptr<FramebufferWriteDescriptorBufferSet> writeDescSet;
             std::unique_ptr<RenderBuffer> nativeReadbackBuffer;
             uint32_t nativeReadbackBufferSize = 0;
+            uint32_t readBufferIndex = 0;
         };
 
-        std::unique_ptr<RenderBuffer> changeCountBuffer;
-        std::unique_ptr<RenderBuffer> changeReadbackBuffer;
-        std::unique_ptr<FramebufferClearChangesDescriptorSet> clearDescSet;
         std::vector<ReadBuffer> readBufferHistory;
         std::vector<WriteBuffer> writeBufferHistory;
         uint32_t readBufferHistoryCount = 0;
@@ -51,12 +53,18 @@ namespace RT64 {
         void resetBufferHistory();
         void createReadBuffer(RenderWorker *worker, ReadBuffer &readBuffer, uint32_t bufferSize);
         RenderFormat getBufferFormat(uint8_t siz) const;
+        void setupReadBuffer(RenderWorker *worker, ReadBuffer &readBuffer, ReadBuffer *previousReadBuffer, uint32_t bufferSize, uint8_t siz);
 
-        // Returns the amount of different pixels.
+        // Returns the amount of different pixels. The amount is computed on the CPU against the contents of the previous read.
         uint32_t copyFromRAM(RenderWorker *worker, FramebufferChange &emptyFbChange, uint32_t width, uint32_t height, uint32_t rowStart, uint8_t siz, uint8_t fmt, const uint8_t *data, bool invalidateTargets, const ShaderLibrary *shaderLibrary);
+
+        // Only uploads and compares the specified rows. The previous read must hold the entire framebuffer and the CPU must have a copy of it.
+        bool canCopyRowsFromRAM(uint32_t width, uint32_t height, uint8_t siz) const;
+        void copyRowsFromRAM(RenderWorker *worker, FramebufferChange &emptyFbChange, uint32_t width, uint32_t height, uint32_t rowStart, uint32_t rowCount, uint8_t siz, uint8_t fmt, const uint8_t *data, const ShaderLibrary *shaderLibrary);
         void copyToNative(RenderWorker *worker, RenderTarget *srcTarget, uint32_t rowWidth, uint32_t rowStart, uint32_t rowEnd, uint8_t siz, uint8_t fmt, uint32_t ditherPattern, uint32_t ditherRandomSeed, const ShaderLibrary *shaderLibrary);
         void copyToRAM(uint32_t rowStart, uint32_t rowEnd, uint32_t width, uint8_t siz, uint8_t *data);
 
         static uint32_t getNativeSize(uint32_t width, uint32_t height, uint8_t siz);
+        static uint32_t countDifferentPixels(const uint8_t *newData, uint32_t newSize, const uint8_t *curData, uint32_t curSize, uint8_t siz);
     };
 };
\ No newline at end of file
@@ -6,6 +6,8 @@
 
 #include "xxHash/xxh3.h"
 
+#include "common/rt64_common.h"
+
 #include "shaders/RasterPSDynamic.hlsl.spirv.h"
 #include "shaders/RasterPSDynamicMS.hlsl.spirv.h"
 #include "shaders/RasterPSSpecConstant.hlsl.spirv.h"
@@ -40,17 +42,22 @@ namespace RT64 {
     static const RenderFormat RasterPositionFormat = RenderFormat::R32G32B32A32_FLOAT;
     static const RenderFormat RasterTexcoordFormat = RenderFormat::R32G32_FLOAT;
     static const RenderFormat RasterColorFormat = RenderFormat::R32G32B32A32_FLOAT;
+    static const RenderFormat RasterRenderIndexFormat = RenderFormat::R32_UINT;
 
-    static const RenderInputSlot RasterInputSlots[3] = {
+    // The render index is read as per-instance data so draws can select their call through the start instance, which is
+    // offset into the instance buffer by both backends even when issued as part of an indirect multi-draw.
+    static const RenderInputSlot RasterInputSlots[4] = {
         RenderInputSlot(0, RenderFormatSize(RasterPositionFormat)),
         RenderInputSlot(1, RenderFormatSize(RasterTexcoordFormat)),
-        RenderInputSlot(2, RenderFormatSize(RasterColorFormat))
+        RenderInputSlot(2, RenderFormatSize(RasterColorFormat)),
+        RenderInputSlot(3, RenderFormatSize(RasterRenderIndexFormat), RenderInputSlotClassification::PER_INSTANCE_DATA)
     };
 
-    static const RenderInputElement RasterInputElements[3] = {
+    static const RenderInputElement RasterInputElements[4] = {
         RenderInputElement("POSITION", 0, 0, RasterPositionFormat, 0, 0),
         RenderInputElement("TEXCOORD", 0, 1, RasterTexcoordFormat, 1, 0),
-        RenderInputElement("COLOR", 0, 2, RasterColorFormat, 2, 0)
+        RenderInputElement("COLOR", 0, 2, RasterColorFormat, 2, 0),
+        RenderInputElement("RENDERINDEX", 0, 3, RasterRenderIndexFormat, 3, 0)
     };
 
     // RasterShader
@@ -181,25 +188,30 @@ namespace RT64 {
         // Generate vertex shader.
         std::stringstream vss;
         vss << RasterVSString;
-        vss << "RenderParams getRenderParams() {" + renderParamsCode + "; return rp; }";
+        vss << "RenderParams getRenderParams(uint renderIndex) {" + renderParamsCode + "; return rp; }";
         vss <<
             "void VSMain("
             "   in float4 iPosition : POSITION,"
             "   in float2 iUV : TEXCOORD,"
             "   in float4 iColor : COLOR,"
+            "   in uint iRenderIndex : RENDERINDEX,"
             "   out float4 oPosition : SV_POSITION,"
             "   out float2 oUV : TEXCOORD,"
             "   out float4 oSmoothColor : COLOR0";
 
         if (!desc.flags.smoothShade) {
-            vss << ", out float4 oFlatColor : COLOR1) {";
+            vss << ", out float4 oFlatColor : COLOR1";
         }
-        else {
-            vss << ") { float4 oFlatColor;";
+
+        vss << ", nointerpolation out uint oRenderIndex : RENDERINDEX) {";
+
+        if (desc.flags.smoothShade) {
+            vss << "float4 oFlatColor;";
         }
 
         vss <<
-            "   RasterVS(getRenderParams(), iPosition, iUV, iColor, oPosition, oUV, oSmoothColor, oFlatColor);"
+            "   oRenderIndex = iRenderIndex;"
+            "   RasterVS(getRenderParams(iRenderIndex), iPosition, iUV, iColor, oPosition, oUV, oSmoothColor, oFlatColor);"
             "}";
 
         // Generate pixel shader.
@@ -216,7 +228,7 @@ namespace RT64 {
         }
 
         pss << RasterPSString;
-        pss << "RenderParams getRenderParams() {" + renderParamsCode + "; return rp; }";
+        pss << "RenderParams getRenderParams(uint renderIndex) {" + renderParamsCode + "; return rp; }";
         pss <<
             "void PSMain("
             "  in float4 vertexPosition : SV_POSITION"
@@ -227,6 +239,8 @@ namespace RT64 {
             pss << ", nointerpolation in float4 vertexFlatColor : COLOR1";
         }
 
+        pss << ", nointerpolation in uint renderIndex : RENDERINDEX";
+
         if (multisampling) {
             pss << ", in uint sampleIndex : SV_SampleIndex";
         }
@@ -255,7 +269,7 @@ namespace RT64 {
         }
 
         pss <<
-            "   RasterPS(getRenderParams(), outputDepth, vertexPosition, vertexUV, vertexSmoothColor, vertexFlatColor, sampleIndex, resultColor, resultAlpha, resultDepth);"
+            "   RasterPS(getRenderParams(renderIndex), renderIndex, outputDepth, vertexPosition, vertexUV, vertexSmoothColor, vertexFlatColor, sampleIndex, resultColor, resultAlpha, resultDepth);"
             "}";
 
         return { vss.str(), pss.str() };
@@ -513,6 +527,11 @@ namespace RT64 {
             uint32_t pipelineIndex = pipelineStateIndex(creation.alphaBlend, creation.culling, creation.zCmp, creation.zUpd, creation.zDecal, creation.cvgAdd);
             pipelines[pipelineIndex] = RasterShader::createPipeline(creation);
         }
+
+        // The last thread to finish reports the time it took to create all the pipelines.
+        if (++pipelineThreadsFinished == pipelineThreadCreations.size()) {
+            RT64_LOG_PRINTF("Created ubershader pipelines in %.2f ms.", pipelineCreationTimer.elapsedMilliseconds());
+        }
     }
 
     void RasterShaderUber::waitForPipelineCreation() {
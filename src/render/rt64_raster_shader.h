@@ -6,9 +6,11 @@
 
 #include "rt64_shader_common.h"
 
+#include <atomic>
 #include <mutex>
 #include <thread>
 
+#include "common/rt64_elapsed_timer.h"
 #include "rhi/rt64_render_interface.h"
 #include "shared/rt64_blender.h"
 #include "shared/rt64_color_combiner.h"
@@ -69,6 +71,8 @@ namespace RT64 {
         std::unique_ptr<RenderPipelineLayout> pipelineLayout;
         std::vector<std::vector<PipelineCreation>> pipelineThreadCreations;
         std::vector<std::unique_ptr<std::thread>> pipelineThreads;
+        std::atomic<uint32_t> pipelineThreadsFinished = 0;
+        ElapsedTimer pipelineCreationTimer;
         std::unique_ptr<RenderShader> vertexShader;
         std::unique_ptr<RenderShader> pixelShader;
 
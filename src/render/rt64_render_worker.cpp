@@ -7,39 +7,117 @@
 namespace RT64 {
     // RenderWorker
 
-    RenderWorker::RenderWorker(RenderDevice *device, const std::string &name, RenderCommandListType commandListType) {
+    RenderWorker::RenderWorker(RenderDevice *device, const std::string &name, RenderCommandListType commandListType, uint32_t frameCount) {
         assert(device != nullptr);
+        assert(frameCount > 0);
 
         this->device = device;
         this->name = name;
+        this->commandListType = commandListType;
 
         commandQueue = device->createCommandQueue(commandListType);
-        commandList = device->createCommandList(commandListType);
-        commandFence = device->createCommandFence();
+        frames.resize(frameCount);
+        for (Frame &frame : frames) {
+            frame.commandList = device->createCommandList(commandListType);
+            frame.commandFence = device->createCommandFence();
+        }
+
+        commandList = frames[frameIndex].commandList.get();
+    }
+
+    RenderWorker::~RenderWorker() {
+        wait();
+    }
+
+    uint64_t RenderWorker::execute() {
+        std::scoped_lock<std::mutex> frameLock(frameMutex);
+        Frame &frame = frames[frameIndex];
+        assert(!frame.pending);
+
+        frame.submissionCommandLists.emplace_back(commandList);
+        commandQueue->executeCommandLists(frame.submissionCommandLists.data(), uint32_t(frame.submissionCommandLists.size()), frame.commandFence.get());
+        frame.submissionCommandLists.clear();
+        frame.segmentCount = 0;
+        frame.submissionId = ++submissionCounter;
+        frame.pending = true;
+
+        // The next command list can only be recorded once the GPU is done with its last submission.
+        frameIndex = (frameIndex + 1) % frames.size();
+        Frame &nextFrame = frames[frameIndex];
+        if (nextFrame.pending) {
+            waitFrame(nextFrame);
+        }
+
+        commandList = nextFrame.commandList.get();
+        return frame.submissionId;
+    }
+
+    RenderCommandList *RenderWorker::getSecondaryCommandList(uint32_t index) {
+        Frame &frame = frames[frameIndex];
+        while (index >= frame.secondaryCommandLists.size()) {
+            frame.secondaryCommandLists.emplace_back(device->createCommandList(commandListType));
+        }
+
+        return frame.secondaryCommandLists[index].get();
     }
 
-    RenderWorker::~RenderWorker() { }
+    void RenderWorker::insertCommandList(const RenderCommandList *secondaryCommandList) {
+        assert(secondaryCommandList != nullptr);
+
+        Frame &frame = frames[frameIndex];
+        commandList->end();
+        frame.submissionCommandLists.emplace_back(commandList);
+        frame.submissionCommandLists.emplace_back(secondaryCommandList);
 
-    void RenderWorker::execute() {
-        commandQueue->executeCommandLists(commandList.get(), commandFence.get());
+        if (frame.segmentCount >= frame.segmentCommandLists.size()) {
+            frame.segmentCommandLists.emplace_back(device->createCommandList(commandListType));
+        }
+
+        commandList = frame.segmentCommandLists[frame.segmentCount++].get();
+        commandList->begin();
     }
 
     void RenderWorker::wait() {
-        commandQueue->waitForCommandFence(commandFence.get());
+        std::scoped_lock<std::mutex> frameLock(frameMutex);
+        for (Frame &frame : frames) {
+            if (frame.pending) {
+                waitFrame(frame);
+            }
+        }
+    }
+
+    void RenderWorker::wait(uint64_t submissionId) {
+        std::scoped_lock<std::mutex> frameLock(frameMutex);
+        for (Frame &frame : frames) {
+            if (frame.pending && (frame.submissionId == submissionId)) {
+                waitFrame(frame);
+                break;
+            }
+        }
+    }
+
+    void RenderWorker::waitFrame(Frame &frame) {
+        // Fences can only be waited on once after every submission.
+        commandQueue->waitForCommandFence(frame.commandFence.get());
+        frame.pending = false;
     }
 
     // RenderWorkerExecution
 
-    RenderWorkerExecution::RenderWorkerExecution(RenderWorker *worker) {
+    RenderWorkerExecution::RenderWorkerExecution(RenderWorker *worker, bool waitForCompletion) {
         assert(worker != nullptr);
 
         this->worker = worker;
+        this->waitForCompletion = waitForCompletion;
         worker->commandList->begin();
     }
 
     RenderWorkerExecution::~RenderWorkerExecution() {
         worker->commandList->end();
         worker->execute();
-        worker->wait();
+
+        if (waitForCompletion) {
+            worker->wait();
+        }
     }
-};
\ No newline at end of file
+};
@@ -4,28 +4,74 @@
 
 #pragma once
 
+#include <mutex>
+
 #include "rhi/rt64_render_interface.h"
 
 namespace RT64 {
+    // Owns a ring of command lists and fences so a new command list can be recorded while the previous submissions are still
+    // being executed by the GPU. Recording only stalls when the next command list in the ring is still in flight.
+    // Each frame can also be split into segments with secondary command lists recorded on other threads inserted between them.
+    // Every command list of the frame is submitted in order as a single batch when the frame is executed.
     struct RenderWorker {
+        struct Frame {
+            std::unique_ptr<RenderCommandList> commandList;
+            std::unique_ptr<RenderCommandFence> commandFence;
+            std::vector<std::unique_ptr<RenderCommandList>> segmentCommandLists;
+            std::vector<std::unique_ptr<RenderCommandList>> secondaryCommandLists;
+            std::vector<const RenderCommandList *> submissionCommandLists;
+            uint32_t segmentCount = 0;
+            uint64_t submissionId = 0;
+            bool pending = false;
+        };
+
+        static const uint32_t DefaultFrameCount = 2;
+
         RenderDevice *device = nullptr;
         std::string name;
+        RenderCommandListType commandListType = RenderCommandListType::UNKNOWN;
         std::unique_ptr<RenderCommandQueue> commandQueue;
-        std::unique_ptr<RenderCommandList> commandList;
-        std::unique_ptr<RenderCommandFence> commandFence;
+        std::vector<Frame> frames;
+        uint32_t frameIndex = 0;
+        uint64_t submissionCounter = 0;
+        std::mutex frameMutex;
 
-        RenderWorker(RenderDevice *device, const std::string &name, RenderCommandListType commandListType);
+        // Command list of the current frame. Only valid until the next call to execute().
+        RenderCommandList *commandList = nullptr;
+
+        RenderWorker(RenderDevice *device, const std::string &name, RenderCommandListType commandListType, uint32_t frameCount = DefaultFrameCount);
         ~RenderWorker();
-        void execute();
+
+        // Submits the current command list and returns the ID of the submission. Does not wait for the GPU.
+        uint64_t execute();
+
+        // Returns a secondary command list of the current frame. It can be recorded on any thread, but it must be opened and closed by
+        // the caller and it must be inserted into the submission order with insertCommandList() before the frame is executed.
+        RenderCommandList *getSecondaryCommandList(uint32_t index);
+
+        // Closes the current command list and submits the secondary command list after it. The secondary command list only needs to be
+        // closed by the time the frame is executed. Recording continues on a new command list that is submitted after the secondary one.
+        void insertCommandList(const RenderCommandList *secondaryCommandList);
+
+        // Waits for every submission that is still in flight.
         void wait();
+
+        // Waits only for the submission with the specified ID. Does nothing if it was already waited on.
+        void wait(uint64_t submissionId);
+
+    private:
+        void waitFrame(Frame &frame);
     };
 
     // RAII convenience class for aiding opening, closing and execution of command lists inside a scope.
+    // The execution waits for the GPU to finish when the scope ends unless waiting is disabled, in which case the caller must
+    // wait on the worker before reusing any of the resources used by the command list.
 
     struct RenderWorkerExecution {
         RenderWorker *worker;
+        bool waitForCompletion;
 
-        RenderWorkerExecution(RenderWorker *worker);
+        RenderWorkerExecution(RenderWorker *worker, bool waitForCompletion = true);
         ~RenderWorkerExecution();
     };
-};
\ No newline at end of file
+};
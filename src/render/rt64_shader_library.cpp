@@ -8,7 +8,6 @@
 #include "shared/rt64_render_target_copy.h"
 #include "shared/rt64_rsp_vertex_test_z.h"
 
-#include "shaders/FbChangesClearCS.hlsl.spirv.h"
 #include "shaders/FbChangesDrawColorPS.hlsl.spirv.h"
 #include "shaders/FbChangesDrawDepthPS.hlsl.spirv.h"
 #include "shaders/FbReadAnyChangesCS.hlsl.spirv.h"
@@ -49,7 +48,6 @@
 #include "shaders/PostProcessPS.hlsl.spirv.h"
 
 #ifdef _WIN32
-#   include "shaders/FbChangesClearCS.hlsl.dxil.h"
 #   include "shaders/FbChangesDrawColorPS.hlsl.dxil.h"
 #   include "shaders/FbChangesDrawDepthPS.hlsl.dxil.h"
 #   include "shaders/FbReadAnyChangesCS.hlsl.dxil.h"
@@ -272,19 +270,6 @@ namespace RT64 {
             idle.pipeline = device->createComputePipeline(pipelineDesc);
         }
 
-        // Framebuffer changes clear.
-        {
-            FramebufferClearChangesDescriptorSet descriptorSet;
-            layoutBuilder.begin();
-            layoutBuilder.addDescriptorSet(descriptorSet);
-            layoutBuilder.end();
-            fbChangesClear.pipelineLayout = layoutBuilder.create(device);
-
-            std::unique_ptr<RenderShader> computeShader = device->createShader(CREATE_SHADER_INPUTS(FbChangesClearCSBlobDXIL, FbChangesClearCSBlobSPIRV, "CSMain", shaderFormat));
-            RenderComputePipelineDesc pipelineDesc(fbChangesClear.pipelineLayout.get(), computeShader.get());
-            fbChangesClear.pipeline = device->createComputePipeline(pipelineDesc);
-        }
-
         // Framebuffer read any changes and full.
         {
             FramebufferReadChangesDescriptorBufferSet descriptorBufferSet;
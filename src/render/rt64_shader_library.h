@@ -26,7 +26,6 @@ namespace RT64 {
         ShaderRecord boxFilter;
         ShaderRecord compose;
         ShaderRecord debug;
-        ShaderRecord fbChangesClear;
         ShaderRecord fbChangesDrawColor;
         ShaderRecord fbChangesDrawDepth;
         ShaderRecord fbReadAnyChanges;
@@ -13,7 +13,7 @@ namespace RT64 {
     // TextureMap
 
     TextureMap::TextureMap() {
-        globalVersion = 0;
+        changeLogStart = 0;
         lockCounter = 0;
     }
 
@@ -36,7 +36,6 @@ namespace RT64 {
             textureIndex = static_cast<uint32_t>(textures.size());
             textures.push_back(nullptr);
             hashes.push_back(0);
-            versions.push_back(0);
             creationFrames.push_back(0);
             listIterators.push_back(accessList.end());
         }
@@ -44,9 +43,8 @@ namespace RT64 {
         hashMap[hash] = textureIndex;
         textures[textureIndex] = texture;
         hashes[textureIndex] = hash;
-        versions[textureIndex]++;
         creationFrames[textureIndex] = creationFrame;
-        globalVersion++;
+        logChange(textureIndex, texture);
 
         accessList.push_front({ textureIndex, creationFrame });
         listIterators[textureIndex] = accessList.begin();
@@ -99,6 +97,7 @@ namespace RT64 {
                 listIterators[textureIndex] = accessList.end();
                 hashMap.erase(textureHash);
                 evictedHashes.push_back(textureHash);
+                logChange(textureIndex, nullptr);
                 it = decltype(it)(accessList.erase(std::next(it).base()));
             }
             // Stop iterating if we reach an entry that has been used in the present.
@@ -139,10 +138,36 @@ namespace RT64 {
         return textures.size();
     }
 
+    void TextureMap::logChange(uint32_t index, const Texture *texture) {
+        // Discarding half of the log at a time keeps the cost of erasing the front constant per change.
+        if (changeLog.size() >= ChangeLogMaxSize) {
+            const size_t discardCount = changeLog.size() / 2;
+            changeLog.erase(changeLog.begin(), changeLog.begin() + discardCount);
+            changeLogStart += discardCount;
+        }
+
+        changeLog.emplace_back(Change{ index, texture });
+    }
+
+    bool TextureMap::readChanges(uint64_t &changeCursor, std::vector<Change> &dstChanges) const {
+        // If the changes the cursor points to were already discarded, the consumer must read every texture in the map instead.
+        const uint64_t changeLogEnd = changeLogStart + changeLog.size();
+        if (changeCursor < changeLogStart) {
+            changeCursor = changeLogEnd;
+            return false;
+        }
+
+        assert(changeCursor <= changeLogEnd);
+        dstChanges.insert(dstChanges.end(), changeLog.begin() + (changeCursor - changeLogStart), changeLog.end());
+        changeCursor = changeLogEnd;
+        return true;
+    }
+
     // TextureCache
 
     TextureCache::TextureCache(RenderWorker *worker, const ShaderLibrary *shaderLibrary, bool developerMode) {
         assert(worker != nullptr);
+        assert((worker->frames.size() <= UploadBatchCount) && "The worker must not have more batches in flight than the upload resources available.");
 
         this->worker = worker;
         this->shaderLibrary = shaderLibrary;
@@ -168,8 +193,11 @@ namespace RT64 {
             delete uploadThread;
         }
         
-        descriptorSets.clear();
-        uploadResources.clear();
+        for (uint32_t i = 0; i < UploadBatchCount; i++) {
+            batchDescriptorSets[i].clear();
+            batchUploadResources[i].clear();
+        }
+
         uploadResourcePool.reset(nullptr);
     }
     
@@ -221,10 +249,37 @@ namespace RT64 {
         std::vector<TextureUpload> queueCopy;
         std::vector<TextureUpload> newQueue;
         std::vector<Texture *> texturesUploaded;
+        std::vector<Texture *> texturesPending;
+        size_t pendingCount = 0;
+        uint64_t pendingSubmissionId = 0;
+        uint32_t batchIndex = 0;
         std::vector<RenderTextureBarrier> beforeCopyBarriers;
         std::vector<RenderTextureBarrier> beforeDecodeBarriers;
         std::vector<RenderTextureBarrier> afterDecodeBarriers;
 
+        // Consumers of the texture cache wait on the timeline of the queue on the GPU when it's supported, so the textures can be
+        // added to the map as soon as the batch is submitted. The timeline value the batch signals is published along with them.
+        const bool queueTimelines = worker->device->getCapabilities().queueTimelines;
+        auto publishBatch = [&](const std::vector<Texture *> &textures, size_t batchSize, uint64_t timelineValue) {
+            {
+                const std::unique_lock<std::mutex> lock(textureMapMutex);
+                for (Texture *texture : textures) {
+                    textureMap.add(texture->hash, texture->creationFrame, texture);
+                }
+
+                publishedTimelineValue = std::max(publishedTimelineValue, timelineValue);
+            }
+
+            // Make the new queue the remaining subsection of the upload queue that wasn't processed in the batch.
+            {
+                const std::unique_lock<std::mutex> queueLock(uploadQueueMutex);
+                newQueue = std::vector<TextureUpload>(uploadQueue.begin() + batchSize, uploadQueue.end());
+                uploadQueue = std::move(newQueue);
+            }
+
+            uploadQueueFinished.notify_all();
+        };
+
         while (uploadThreadRunning) {
             // Check the top of the queue or wait if it's empty.
             {
@@ -233,13 +288,20 @@ namespace RT64 {
                     return !uploadThreadRunning || !uploadQueue.empty();
                 });
 
-                if (!uploadQueue.empty()) {
-                    queueCopy = uploadQueue;
+                // Only the uploads that aren't part of the batch that is still in flight are processed.
+                if (uploadQueue.size() > pendingCount) {
+                    queueCopy.assign(uploadQueue.begin() + pendingCount, uploadQueue.end());
                 }
             }
 
+            uint64_t submissionId = 0;
+            uint64_t submissionTimelineValue = 0;
+            texturesUploaded.clear();
             if (!queueCopy.empty()) {
-                // Create new upload buffers and descriptor heaps to fill out the required size.
+                // Create new upload buffers and descriptor heaps to fill out the required size. The resources alternate between
+                // batches so the next batch can be recorded while the GPU is still executing the previous one.
+                std::vector<std::unique_ptr<RenderBuffer>> &uploadResources = batchUploadResources[batchIndex];
+                std::vector<std::unique_ptr<TextureDecodeDescriptorSet>> &descriptorSets = batchDescriptorSets[batchIndex];
                 const size_t queueSize = queueCopy.size();
                 const uint64_t TMEMSize = 0x1000;
                 for (size_t i = uploadResources.size(); i < queueSize; i++) {
@@ -252,8 +314,7 @@ namespace RT64 {
 
                 // Upload all textures in the queue.
                 {
-                    RenderWorkerExecution execution(worker);
-                    texturesUploaded.clear();
+                    worker->commandList->begin();
                     beforeCopyBarriers.clear();
                     for (size_t i = 0; i < queueSize; i++) {
                         static uint32_t TMEMGlobalCounter = 0;
@@ -346,25 +407,46 @@ namespace RT64 {
                     if (!afterDecodeBarriers.empty()) {
                         worker->commandList->barriers(RenderBarrierStage::COMPUTE, afterDecodeBarriers);
                     }
-                }
 
-                // Add all the textures to the map once they're ready.
-                {
-                    const std::unique_lock<std::mutex> lock(textureMapMutex);
-                    for (Texture *texture : texturesUploaded) {
-                        textureMap.add(texture->hash, texture->creationFrame, texture);
+                    worker->commandList->end();
+                    submissionId = worker->execute();
+
+                    // The upload thread is the only one that submits to this queue, so the timeline value is the one signaled by the
+                    // execution that was just submitted.
+                    if (queueTimelines) {
+                        submissionTimelineValue = worker->commandQueue->getTimelineValue();
                     }
                 }
+            }
 
-                // Make the new queue the remaining subsection of the upload queue that wasn't processed in this batch.
-                {
-                    const std::unique_lock<std::mutex> queueLock(uploadQueueMutex);
-                    newQueue = std::vector<TextureUpload>(uploadQueue.begin() + queueSize, uploadQueue.end());
-                    uploadQueue = std::move(newQueue);
+            if (queueTimelines) {
+                if (!queueCopy.empty()) {
+                    publishBatch(texturesUploaded, queueCopy.size(), submissionTimelineValue);
+                }
+            }
+            else {
+                // Add all the textures of the previous batch to the map once they're ready.
+                if (pendingCount > 0) {
+                    worker->wait(pendingSubmissionId);
+                    publishBatch(texturesPending, pendingCount, 0);
                 }
 
-                queueCopy.clear();
-                uploadQueueFinished.notify_all();
+                texturesPending.swap(texturesUploaded);
+                pendingCount = queueCopy.size();
+                pendingSubmissionId = submissionId;
+            }
+
+            batchIndex = (batchIndex + 1) % UploadBatchCount;
+            queueCopy.clear();
+        }
+
+        // Wait for the last batch so its textures can be owned by the map.
+        worker->wait();
+
+        if (pendingCount > 0) {
+            const std::unique_lock<std::mutex> lock(textureMapMutex);
+            for (Texture *texture : texturesPending) {
+                textureMap.add(texture->hash, texture->creationFrame, texture);
             }
         }
     }
@@ -397,6 +479,25 @@ namespace RT64 {
         });
     }
 
+    void TextureCache::queueWaitForGPUUploads(RenderCommandQueue *queue) {
+        assert(queue != nullptr);
+
+        // Without timelines, textures are only added to the map after the CPU has waited for the upload to finish. Only the value
+        // signaled by the last published batch can be waited on, as the live value of the timeline might belong to a batch that
+        // hasn't been submitted yet.
+        if (worker->device->getCapabilities().queueTimelines) {
+            uint64_t timelineValue = 0;
+            {
+                const std::unique_lock<std::mutex> lock(textureMapMutex);
+                timelineValue = publishedTimelineValue;
+            }
+
+            if (timelineValue > 0) {
+                queue->waitForCommandQueue(worker->commandQueue.get(), timelineValue);
+            }
+        }
+    }
+
     bool TextureCache::useTexture(uint64_t hash, uint64_t submissionFrame, uint32_t &textureIndex) {
         const std::unique_lock<std::mutex> lock(textureMapMutex);
         return textureMap.use(hash, submissionFrame, textureIndex);
@@ -45,13 +45,25 @@ namespace RT64 {
         typedef std::pair<uint32_t, uint64_t> AccessPair;
         typedef std::list<AccessPair> AccessList;
 
+        // Every texture added to or evicted from a slot is appended to the change log, so consumers can keep their own view of the
+        // map up to date with a cost that depends on how many textures changed instead of how many textures are resident.
+        struct Change {
+            uint32_t index;
+
+            // Null if the texture in the slot was evicted.
+            const Texture *texture;
+        };
+
+        // Once the log grows past this size, the oldest half is discarded. Consumers that fall behind must read the whole map again.
+        static const size_t ChangeLogMaxSize = 16384;
+
         std::unordered_map<uint64_t, uint32_t> hashMap;
         std::vector<const Texture *> textures;
         std::vector<uint64_t> hashes;
         std::vector<uint32_t> freeSpaces;
-        std::vector<uint32_t> versions;
         std::vector<uint64_t> creationFrames;
-        uint32_t globalVersion;
+        std::vector<Change> changeLog;
+        uint64_t changeLogStart;
         AccessList accessList;
         std::vector<AccessList::iterator> listIterators;
         std::vector<const Texture *> evictedTextures;
@@ -66,13 +78,17 @@ namespace RT64 {
         void decrementLock();
         const Texture *get(uint32_t index) const;
         size_t getMaxIndex() const;
+        void logChange(uint32_t index, const Texture *texture);
+        bool readChanges(uint64_t &changeCursor, std::vector<Change> &dstChanges) const;
     };
 
     struct TextureCache {
+        static const uint32_t UploadBatchCount = 2;
+
         const ShaderLibrary *shaderLibrary;
         std::vector<TextureUpload> uploadQueue;
-        std::vector<std::unique_ptr<RenderBuffer>> uploadResources;
-        std::vector<std::unique_ptr<TextureDecodeDescriptorSet>> descriptorSets;
+        std::vector<std::unique_ptr<RenderBuffer>> batchUploadResources[UploadBatchCount];
+        std::vector<std::unique_ptr<TextureDecodeDescriptorSet>> batchDescriptorSets[UploadBatchCount];
         std::mutex uploadQueueMutex;
         std::condition_variable uploadQueueChanged;
         std::condition_variable uploadQueueFinished;
@@ -80,6 +96,7 @@ namespace RT64 {
         std::atomic<bool> uploadThreadRunning;
         TextureMap textureMap;
         std::mutex textureMapMutex;
+        uint64_t publishedTimelineValue = 0;
         RenderWorker *worker;
         std::unique_ptr<RenderPool> uploadResourcePool;
         bool developerMode;
@@ -89,6 +106,7 @@ namespace RT64 {
         void uploadThreadLoop();
         void queueGPUUploadTMEM(uint64_t hash, uint64_t creationFrame, const uint8_t *bytes, int bytesCount, int width, int height, uint32_t tlut, const LoadTile &loadTile);
         void waitForGPUUploads();
+        void queueWaitForGPUUploads(RenderCommandQueue *queue);
         bool useTexture(uint64_t hash, uint64_t submissionFrame, uint32_t &textureIndex);
         bool evict(uint64_t submissionFrame, std::vector<uint64_t> &evictedHashes);
         void incrementLock();
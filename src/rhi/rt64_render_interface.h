@@ -82,6 +82,11 @@ namespace RT64 {
         virtual RenderWindow getWindow() const = 0;
         virtual bool isEmpty() const = 0;
 
+        // FIFO is always supported. Backends that must recreate the swap chain to change the present mode will report it through needsResize().
+        virtual bool isPresentModeSupported(RenderPresentMode presentMode) const = 0;
+        virtual bool setPresentMode(RenderPresentMode presentMode) = 0;
+        virtual RenderPresentMode getPresentMode() const = 0;
+
         // Only valid if displayTiming is enabled in capabilities.
         virtual uint32_t getRefreshRate() const = 0;
     };
@@ -101,6 +106,8 @@ namespace RT64 {
         virtual void traceRays(uint32_t width, uint32_t height, uint32_t depth, RenderBufferReference shaderBindingTable, const RenderShaderBindingGroupsInfo &shaderBindingGroupsInfo) = 0;
         virtual void drawInstanced(uint32_t vertexCountPerInstance, uint32_t instanceCount, uint32_t startVertexLocation, uint32_t startInstanceLocation) = 0;
         virtual void drawIndexedInstanced(uint32_t indexCountPerInstance, uint32_t instanceCount, uint32_t startIndexLocation, int32_t baseVertexLocation, uint32_t startInstanceLocation) = 0;
+        virtual void drawInstancedIndirect(RenderBufferReference argumentBuffer, uint32_t drawCount) = 0;
+        virtual void drawIndexedInstancedIndirect(RenderBufferReference argumentBuffer, uint32_t drawCount) = 0;
         virtual void setPipeline(const RenderPipeline *pipeline) = 0;
         virtual void setComputePipelineLayout(const RenderPipelineLayout *pipelineLayout) = 0;
         virtual void setComputePushConstants(uint32_t rangeIndex, const void *data) = 0;
@@ -175,6 +182,14 @@ namespace RT64 {
         virtual void executeCommandLists(const RenderCommandList **commandLists, uint32_t commandListCount, RenderCommandFence *signalFence = nullptr) = 0;
         virtual void waitForCommandFence(RenderCommandFence *fence) = 0;
 
+        // Every execution advances the timeline of the queue by one. Returns the value the timeline will reach once the last execution is done.
+        // Only available if queueTimelines is enabled in capabilities.
+        virtual uint64_t getTimelineValue() = 0;
+
+        // Executions submitted after this call won't start on the GPU until the other queue's timeline reaches the value.
+        // Only available if queueTimelines is enabled in capabilities.
+        virtual void waitForCommandQueue(RenderCommandQueue *queue, uint64_t value) = 0;
+
         // Concrete implementation shortcuts.
         inline void executeCommandLists(const RenderCommandList *commandLists, RenderCommandFence *signalFence = nullptr) {
             executeCommandLists(&commandLists, 1, signalFence);
@@ -209,6 +224,12 @@ namespace RT64 {
         virtual void setShaderBindingTableInfo(RenderShaderBindingTableInfo &tableInfo, const RenderShaderBindingGroups &groups, const RenderPipeline *pipeline, RenderDescriptorSet **descriptorSets, uint32_t descriptorSetCount) = 0;
         virtual const RenderDeviceCapabilities &getCapabilities() const = 0;
         virtual RenderSampleCounts getSampleCountsSupported(RenderFormat format) const = 0;
+        virtual RenderDescriptorSetStats getDescriptorSetStats() const = 0;
+
+        // Data of pipelines compiled by the driver that can be persisted between sessions. Loading must be done before creating
+        // any pipelines, and data created by a different device or driver version will be rejected.
+        virtual bool loadPipelineCache(const void *data, uint64_t size) = 0;
+        virtual bool savePipelineCache(std::vector<uint8_t> &data) = 0;
     };
 
     struct RenderInterface {
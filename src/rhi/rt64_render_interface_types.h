@@ -324,6 +324,13 @@ namespace RT64 {
         BOTTOM_LEVEL
     };
 
+    enum class RenderPresentMode {
+        FIFO,
+        FIFO_RELAXED,
+        MAILBOX,
+        IMMEDIATE
+    };
+
     namespace RenderShaderStageFlag {
         enum Bits : uint32_t {
             NONE = 0U,
@@ -354,7 +361,8 @@ namespace RT64 {
             ACCELERATION_STRUCTURE_INPUT = 1U << 6,
             ACCELERATION_STRUCTURE_SCRATCH = 1U << 7,
             SHADER_BINDING_TABLE = 1U << 8,
-            UNORDERED_ACCESS = 1U << 9
+            UNORDERED_ACCESS = 1U << 9,
+            INDIRECT = 1U << 10
         };
     };
 
@@ -577,6 +585,23 @@ namespace RT64 {
         }
     };
 
+    // Layout matches both D3D12_DRAW_ARGUMENTS and VkDrawIndirectCommand.
+    struct RenderDrawIndirectArguments {
+        uint32_t vertexCountPerInstance = 0;
+        uint32_t instanceCount = 0;
+        uint32_t startVertexLocation = 0;
+        uint32_t startInstanceLocation = 0;
+    };
+
+    // Layout matches both D3D12_DRAW_INDEXED_ARGUMENTS and VkDrawIndexedIndirectCommand.
+    struct RenderDrawIndexedIndirectArguments {
+        uint32_t indexCountPerInstance = 0;
+        uint32_t instanceCount = 0;
+        uint32_t startIndexLocation = 0;
+        int32_t baseVertexLocation = 0;
+        uint32_t startInstanceLocation = 0;
+    };
+
     struct RenderBufferBarrier {
         RenderBuffer *buffer = nullptr;
         RenderBufferAccessBits accessBits = RenderBufferAccess::NONE;
@@ -1529,6 +1554,14 @@ namespace RT64 {
         RenderShaderBindingGroupsInfo groups;
     };
 
+    struct RenderDescriptorSetStats {
+        // Pools the descriptor sets are allocated from. Always zero if the backend doesn't use pools.
+        uint32_t poolCount = 0;
+
+        // Descriptor sets that are currently alive.
+        uint32_t setCount = 0;
+    };
+
     struct RenderDeviceCapabilities {
         // Raytracing.
         bool raytracing = false;
@@ -1545,6 +1578,12 @@ namespace RT64 {
         bool presentWait = false;
         bool displayTiming = false;
 
+        // Synchronization.
+        bool queueTimelines = false;
+
+        // Draw.
+        bool multiDrawIndirect = false;
+
         // HDR.
         bool preferHDR = false;
     };
@@ -1,10 +0,0 @@
-//
-// RT64
-//
-
-RWStructuredBuffer<uint> gOutputCount : register(u0);
-
-[numthreads(1, 1, 1)]
-void CSMain() {
-    gOutputCount[0] = 0;
-}
\ No newline at end of file
@@ -8,7 +8,6 @@
 [[vk::push_constant]] ConstantBuffer<FbCommonCB> gConstants : register(b0, space0);
 Buffer<uint> gNewInput : register(t1, space0);
 Buffer<uint> gCurInput : register(t2, space0);
-RWStructuredBuffer<uint> gOutputCount : register(u3, space0);
 RWTexture2D<float4> gOutputChangeColor : register(u0, space1);
 RWTexture2D<float> gOutputChangeDepth : register(u1, space1);
 RWTexture2D<uint> gOutputChangeBoolean : register(u2, space1);
@@ -16,8 +15,9 @@ RWTexture2D<uint> gOutputChangeBoolean : register(u2, space1);
 [numthreads(FB_COMMON_WORKGROUP_SIZE, FB_COMMON_WORKGROUP_SIZE, 1)]
 void CSMain(uint2 coord : SV_DispatchThreadID) {
     if ((coord.x < gConstants.resolution.x) && (coord.y < gConstants.resolution.y)) {
-        const uint bufferIndex = coord.y * gConstants.resolution.x.x + coord.x;
-        const uint2 pixelCoord = gConstants.offset + coord.xy;
+        // The offset is applied to the native buffers, as the change textures only hold the rows that were read.
+        const uint bufferIndex = (gConstants.offset.y + coord.y) * gConstants.resolution.x + gConstants.offset.x + coord.x;
+        const uint2 pixelCoord = coord.xy;
         if (gNewInput[bufferIndex] != gCurInput[bufferIndex]) {
             const uint swappedUint = EndianSwapUINT(gNewInput[bufferIndex], gConstants.siz);
             if (gConstants.fmt == G_IM_FMT_DEPTH) {
@@ -30,7 +30,6 @@ void CSMain(uint2 coord : SV_DispatchThreadID) {
             }
 
             gOutputChangeBoolean[pixelCoord] = 1;
-            InterlockedAdd(gOutputCount[0], 1);
         }
         else {
             gOutputChangeBoolean[pixelCoord] = 0;
@@ -14,8 +14,9 @@ RWTexture2D<uint> gOutputChangeBoolean : register(u2, space1);
 [numthreads(FB_COMMON_WORKGROUP_SIZE, FB_COMMON_WORKGROUP_SIZE, 1)]
 void CSMain(uint2 coord : SV_DispatchThreadID) {
     if ((coord.x < gConstants.resolution.x) && (coord.y < gConstants.resolution.y)) {
-        uint bufferIndex = coord.y * gConstants.resolution.x + coord.x;
-        uint2 pixelCoord = gConstants.offset + coord.xy;
+        // The offset is applied to the native buffer, as the change textures only hold the rows that were read.
+        uint bufferIndex = (gConstants.offset.y + coord.y) * gConstants.resolution.x + gConstants.offset.x + coord.x;
+        uint2 pixelCoord = coord.xy;
         uint swappedUint = EndianSwapUINT(gNewInput[bufferIndex], gConstants.siz);
         if (gConstants.fmt == G_IM_FMT_DEPTH) {
             const float newDepth = Depth16ToFloat(swappedUint);
@@ -14,12 +14,13 @@
 Texture2D<float4> gInputColor : register(t1);
 Texture1D<uint> gInputTLUT : register(t2);
 RWTexture2D<float4> gOutput : register(u3);
+StructuredBuffer<FbReinterpretRegion> gRegions : register(t4);
 
-float4 RGBA16toCI8(float4 inputColor, uint2 inputCoord, uint2 outputCoord) {
+float4 RGBA16toCI8(FbReinterpretRegion region, float4 inputColor, uint2 inputCoord, uint2 outputCoord) {
     // Drop down the input color to its RGBA16 version.
-    uint2 ditherCoord = inputCoord + gConstants.ditherOffset;
-    uint randomSeed = initRand(gConstants.ditherRandomSeed, ditherCoord.y * gConstants.resolution.x + ditherCoord.x, 16);
-    uint ditherValue = DitherPatternValue(gConstants.ditherPattern, ditherCoord, randomSeed);
+    uint2 ditherCoord = inputCoord + region.ditherOffset;
+    uint randomSeed = initRand(region.ditherRandomSeed, ditherCoord.y * region.resolution.x + ditherCoord.x, 16);
+    uint ditherValue = DitherPatternValue(region.ditherPattern, ditherCoord, randomSeed);
     uint nativeColor = Float4ToRGBA16(inputColor, ditherValue, gConstants.usesHDR);
 
     // Extract the lower or upper half of the value depending on the pixel misalignment.
@@ -73,13 +74,18 @@ float4 RGBA16toIA16(float4 inputColor, uint2 inputCoord, uint2 outputCoord) {
 }
 
 [numthreads(FB_COMMON_WORKGROUP_SIZE, FB_COMMON_WORKGROUP_SIZE, 1)]
-void CSMain(uint2 coord : SV_DispatchThreadID) {
-    if ((coord.x < gConstants.resolution.x) && (coord.y < gConstants.resolution.y)) {
-        uint2 inputCoord = uint2(floor(coord.x * gConstants.sampleScale), coord.y);
-        float4 inputColor = gInputColor.Load(uint3(inputCoord, 0));
+void CSMain(uint3 dispatchCoord : SV_DispatchThreadID) {
+    // Each layer of the dispatch corresponds to a different region.
+    const FbReinterpretRegion region = gRegions[gConstants.regionStart + dispatchCoord.z];
+    uint2 coord = dispatchCoord.xy;
+    if ((coord.x < region.resolution.x) && (coord.y < region.resolution.y)) {
+        // The source tile shares its atlas with other tiles, so the input must not be read from outside of its rect.
+        uint2 inputCoord = uint2(floor(coord.x * region.sampleScale), coord.y);
+        uint2 loadCoord = min(inputCoord, max(region.inputSize, 1) - 1);
+        float4 inputColor = gInputColor.Load(uint3(loadCoord + region.inputOffset, 0));
         float4 outputColor;
         if ((gConstants.srcFmt == G_IM_FMT_RGBA) && (gConstants.srcSiz == G_IM_SIZ_16b) && (gConstants.dstSiz == G_IM_SIZ_8b) && (gConstants.tlutFormat > 0)) {
-            outputColor = RGBA16toCI8(inputColor, inputCoord, coord);
+            outputColor = RGBA16toCI8(region, inputColor, inputCoord, coord);
         }
         else if ((gConstants.srcSiz == G_IM_SIZ_8b) && ((gConstants.dstFmt == G_IM_FMT_CI) || (gConstants.dstFmt == G_IM_FMT_I)) && (gConstants.dstSiz == G_IM_SIZ_8b)) {
             outputColor = ANY8toI8(inputColor, inputCoord, coord);
@@ -94,6 +100,6 @@ void CSMain(uint2 coord : SV_DispatchThreadID) {
             outputColor = inputColor;
         }
 
-        gOutput[coord] = outputColor;
+        gOutput[coord + region.outputOffset] = outputColor;
     }
 }
\ No newline at end of file
@@ -0,0 +1,28 @@
+//
+// RT64
+//
+
+#pragma once
+
+#include "Random.hlsli"
+
+// Signed noise added to the color after blending. Requires the frame parameters to be declared before including this file.
+float3 PostBlendDitherNoise(float2 vertexPosition, uint renderIndex) {
+    int2 pixelPosSeed = floor(vertexPosition);
+    uint randomSeed = initRand(FrParams.frameCount, renderIndex * (pixelPosSeed.y * 65536 + pixelPosSeed.x), 16);
+    const float Range = (7.0f * FrParams.ditherNoiseStrength) / 255.0f;
+    const float HalfRange = Range / 2.0f;
+    float3 noise;
+    noise.r = nextRand(randomSeed) * Range - HalfRange;
+    noise.g = nextRand(randomSeed) * Range - HalfRange;
+    noise.b = nextRand(randomSeed) * Range - HalfRange;
+    return noise;
+}
+
+// Adds the noise to a color that overwrites the destination. The result matches drawing the noise in separate passes: the color
+// is quantized to the precision of the target before the noise is added, and the sum is clamped to the UNORM range of the target.
+float3 ApplyPostBlendDitherNoise(float3 color, float2 vertexPosition, uint renderIndex, bool usesHDR) {
+    const float TargetMax = usesHDR ? 65535.0f : 255.0f;
+    float3 targetColor = round(saturate(color) * TargetMax) / TargetMax;
+    return saturate(targetColor + PostBlendDitherNoise(vertexPosition, renderIndex));
+}
@@ -4,15 +4,13 @@
 
 #include "shared/rt64_blender.h"
 #include "shared/rt64_color_combiner.h"
-#include "shared/rt64_raster_params.h"
 
 #include "Depth.hlsli"
 #include "FbRendererCommon.hlsli"
+#include "PostBlendDitherNoise.hlsli"
 #include "Random.hlsli"
 #include "TextureSampler.hlsli"
 
-[[vk::push_constant]] ConstantBuffer<RasterParams> gConstants : register(b0, space0);
-
 #if defined(MULTISAMPLING)
 Texture2DMS<float> gBackgroundDepth : register(t2, space3);
 
@@ -27,10 +25,10 @@ float sampleBackgroundDepth(int2 pixelPos, uint sampleIndex) {
 }
 #endif
 
-void RasterPS(const RenderParams rp, bool outputDepth, float4 vertexPosition, float2 vertexUV, float4 vertexSmoothColor, float4 vertexFlatColor,
+void RasterPS(const RenderParams rp, uint renderIndex, bool outputDepth, float4 vertexPosition, float2 vertexUV, float4 vertexSmoothColor, float4 vertexFlatColor,
     uint sampleIndex, inout float4 resultColor, inout float4 resultAlpha, out float resultDepth) 
 {
-    const uint instanceIndex = instanceRenderIndices[gConstants.renderIndex].instanceIndex;
+    const uint instanceIndex = instanceRenderIndices[renderIndex].instanceIndex;
     const float4 vertexColor = renderFlagSmoothShade(rp.flags) ? vertexSmoothColor : float4(vertexFlatColor.rgb, vertexSmoothColor.a);
     const ColorCombiner colorCombiner = { rp.ccL, rp.ccH };
     const OtherMode otherMode = { rp.omL, rp.omH };
@@ -107,13 +105,13 @@ void RasterPS(const RenderParams rp, bool outputDepth, float4 vertexPosition, fl
         lodScale = FbParams.resolutionScale.y;
     }
     
-    computeLOD(otherMode, instanceRenderIndices[gConstants.renderIndex].rdpTileCount, instanceRDPParams[instanceIndex].primLOD, lodScale, ddxuvx, ddyuvy, tileIndex0, tileIndex1, lodFraction);
+    computeLOD(otherMode, instanceRenderIndices[renderIndex].rdpTileCount, instanceRDPParams[instanceIndex].primLOD, lodScale, ddxuvx, ddyuvy, tileIndex0, tileIndex1, lodFraction);
 
     const bool oneCycleHardwareBug = (otherMode.cycleType() == G_CYC_1CYCLE);
     float4 texVal0 = float4(0.0f, 0.0f, 0.0f, 1.0f);
     float4 texVal1 = float4(0.0f, 0.0f, 0.0f, 1.0f);
     if (renderFlagUsesTexture0(rp.flags)) {
-        const uint globalTileIndex = instanceRenderIndices[gConstants.renderIndex].rdpTileIndex + tileIndex0;
+        const uint globalTileIndex = instanceRenderIndices[renderIndex].rdpTileIndex + tileIndex0;
         RDPTile rdpTile = RDPTiles[globalTileIndex];
         if (!renderFlagDynamicTiles(rp.flags)) {
             rdpTile.cms = renderCMS0(rp.flags);
@@ -128,7 +126,7 @@ void RasterPS(const RenderParams rp, bool outputDepth, float4 vertexPosition, fl
     
     if (renderFlagUsesTexture1(rp.flags)) {
         const bool oneCycleBug = renderFlagOneCycleHardwareBug(rp.flags);
-        const uint globalTileIndex = instanceRenderIndices[gConstants.renderIndex].rdpTileIndex + (oneCycleBug ? tileIndex0 : tileIndex1);
+        const uint globalTileIndex = instanceRenderIndices[renderIndex].rdpTileIndex + (oneCycleBug ? tileIndex0 : tileIndex1);
         RDPTile rdpTile = RDPTiles[globalTileIndex];
         if (!renderFlagDynamicTiles(rp.flags)) {
             rdpTile.cms = oneCycleBug ? renderCMS0(rp.flags) : renderCMS1(rp.flags);
@@ -234,7 +232,7 @@ void RasterPS(const RenderParams rp, bool outputDepth, float4 vertexPosition, fl
     }
     
     // Add highlight color to the last step.
-    uint highlightColorUint = instanceRenderIndices[gConstants.renderIndex].highlightColor;
+    uint highlightColorUint = instanceRenderIndices[renderIndex].highlightColor;
     if (highlightColorUint > 0) {
         float4 highlightColor = RGBA32ToFloat4(highlightColorUint);
         resultColor = lerp(resultColor, highlightColor, highlightColor.a);
@@ -245,11 +243,17 @@ void RasterPS(const RenderParams rp, bool outputDepth, float4 vertexPosition, fl
         resultColor.rgb = lerp(resultColor.rgb, float3(1.0f, 0.0f, 0.0f), 0.5f);
     }
 #endif
+
+    // The destination is overwritten when not using alpha blending, so the post blend noise can be added directly to the output.
+    // Calls that use alpha blending draw the noise in separate passes instead.
+    if ((instanceRenderIndices[renderIndex].postBlendDitherNoise != 0) && !alphaBlend) {
+        resultColor.rgb = ApplyPostBlendDitherNoise(resultColor.rgb, vertexPosition.xy, renderIndex, usesHDR);
+    }
 }
 
 #if defined(DYNAMIC_RENDER_PARAMS)
-RenderParams getRenderParams() {
-    uint instanceIndex = instanceRenderIndices[gConstants.renderIndex].instanceIndex;
+RenderParams getRenderParams(uint renderIndex) {
+    uint instanceIndex = instanceRenderIndices[renderIndex].instanceIndex;
     return DynamicRenderParams[instanceIndex];
 }
 #elif defined(SPEC_CONSTANT_RENDER_PARAMS)
@@ -264,6 +268,7 @@ void PSMain(
 #if defined(DYNAMIC_RENDER_PARAMS) || defined(VERTEX_FLAT_COLOR)
     , nointerpolation in float4 vertexFlatColor : COLOR1
 #endif
+    , nointerpolation in uint renderIndex : RENDERINDEX
 #if defined(MULTISAMPLING)
     , in uint sampleIndex : SV_SampleIndex
 #endif
@@ -290,6 +295,6 @@ void PSMain(
 #else
     const bool outputDepth = false;
 #endif
-    RasterPS(getRenderParams(), outputDepth, vertexPosition, vertexUV, vertexSmoothColor, vertexFlatColor, sampleIndex, resultColor, resultAlpha, resultDepth);
+    RasterPS(getRenderParams(renderIndex), renderIndex, outputDepth, vertexPosition, vertexUV, vertexSmoothColor, vertexFlatColor, sampleIndex, resultColor, resultAlpha, resultDepth);
 }
 #endif
\ No newline at end of file
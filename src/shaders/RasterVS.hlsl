@@ -28,8 +28,8 @@ void RasterVS(const RenderParams rp, in float4 iPosition, in float2 iUV, in floa
 }
 
 #if defined(DYNAMIC_RENDER_PARAMS)
-RenderParams getRenderParams() {
-    uint instanceIndex = instanceRenderIndices[gConstants.renderIndex].instanceIndex;
+RenderParams getRenderParams(uint renderIndex) {
+    uint instanceIndex = instanceRenderIndices[renderIndex].instanceIndex;
     return DynamicRenderParams[instanceIndex];
 }
 #elif defined(SPEC_CONSTANT_RENDER_PARAMS)
@@ -41,17 +41,20 @@ void VSMain(
     in float4 iPosition : POSITION
     , in float2 iUV : TEXCOORD
     , in float4 iColor : COLOR
+    , in uint iRenderIndex : RENDERINDEX
     , out float4 oPosition : SV_POSITION
     , out float2 oUV : TEXCOORD
     , out float4 oSmoothColor : COLOR0
 #if defined(DYNAMIC_RENDER_PARAMS) || defined(VERTEX_FLAT_COLOR)
     , out float4 oFlatColor : COLOR1
 #endif
+    , nointerpolation out uint oRenderIndex : RENDERINDEX
 )
 {
 #if !defined(DYNAMIC_RENDER_PARAMS) && !defined(VERTEX_FLAT_COLOR)
     float4 oFlatColor;
 #endif
-    RasterVS(getRenderParams(), iPosition, iUV, iColor, oPosition, oUV, oSmoothColor, oFlatColor);
+    oRenderIndex = iRenderIndex;
+    RasterVS(getRenderParams(iRenderIndex), iPosition, iUV, iColor, oPosition, oUV, oSmoothColor, oFlatColor);
 }
 #endif
\ No newline at end of file
@@ -6,7 +6,7 @@
 [[vk::constant_id(3)]] const uint rpColorCombinerH = 0;
 [[vk::constant_id(4)]] const uint rpFlagsValue = 0;
 
-RenderParams getRenderParams() {
+RenderParams getRenderParams(uint renderIndex) {
     RenderParams rp;
     rp.omL = rpOtherModeL;
     rp.omH = rpOtherModeH;
@@ -93,7 +93,11 @@ float4 clampWrapMirrorSample(const RDPTile rdpTile, const GPUTile gpuTile, int2
     }
     // Sample the color version directly.
     else {
-        float4 textureColor = gTextures[NonUniformResourceIndex(textureIndex)].Load(int3(texelInt, 0));
+        // Tile copies are stored in a rect of an atlas. Texels outside of the rect must not be loaded from the neighboring rects.
+        float4 textureColor = float4(0.0f, 0.0f, 0.0f, 0.0f);
+        if (all(uint2(texelInt) < gpuTile.texelLimit)) {
+            textureColor = gTextures[NonUniformResourceIndex(textureIndex)].Load(int3(texelInt + gpuTile.texelOffset, 0));
+        }
         
         // Alpha channel in framebuffer textures represent the coverage. A modulo operation must be performed
         // to get the value that would correspond to the alpha channel when it's sampled.
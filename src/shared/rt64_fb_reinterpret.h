@@ -9,17 +9,25 @@
 #ifdef HLSL_CPU
 namespace interop {
 #endif
-    struct FbReinterpretCB {
+    struct FbReinterpretRegion {
         uint2 resolution;
+        uint2 inputOffset;
+        uint2 inputSize;
+        uint2 outputOffset;
+        uint2 ditherOffset;
         float sampleScale;
+        uint ditherPattern;
+        uint ditherRandomSeed;
+        uint padding;
+    };
+
+    struct FbReinterpretCB {
+        uint regionStart;
         uint srcSiz;
         uint srcFmt;
         uint dstSiz;
         uint dstFmt;
         uint tlutFormat;
-        uint ditherPattern;
-        uint ditherRandomSeed;
-        uint2 ditherOffset;
         uint usesHDR;
     };
 #ifdef HLSL_CPU
@@ -40,6 +40,8 @@ namespace interop {
         float2 tcScale;
         uint2 texelShift;
         uint2 texelMask;
+        uint2 texelOffset;
+        uint2 texelLimit;
         uint textureIndex;
         GPUTileFlags flags;
     };
@@ -10,7 +10,6 @@
 namespace interop {
 #endif
     struct RasterParams {
-        uint renderIndex;
         float2 halfPixelOffset;
     };
 #ifdef HLSL_CPU
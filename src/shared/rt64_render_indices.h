@@ -15,6 +15,7 @@ namespace interop {
         uint rdpTileIndex;
         uint rdpTileCount;
         uint highlightColor;
+        uint postBlendDitherNoise;
     };
 #ifdef HLSL_CPU
 };
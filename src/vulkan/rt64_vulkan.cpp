@@ -235,6 +235,22 @@ namespace RT64 {
         }
     }
 
+    static VkPresentModeKHR toVk(RenderPresentMode presentMode) {
+        switch (presentMode) {
+        case RenderPresentMode::FIFO:
+            return VK_PRESENT_MODE_FIFO_KHR;
+        case RenderPresentMode::FIFO_RELAXED:
+            return VK_PRESENT_MODE_FIFO_RELAXED_KHR;
+        case RenderPresentMode::MAILBOX:
+            return VK_PRESENT_MODE_MAILBOX_KHR;
+        case RenderPresentMode::IMMEDIATE:
+            return VK_PRESENT_MODE_IMMEDIATE_KHR;
+        default:
+            assert(false && "Unknown present mode.");
+            return VK_PRESENT_MODE_MAX_ENUM_KHR;
+        }
+    }
+
     static VkVertexInputRate toVk(RenderInputSlotClassification classification) {
         switch (classification) {
         case RenderInputSlotClassification::PER_VERTEX_DATA:
@@ -677,6 +693,7 @@ namespace RT64 {
         bufferInfo.usage |= (desc.flags & RenderBufferFlag::ACCELERATION_STRUCTURE_SCRATCH) ? VK_BUFFER_USAGE_STORAGE_BUFFER_BIT : 0;
         bufferInfo.usage |= (desc.flags & RenderBufferFlag::ACCELERATION_STRUCTURE_INPUT) ? VK_BUFFER_USAGE_ACCELERATION_STRUCTURE_BUILD_INPUT_READ_ONLY_BIT_KHR : 0;
         bufferInfo.usage |= (desc.flags & RenderBufferFlag::SHADER_BINDING_TABLE) ? VK_BUFFER_USAGE_SHADER_BINDING_TABLE_BIT_KHR : 0;
+        bufferInfo.usage |= (desc.flags & RenderBufferFlag::INDIRECT) ? VK_BUFFER_USAGE_INDIRECT_BUFFER_BIT : 0;
 
         const uint32_t deviceAddressMask = RenderBufferFlag::ACCELERATION_STRUCTURE | RenderBufferFlag::ACCELERATION_STRUCTURE_SCRATCH | RenderBufferFlag::ACCELERATION_STRUCTURE_INPUT | RenderBufferFlag::SHADER_BINDING_TABLE;
         bufferInfo.usage |= (desc.flags & deviceAddressMask) ? VK_BUFFER_USAGE_SHADER_DEVICE_ADDRESS_BIT : 0;
@@ -1032,6 +1049,122 @@ namespace RT64 {
         }
     }
 
+    // VulkanDescriptorSetAllocator
+
+    VulkanDescriptorSetAllocator::VulkanDescriptorSetAllocator(VulkanDevice *device) {
+        assert(device != nullptr);
+
+        this->device = device;
+    }
+
+    VulkanDescriptorSetAllocator::~VulkanDescriptorSetAllocator() {
+        release();
+    }
+
+    VulkanDescriptorSetAllocator::LayoutPools *VulkanDescriptorSetAllocator::getLayoutPools(const RenderDescriptorSetDesc &desc) {
+        assert(!desc.lastRangeIsBoundless);
+
+        // The signature of the layout is made out of every range and the immutable samplers they use.
+        thread_local std::vector<uint64_t> signature;
+        signature.clear();
+        for (uint32_t i = 0; i < desc.descriptorRangesCount; i++) {
+            const RenderDescriptorRange &range = desc.descriptorRanges[i];
+            signature.emplace_back(uint64_t(range.type));
+            signature.emplace_back(uint64_t(range.count));
+            signature.emplace_back(uint64_t(range.binding));
+            if (range.immutableSampler != nullptr) {
+                for (uint32_t j = 0; j < range.count; j++) {
+                    const VulkanSampler *interfaceSampler = static_cast<const VulkanSampler *>(range.immutableSampler[j]);
+                    signature.emplace_back(uint64_t(interfaceSampler->vk));
+                }
+            }
+            else {
+                signature.emplace_back(0);
+            }
+        }
+
+        const std::scoped_lock lock(allocatorMutex);
+        std::unique_ptr<LayoutPools> &layoutPools = layoutPoolsMap[signature];
+        if (layoutPools == nullptr) {
+            layoutPools = std::make_unique<LayoutPools>();
+            layoutPools->setLayout = std::make_unique<VulkanDescriptorSetLayout>(device, desc);
+            for (uint32_t i = 0; i < desc.descriptorRangesCount; i++) {
+                const RenderDescriptorRange &range = desc.descriptorRanges[i];
+                layoutPools->setTypeCounts[toVk(range.type)] += range.count;
+            }
+        }
+
+        return layoutPools.get();
+    }
+
+    VkDescriptorSet VulkanDescriptorSetAllocator::allocate(LayoutPools *layoutPools) {
+        assert(layoutPools != nullptr);
+
+        const std::scoped_lock lock(allocatorMutex);
+        if (!layoutPools->freeSets.empty()) {
+            VkDescriptorSet descriptorSet = layoutPools->freeSets.back();
+            layoutPools->freeSets.pop_back();
+            liveSetCount++;
+            return descriptorSet;
+        }
+
+        if (layoutPools->pools.empty() || (layoutPools->lastPoolSetCount >= SetsPerPool)) {
+            thread_local std::unordered_map<VkDescriptorType, uint32_t> poolTypeCounts;
+            poolTypeCounts.clear();
+            for (auto it : layoutPools->setTypeCounts) {
+                poolTypeCounts[it.first] = it.second * SetsPerPool;
+            }
+
+            VkDescriptorPool descriptorPool = VulkanDescriptorSet::createDescriptorPool(device, poolTypeCounts, SetsPerPool);
+            if (descriptorPool == VK_NULL_HANDLE) {
+                return VK_NULL_HANDLE;
+            }
+
+            layoutPools->pools.emplace_back(descriptorPool);
+            layoutPools->lastPoolSetCount = 0;
+            livePoolCount++;
+        }
+
+        VkDescriptorSetAllocateInfo allocateInfo = {};
+        allocateInfo.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_ALLOCATE_INFO;
+        allocateInfo.descriptorPool = layoutPools->pools.back();
+        allocateInfo.pSetLayouts = &layoutPools->setLayout->vk;
+        allocateInfo.descriptorSetCount = 1;
+
+        VkDescriptorSet descriptorSet = VK_NULL_HANDLE;
+        VkResult res = vkAllocateDescriptorSets(device->vk, &allocateInfo, &descriptorSet);
+        if (res != VK_SUCCESS) {
+            fprintf(stderr, "vkAllocateDescriptorSets failed with error code 0x%X.\n", res);
+            return VK_NULL_HANDLE;
+        }
+
+        layoutPools->lastPoolSetCount++;
+        liveSetCount++;
+        return descriptorSet;
+    }
+
+    void VulkanDescriptorSetAllocator::free(LayoutPools *layoutPools, VkDescriptorSet descriptorSet) {
+        assert(layoutPools != nullptr);
+        assert(descriptorSet != VK_NULL_HANDLE);
+
+        const std::scoped_lock lock(allocatorMutex);
+        layoutPools->freeSets.emplace_back(descriptorSet);
+        liveSetCount--;
+    }
+
+    void VulkanDescriptorSetAllocator::release() {
+        assert((liveSetCount == 0) && "All descriptor sets must be destroyed before the allocator.");
+
+        for (auto &it : layoutPoolsMap) {
+            for (VkDescriptorPool descriptorPool : it.second->pools) {
+                vkDestroyDescriptorPool(device->vk, descriptorPool, nullptr);
+            }
+        }
+
+        layoutPoolsMap.clear();
+        livePoolCount = 0;
+    }
+
     // VulkanPipelineLayout
 
     VulkanPipelineLayout::VulkanPipelineLayout(VulkanDevice *device, const RenderPipelineLayoutDesc &desc) {
@@ -1196,7 +1329,7 @@ namespace RT64 {
         pipelineInfo.layout = pipelineLayout->vk;
         pipelineInfo.stage = stageInfo;
 
-        VkResult res = vkCreateComputePipelines(device->vk, VK_NULL_HANDLE, 1, &pipelineInfo, nullptr, &vk);
+        VkResult res = vkCreateComputePipelines(device->vk, device->pipelineCache, 1, &pipelineInfo, nullptr, &vk);
         if (res != VK_SUCCESS) {
             fprintf(stderr, "vkCreateComputePipelines failed with error code 0x%X.\n", res);
             return;
@@ -1413,7 +1546,7 @@ namespace RT64 {
         pipelineInfo.layout = pipelineLayout->vk;
         pipelineInfo.renderPass = renderPass;
 
-        VkResult res = vkCreateGraphicsPipelines(device->vk, VK_NULL_HANDLE, 1, &pipelineInfo, nullptr, &vk);
+        VkResult res = vkCreateGraphicsPipelines(device->vk, device->pipelineCache, 1, &pipelineInfo, nullptr, &vk);
         if (res != VK_SUCCESS) {
             fprintf(stderr, "vkCreateGraphicsPipelines failed with error code 0x%X.\n", res);
             return;
@@ -1615,7 +1748,7 @@ namespace RT64 {
 
         this->descriptorSetCount = uint32_t(pipelineLayout->descriptorSetLayouts.size());
 
-        VkResult res = vkCreateRayTracingPipelinesKHR(device->vk, nullptr, nullptr, 1, &pipelineInfo, nullptr, &vk);
+        VkResult res = vkCreateRayTracingPipelinesKHR(device->vk, nullptr, device->pipelineCache, 1, &pipelineInfo, nullptr, &vk);
         if (res != VK_SUCCESS) {
             fprintf(stderr, "vkCreateRayTracingPipelinesKHR failed with error code 0x%X.\n", res);
             return;
@@ -1643,6 +1776,14 @@ namespace RT64 {
 
         this->device = device;
 
+        // Sets with a boundless range are allocated with a variable amount of descriptors, so they use a dedicated pool instead.
+        if (!desc.lastRangeIsBoundless) {
+            layoutPools = device->descriptorSetAllocator->getLayoutPools(desc);
+            setLayout = layoutPools->setLayout.get();
+            vk = device->descriptorSetAllocator->allocate(layoutPools);
+            return;
+        }
+
         thread_local std::unordered_map<VkDescriptorType, uint32_t> typeCounts;
         typeCounts.clear();
         
@@ -1666,7 +1807,7 @@ namespace RT64 {
 
         setLayout = new VulkanDescriptorSetLayout(device, desc);
 
-        descriptorPool = createDescriptorPool(device, typeCounts);
+        descriptorPool = createDescriptorPool(device, typeCounts, 1);
         if (descriptorPool == VK_NULL_HANDLE) {
             return;
         }
@@ -1693,6 +1834,14 @@ namespace RT64 {
     }
 
     VulkanDescriptorSet::~VulkanDescriptorSet() {
+        if (layoutPools != nullptr) {
+            if (vk != VK_NULL_HANDLE) {
+                device->descriptorSetAllocator->free(layoutPools, vk);
+            }
+
+            return;
+        }
+
         if (descriptorPool != VK_NULL_HANDLE) {
             vkDestroyDescriptorPool(device->vk, descriptorPool, nullptr);
         }
@@ -1784,7 +1933,7 @@ namespace RT64 {
         vkUpdateDescriptorSets(device->vk, 1, &writeDescriptor, 0, nullptr);
     }
 
-    VkDescriptorPool VulkanDescriptorSet::createDescriptorPool(VulkanDevice *device, const std::unordered_map<VkDescriptorType, uint32_t> &typeCounts) {
+    VkDescriptorPool VulkanDescriptorSet::createDescriptorPool(VulkanDevice *device, const std::unordered_map<VkDescriptorType, uint32_t> &typeCounts, uint32_t maxSets) {
         thread_local std::vector<VkDescriptorPoolSize> poolSizes;
         poolSizes.clear();
 
@@ -1798,7 +1947,7 @@ namespace RT64 {
 
         VkDescriptorPoolCreateInfo poolInfo = {};
         poolInfo.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_POOL_CREATE_INFO;
-        poolInfo.maxSets = 1;
+        poolInfo.maxSets = maxSets;
         poolInfo.pPoolSizes = !poolSizes.empty() ? poolSizes.data() : nullptr;
         poolInfo.poolSizeCount = uint32_t(poolSizes.size());
 
@@ -1908,8 +2057,8 @@ namespace RT64 {
         uint32_t presentModeCount = 0;
         vkGetPhysicalDeviceSurfacePresentModesKHR(physicalDevice, surface, &presentModeCount, nullptr);
 
-        std::vector<VkPresentModeKHR> presentModes(presentModeCount);
-        vkGetPhysicalDeviceSurfacePresentModesKHR(physicalDevice, surface, &presentModeCount, presentModes.data());
+        supportedPresentModes.resize(presentModeCount);
+        vkGetPhysicalDeviceSurfacePresentModesKHR(physicalDevice, surface, &presentModeCount, supportedPresentModes.data());
 
         // Check if the format we requested is part of the supported surface formats.
         std::vector<VkSurfaceFormatKHR> compatibleSurfaceFormats;
@@ -1938,8 +2087,9 @@ namespace RT64 {
             pickedSurfaceFormat = compatibleSurfaceFormats[0];
         }
 
-        // FIFO is guaranteed to be supported.
+        // FIFO is guaranteed to be supported and is used until another mode is requested.
         pickedPresentMode = VK_PRESENT_MODE_FIFO_KHR;
+        presentMode = RenderPresentMode::FIFO;
 
         // Pick an alpha compositing mode, prefer opaque over inherit.
         if (surfaceCapabilities.supportedCompositeAlpha & VK_COMPOSITE_ALPHA_OPAQUE_BIT_KHR) {
@@ -1953,21 +2103,15 @@ namespace RT64 {
             return;
         }
 
-        // Create the semaphore that will be used whenever the next image is acquired.
+        // Create the spare semaphore that will be used whenever the next image is acquired. The semaphores of each image are created during the resize.
         VkSemaphoreCreateInfo semaphoreCreateInfo = {};
         semaphoreCreateInfo.sType = VK_STRUCTURE_TYPE_SEMAPHORE_CREATE_INFO;
-        res = vkCreateSemaphore(commandQueue->device->vk, &semaphoreCreateInfo, nullptr, &acquireNextTextureSemaphore);
+        res = vkCreateSemaphore(commandQueue->device->vk, &semaphoreCreateInfo, nullptr, &acquireSpareSemaphore);
         if (res != VK_SUCCESS) {
             fprintf(stderr, "vkCreateSemaphore failed with error code 0x%X.\n", res);
             return;
         }
 
-        res = vkCreateSemaphore(commandQueue->device->vk, &semaphoreCreateInfo, nullptr, &presentTransitionSemaphore);
-        if (res != VK_SUCCESS) {
-            fprintf(stderr, "vkCreateSemaphore failed with error code 0x%X.\n", res);
-            return;
-        }
-        
         VkFenceCreateInfo fenceCreateInfo = {};
         fenceCreateInfo.sType = VK_STRUCTURE_TYPE_FENCE_CREATE_INFO;
         res = vkCreateFence(commandQueue->device->vk, &fenceCreateInfo, nullptr, &acquireNextTextureFence);
@@ -1987,16 +2131,20 @@ namespace RT64 {
         releaseImageViews();
         releaseSwapChain();
 
-        if (acquireNextTextureSemaphore != VK_NULL_HANDLE) {
-            vkDestroySemaphore(commandQueue->device->vk, acquireNextTextureSemaphore, nullptr);
+        if (acquireSpareSemaphore != VK_NULL_HANDLE) {
+            vkDestroySemaphore(commandQueue->device->vk, acquireSpareSemaphore, nullptr);
         }
 
-        if (acquireNextTextureFence != VK_NULL_HANDLE) {
-            vkDestroyFence(commandQueue->device->vk, acquireNextTextureFence, nullptr);
+        for (VkSemaphore semaphore : acquireSemaphores) {
+            vkDestroySemaphore(commandQueue->device->vk, semaphore, nullptr);
+        }
+
+        for (VkSemaphore semaphore : presentSemaphores) {
+            vkDestroySemaphore(commandQueue->device->vk, semaphore, nullptr);
         }
 
-        if (presentTransitionSemaphore != VK_NULL_HANDLE) {
-            vkDestroySemaphore(commandQueue->device->vk, presentTransitionSemaphore, nullptr);
+        if (acquireNextTextureFence != VK_NULL_HANDLE) {
+            vkDestroyFence(commandQueue->device->vk, acquireNextTextureFence, nullptr);
         }
 
         if (surface != VK_NULL_HANDLE) {
@@ -2015,12 +2163,22 @@ namespace RT64 {
         presentInfo.swapchainCount = 1;
         presentInfo.pImageIndices = &textureIndex;
 
+        // If nothing used the acquired image, the present waits on the acquisition semaphore instead so it's unsignaled by the time the
+        // image is acquired again. This avoids having to submit an empty batch and wait for it on the CPU.
+        VkSemaphore waitSemaphores[2];
         if (presentTransitionSemaphoreSignaled) {
-            presentInfo.pWaitSemaphores = &presentTransitionSemaphore;
-            presentInfo.waitSemaphoreCount = 1;
+            waitSemaphores[presentInfo.waitSemaphoreCount++] = presentSemaphores[textureIndex];
             presentTransitionSemaphoreSignaled = false;
         }
-        
+
+        if (acquireNextTextureSemaphoreSignaled) {
+            waitSemaphores[presentInfo.waitSemaphoreCount++] = acquireNextTextureSemaphore;
+            acquireNextTextureSemaphoreSignaled = false;
+        }
+
+        presentInfo.pWaitSemaphores = waitSemaphores;
+
+
         VkResult res;
         {
             const std::scoped_lock queueLock(*commandQueue->queue->mutex);
@@ -2049,7 +2207,7 @@ namespace RT64 {
         }
         
         // Make sure to wait on any image acquisition semaphores before destroying the swap chain.
-        checkAcquireNextTextureSemaphore();
+        flushAcquireNextTextureSemaphore();
 
         // Destroy any image view references to the current swap chain.
         releaseImageViews();
@@ -2097,6 +2255,13 @@ namespace RT64 {
 
         textureCount = retrievedImageCount;
 
+        // Every image gets its own semaphores, as a semaphore can only be signaled again once it's known the image it was used with
+        // has been acquired again. The flush at the start of the resize guarantees the existing ones are unsignaled and can be reused.
+        if (!createSemaphores(acquireSemaphores, textureCount) || !createSemaphores(presentSemaphores, textureCount)) {
+            releaseSwapChain();
+            return false;
+        }
+
         std::vector<VkImage> images(textureCount);
         res = vkGetSwapchainImagesKHR(commandQueue->device->vk, vk, &textureCount, images.data());
         if (res != VK_SUCCESS) {
@@ -2135,7 +2300,7 @@ namespace RT64 {
     bool VulkanSwapChain::needsResize() const {
         uint32_t windowWidth, windowHeight;
         getWindowSize(windowWidth, windowHeight);
-        return (vk == VK_NULL_HANDLE) || (windowWidth != width) || (windowHeight != height);
+        return (vk == VK_NULL_HANDLE) || (windowWidth != width) || (windowHeight != height) || (createInfo.presentMode != pickedPresentMode);
     }
 
     uint32_t VulkanSwapChain::getWidth() const {
@@ -2166,6 +2331,26 @@ namespace RT64 {
         return (vk == VK_NULL_HANDLE) || (width == 0) || (height == 0);
     }
 
+    bool VulkanSwapChain::isPresentModeSupported(RenderPresentMode presentMode) const {
+        const VkPresentModeKHR vkPresentMode = toVk(presentMode);
+        return std::find(supportedPresentModes.begin(), supportedPresentModes.end(), vkPresentMode) != supportedPresentModes.end();
+    }
+
+    bool VulkanSwapChain::setPresentMode(RenderPresentMode presentMode) {
+        if (!isPresentModeSupported(presentMode)) {
+            return false;
+        }
+
+        // The swap chain will be recreated with the new mode on the next resize.
+        this->presentMode = presentMode;
+        pickedPresentMode = toVk(presentMode);
+        return true;
+    }
+
+    RenderPresentMode VulkanSwapChain::getPresentMode() const {
+        return presentMode;
+    }
+
     uint32_t VulkanSwapChain::getRefreshRate() const {
         VkRefreshCycleDurationGOOGLE refreshCycle = {};
         VkResult res = vkGetRefreshCycleDurationGOOGLE(commandQueue->device->vk, vk, &refreshCycle);
@@ -2195,32 +2380,56 @@ namespace RT64 {
 #   endif
     }
 
-    void VulkanSwapChain::checkAcquireNextTextureSemaphore() {
-        // We've ended up in a situation where the semaphore must be unsignaled because nothing used the acquired image in-between, so we force a command queue submission.
+    void VulkanSwapChain::flushAcquireNextTextureSemaphore() {
+        // The swap chain is about to be destroyed, so the acquired image will never be presented. Force a command queue submission that waits on its semaphore
+        // if nothing used it. The fence also guarantees every wait submitted before on the semaphores of the images has finished, so they can be reused.
+        const std::scoped_lock queueLock(*commandQueue->queue->mutex);
+        const VkPipelineStageFlags waitStages = VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT;
+        VkSubmitInfo submitInfo = {};
+        submitInfo.sType = VK_STRUCTURE_TYPE_SUBMIT_INFO;
         if (acquireNextTextureSemaphoreSignaled) {
-            const std::scoped_lock queueLock(*commandQueue->queue->mutex);
-            const VkPipelineStageFlags waitStages = VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT;
-            VkSubmitInfo submitInfo = {};
-            submitInfo.sType = VK_STRUCTURE_TYPE_SUBMIT_INFO;
             submitInfo.pWaitSemaphores = &acquireNextTextureSemaphore;
             submitInfo.pWaitDstStageMask = &waitStages;
             submitInfo.waitSemaphoreCount = 1;
-            vkQueueSubmit(commandQueue->queue->vk, 1, &submitInfo, acquireNextTextureFence);
-            vkWaitForFences(commandQueue->device->vk, 1, &acquireNextTextureFence, VK_TRUE, UINT64_MAX);
-            vkResetFences(commandQueue->device->vk, 1, &acquireNextTextureFence);
             acquireNextTextureSemaphoreSignaled = false;
         }
+
+        vkQueueSubmit(commandQueue->queue->vk, 1, &submitInfo, acquireNextTextureFence);
+        vkWaitForFences(commandQueue->device->vk, 1, &acquireNextTextureFence, VK_TRUE, UINT64_MAX);
+        vkResetFences(commandQueue->device->vk, 1, &acquireNextTextureFence);
+    }
+
+    bool VulkanSwapChain::createSemaphores(std::vector<VkSemaphore> &semaphores, uint32_t count) {
+        VkSemaphoreCreateInfo semaphoreCreateInfo = {};
+        semaphoreCreateInfo.sType = VK_STRUCTURE_TYPE_SEMAPHORE_CREATE_INFO;
+        while (semaphores.size() < count) {
+            VkSemaphore semaphore = VK_NULL_HANDLE;
+            VkResult res = vkCreateSemaphore(commandQueue->device->vk, &semaphoreCreateInfo, nullptr, &semaphore);
+            if (res != VK_SUCCESS) {
+                fprintf(stderr, "vkCreateSemaphore failed with error code 0x%X.\n", res);
+                return false;
+            }
+
+            semaphores.emplace_back(semaphore);
+        }
+
+        return true;
     }
 
     bool VulkanSwapChain::acquireNextTexture() {
-        checkAcquireNextTextureSemaphore();
+        assert(!acquireNextTextureSemaphoreSignaled);
+
+        // The image index isn't known until the image is acquired, so the spare semaphore is always used for the acquisition. It's then swapped with the semaphore
+        // that was last used for the same image, which is guaranteed to be unsignaled as the image could only be acquired again after it was presented.
+        VkResult res = vkAcquireNextImageKHR(commandQueue->device->vk, vk, UINT64_MAX, acquireSpareSemaphore, VK_NULL_HANDLE, &textureIndex);
 
         // Handle the error silently.
-        VkResult res = vkAcquireNextImageKHR(commandQueue->device->vk, vk, UINT64_MAX, acquireNextTextureSemaphore, VK_NULL_HANDLE, &textureIndex);
         if ((res != VK_SUCCESS) && (res != VK_SUBOPTIMAL_KHR)) {
             return false;
         }
 
+        std::swap(acquireSpareSemaphore, acquireSemaphores[textureIndex]);
+        acquireNextTextureSemaphore = acquireSemaphores[textureIndex];
         acquireNextTextureSemaphoreSignaled = true;
         return true;
     }
@@ -2576,6 +2785,26 @@ namespace RT64 {
         vkCmdDrawIndexed(vk, indexCountPerInstance, instanceCount, startIndexLocation, baseVertexLocation, startInstanceLocation);
     }
 
+    void VulkanCommandList::drawInstancedIndirect(RenderBufferReference argumentBuffer, uint32_t drawCount) {
+        assert(argumentBuffer.ref != nullptr);
+        assert((drawCount <= 1) || device->capabilities.multiDrawIndirect);
+
+        const VulkanBuffer *interfaceBuffer = static_cast<const VulkanBuffer *>(argumentBuffer.ref);
+        checkActiveRenderPass();
+
+        vkCmdDrawIndirect(vk, interfaceBuffer->vk, argumentBuffer.offset, drawCount, sizeof(RenderDrawIndirectArguments));
+    }
+
+    void VulkanCommandList::drawIndexedInstancedIndirect(RenderBufferReference argumentBuffer, uint32_t drawCount) {
+        assert(argumentBuffer.ref != nullptr);
+        assert((drawCount <= 1) || device->capabilities.multiDrawIndirect);
+
+        const VulkanBuffer *interfaceBuffer = static_cast<const VulkanBuffer *>(argumentBuffer.ref);
+        checkActiveRenderPass();
+
+        vkCmdDrawIndexedIndirect(vk, interfaceBuffer->vk, argumentBuffer.offset, drawCount, sizeof(RenderDrawIndexedIndirectArguments));
+    }
+
     void VulkanCommandList::setPipeline(const RenderPipeline *pipeline) {
         assert(pipeline != nullptr);
 
@@ -3132,9 +3361,30 @@ namespace RT64 {
 
         familyIndex = device->queueFamilyIndices[toFamilyIndex(commandListType)];
         device->queueFamilies[familyIndex].add(this);
+
+        if (device->capabilities.queueTimelines) {
+            VkSemaphoreTypeCreateInfo semaphoreTypeInfo = {};
+            semaphoreTypeInfo.sType = VK_STRUCTURE_TYPE_SEMAPHORE_TYPE_CREATE_INFO;
+            semaphoreTypeInfo.semaphoreType = VK_SEMAPHORE_TYPE_TIMELINE;
+            semaphoreTypeInfo.initialValue = 0;
+
+            VkSemaphoreCreateInfo semaphoreInfo = {};
+            semaphoreInfo.sType = VK_STRUCTURE_TYPE_SEMAPHORE_CREATE_INFO;
+            semaphoreInfo.pNext = &semaphoreTypeInfo;
+
+            VkResult res = vkCreateSemaphore(device->vk, &semaphoreInfo, nullptr, &timelineSemaphore);
+            if (res != VK_SUCCESS) {
+                fprintf(stderr, "vkCreateSemaphore failed with error code 0x%X.\n", res);
+                return;
+            }
+        }
     }
 
     VulkanCommandQueue::~VulkanCommandQueue() {
+        if (timelineSemaphore != VK_NULL_HANDLE) {
+            vkDestroySemaphore(device->vk, timelineSemaphore, nullptr);
+        }
+
         device->queueFamilies[familyIndex].remove(this);
     }
 
@@ -3146,12 +3396,18 @@ namespace RT64 {
         assert(commandLists != nullptr);
         assert(commandListCount > 0);
 
-        thread_local std::vector<VkSemaphore> swapChainWaitSemaphores;
-        thread_local std::vector<VkSemaphore> presentWaitSemaphores;
+        thread_local std::vector<VkSemaphore> waitSemaphores;
+        thread_local std::vector<VkSemaphore> signalSemaphores;
         thread_local std::vector<VkCommandBuffer> commandBuffers;
-        swapChainWaitSemaphores.clear();
-        presentWaitSemaphores.clear();
+        thread_local std::vector<VkPipelineStageFlags> waitStages;
+        thread_local std::vector<uint64_t> waitValues;
+        thread_local std::vector<uint64_t> signalValues;
+        waitSemaphores.clear();
+        signalSemaphores.clear();
         commandBuffers.clear();
+        waitStages.clear();
+        waitValues.clear();
+        signalValues.clear();
         for (uint32_t i = 0; i < commandListCount; i++) {
             assert(commandLists[i] != nullptr);
 
@@ -3164,7 +3420,7 @@ namespace RT64 {
                     if (&swapChain->textures[swapChain->textureIndex] == texture) {
                         assert(swapChain->acquireNextTextureSemaphoreSignaled);
                         swapChain->acquireNextTextureSemaphoreSignaled = false;
-                        swapChainWaitSemaphores.emplace_back(swapChain->acquireNextTextureSemaphore);
+                        waitSemaphores.emplace_back(swapChain->acquireNextTextureSemaphore);
                         break;
                     }
                 }
@@ -3176,28 +3432,57 @@ namespace RT64 {
                     if (&swapChain->textures[swapChain->textureIndex] == texture) {
                         assert(!swapChain->presentTransitionSemaphoreSignaled);
                         swapChain->presentTransitionSemaphoreSignaled = true;
-                        presentWaitSemaphores.emplace_back(swapChain->presentTransitionSemaphore);
+                        signalSemaphores.emplace_back(swapChain->presentSemaphores[swapChain->textureIndex]);
                         break;
                     }
                 }
             }
         }
 
+        // Binary semaphores ignore the values, but the value arrays must still match the semaphore arrays if any timeline semaphore is used.
+        waitStages.resize(waitSemaphores.size(), VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT);
+        waitValues.resize(waitSemaphores.size(), 0);
+        signalValues.resize(signalSemaphores.size(), 0);
+
+        // Wait on the timelines of other queues on the GPU if requested.
+        for (size_t i = 0; i < timelineWaitSemaphores.size(); i++) {
+            waitSemaphores.emplace_back(timelineWaitSemaphores[i]);
+            waitStages.emplace_back(VK_PIPELINE_STAGE_ALL_COMMANDS_BIT);
+            waitValues.emplace_back(timelineWaitValues[i]);
+        }
+
+        timelineWaitSemaphores.clear();
+        timelineWaitValues.clear();
+
+        if (timelineSemaphore != VK_NULL_HANDLE) {
+            signalSemaphores.emplace_back(timelineSemaphore);
+            signalValues.emplace_back(++timelineValue);
+        }
+
         VkSubmitInfo submitInfo = {};
         submitInfo.sType = VK_STRUCTURE_TYPE_SUBMIT_INFO;
         submitInfo.pCommandBuffers = commandBuffers.data();
         submitInfo.commandBufferCount = uint32_t(commandBuffers.size());
 
-        const VkPipelineStageFlags waitStages = VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT;
-        if (!swapChainWaitSemaphores.empty()) {
-            submitInfo.pWaitSemaphores = swapChainWaitSemaphores.data();
-            submitInfo.waitSemaphoreCount = uint32_t(swapChainWaitSemaphores.size());
-            submitInfo.pWaitDstStageMask = &waitStages;
+        if (!waitSemaphores.empty()) {
+            submitInfo.pWaitSemaphores = waitSemaphores.data();
+            submitInfo.waitSemaphoreCount = uint32_t(waitSemaphores.size());
+            submitInfo.pWaitDstStageMask = waitStages.data();
         }
 
-        if (!presentWaitSemaphores.empty()) {
-            submitInfo.pSignalSemaphores = presentWaitSemaphores.data();
-            submitInfo.signalSemaphoreCount = uint32_t(presentWaitSemaphores.size());
+        if (!signalSemaphores.empty()) {
+            submitInfo.pSignalSemaphores = signalSemaphores.data();
+            submitInfo.signalSemaphoreCount = uint32_t(signalSemaphores.size());
+        }
+
+        VkTimelineSemaphoreSubmitInfo timelineSubmitInfo = {};
+        if (timelineSemaphore != VK_NULL_HANDLE) {
+            timelineSubmitInfo.sType = VK_STRUCTURE_TYPE_TIMELINE_SEMAPHORE_SUBMIT_INFO;
+            timelineSubmitInfo.pWaitSemaphoreValues = waitValues.data();
+            timelineSubmitInfo.waitSemaphoreValueCount = uint32_t(waitValues.size());
+            timelineSubmitInfo.pSignalSemaphoreValues = signalValues.data();
+            timelineSubmitInfo.signalSemaphoreValueCount = uint32_t(signalValues.size());
+            submitInfo.pNext = &timelineSubmitInfo;
         }
 
         VkFence submitFence = VK_NULL_HANDLE;
@@ -3231,6 +3516,22 @@ namespace RT64 {
         vkResetFences(device->vk, 1, &interfaceFence->vk);
     }
 
+    uint64_t VulkanCommandQueue::getTimelineValue() {
+        return timelineValue;
+    }
+
+    void VulkanCommandQueue::waitForCommandQueue(RenderCommandQueue *queue, uint64_t value) {
+        assert(queue != nullptr);
+        assert(timelineSemaphore != VK_NULL_HANDLE);
+
+        // The wait is deferred until the next submission, as Vulkan can only wait on semaphores as part of one.
+        VulkanCommandQueue *interfaceQueue = static_cast<VulkanCommandQueue *>(queue);
+        if ((interfaceQueue != this) && (value > 0)) {
+            timelineWaitSemaphores.emplace_back(interfaceQueue->timelineSemaphore);
+            timelineWaitValues.emplace_back(value);
+        }
+    }
+
     // VulkanPool
 
     VulkanPool::VulkanPool(VulkanDevice *device, const RenderPoolDesc &desc) {
@@ -3417,6 +3718,11 @@ namespace RT64 {
         layoutFeatures.pNext = featuresChain;
         featuresChain = &layoutFeatures;
 
+        VkPhysicalDeviceTimelineSemaphoreFeatures timelineFeatures = {};
+        timelineFeatures.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_TIMELINE_SEMAPHORE_FEATURES;
+        timelineFeatures.pNext = featuresChain;
+        featuresChain = &timelineFeatures;
+
         VkPhysicalDevicePresentIdFeaturesKHR presentIdFeatures = {};
         VkPhysicalDevicePresentWaitFeaturesKHR presentWaitFeatures = {};
         const bool presentWaitSupported = supportedOptionalExtensions.find(VK_KHR_PRESENT_ID_EXTENSION_NAME) != supportedOptionalExtensions.end() && supportedOptionalExtensions.find(VK_KHR_PRESENT_WAIT_EXTENSION_NAME) != supportedOptionalExtensions.end();
@@ -3486,6 +3792,12 @@ namespace RT64 {
             createDeviceChain = &layoutFeatures;
         }
 
+        const bool timelineSemaphore = timelineFeatures.timelineSemaphore;
+        if (timelineSemaphore) {
+            timelineFeatures.pNext = createDeviceChain;
+            createDeviceChain = &timelineFeatures;
+        }
+
         const bool presentWait = presentIdFeatures.presentId && presentWaitFeatures.presentWait;
         if (presentWait) {
             presentIdFeatures.pNext = createDeviceChain;
@@ -3618,6 +3930,19 @@ namespace RT64 {
             return;
         }
 
+        descriptorSetAllocator = std::make_unique<VulkanDescriptorSetAllocator>(this);
+
+        // Pipeline creation is internally synchronized by the driver when using the cache, so it can be shared by all compilation threads.
+        VkPipelineCacheCreateInfo pipelineCacheInfo = {};
+        pipelineCacheInfo.sType = VK_STRUCTURE_TYPE_PIPELINE_CACHE_CREATE_INFO;
+
+        // The cache is only an optimization, so the device can still be used without it.
+        res = vkCreatePipelineCache(vk, &pipelineCacheInfo, nullptr, &pipelineCache);
+        if (res != VK_SUCCESS) {
+            fprintf(stderr, "vkCreatePipelineCache failed with error code 0x%X. Pipelines will be created without a cache.\n", res);
+            pipelineCache = VK_NULL_HANDLE;
+        }
+
         // Find the biggest device local memory available on the device.
         VkDeviceSize memoryHeapSize = 0;
         const VkPhysicalDeviceMemoryProperties *memoryProps = nullptr;
@@ -3635,6 +3960,8 @@ namespace RT64 {
         capabilities.descriptorIndexing = descriptorIndexing;
         capabilities.scalarBlockLayout = scalarBlockLayout;
         capabilities.presentWait = presentWait;
+        capabilities.queueTimelines = timelineSemaphore;
+        capabilities.multiDrawIndirect = deviceFeatures.features.multiDrawIndirect && deviceFeatures.features.drawIndirectFirstInstance;
         capabilities.displayTiming = supportedOptionalExtensions.find(VK_GOOGLE_DISPLAY_TIMING_EXTENSION_NAME) != supportedOptionalExtensions.end();
         capabilities.preferHDR = memoryHeapSize > (512 * 1024 * 1024);
 
@@ -3908,7 +4235,91 @@ namespace RT64 {
         }
     }
 
+    RenderDescriptorSetStats VulkanDevice::getDescriptorSetStats() const {
+        RenderDescriptorSetStats stats;
+        if (descriptorSetAllocator != nullptr) {
+            stats.poolCount = descriptorSetAllocator->livePoolCount;
+            stats.setCount = descriptorSetAllocator->liveSetCount;
+        }
+
+        return stats;
+    }
+
+    bool VulkanDevice::loadPipelineCache(const void *data, uint64_t size) {
+        assert(data != nullptr);
+
+        if (pipelineCache == VK_NULL_HANDLE) {
+            return false;
+        }
+
+        // Some drivers don't validate the data on their own, so the header is checked to match the device and driver first.
+        VkPipelineCacheHeaderVersionOne header = {};
+        if (size < sizeof(header)) {
+            return false;
+        }
+
+        memcpy(&header, data, sizeof(header));
+        const bool headerValid = (header.headerSize >= sizeof(header)) && (header.headerVersion == VK_PIPELINE_CACHE_HEADER_VERSION_ONE);
+        const bool deviceValid = (header.vendorID == physicalDeviceProperties.vendorID) && (header.deviceID == physicalDeviceProperties.deviceID);
+        const bool driverValid = (memcmp(header.pipelineCacheUUID, physicalDeviceProperties.pipelineCacheUUID, VK_UUID_SIZE) == 0);
+        if (!headerValid || !deviceValid || !driverValid) {
+            return false;
+        }
+
+        VkPipelineCacheCreateInfo loadedCacheInfo = {};
+        loadedCacheInfo.sType = VK_STRUCTURE_TYPE_PIPELINE_CACHE_CREATE_INFO;
+        loadedCacheInfo.pInitialData = data;
+        loadedCacheInfo.initialDataSize = size_t(size);
+
+        VkPipelineCache loadedCache = VK_NULL_HANDLE;
+        VkResult res = vkCreatePipelineCache(vk, &loadedCacheInfo, nullptr, &loadedCache);
+        if (res != VK_SUCCESS) {
+            fprintf(stderr, "vkCreatePipelineCache failed with error code 0x%X.\n", res);
+            return false;
+        }
+
+        res = vkMergePipelineCaches(vk, pipelineCache, 1, &loadedCache);
+        vkDestroyPipelineCache(vk, loadedCache, nullptr);
+
+        if (res != VK_SUCCESS) {
+            fprintf(stderr, "vkMergePipelineCaches failed with error code 0x%X.\n", res);
+            return false;
+        }
+
+        return true;
+    }
+
+    bool VulkanDevice::savePipelineCache(std::vector<uint8_t> &data) {
+        if (pipelineCache == VK_NULL_HANDLE) {
+            return false;
+        }
+
+        size_t dataSize = 0;
+        VkResult res = vkGetPipelineCacheData(vk, pipelineCache, &dataSize, nullptr);
+        if (res != VK_SUCCESS) {
+            fprintf(stderr, "vkGetPipelineCacheData failed with error code 0x%X.\n", res);
+            return false;
+        }
+
+        data.resize(dataSize);
+        res = vkGetPipelineCacheData(vk, pipelineCache, &dataSize, data.data());
+        if ((res != VK_SUCCESS) && (res != VK_INCOMPLETE)) {
+            fprintf(stderr, "vkGetPipelineCacheData failed with error code 0x%X.\n", res);
+            return false;
+        }
+
+        data.resize(dataSize);
+        return true;
+    }
+
     void VulkanDevice::release() {
+        descriptorSetAllocator.reset();
+
+        if (pipelineCache != VK_NULL_HANDLE) {
+            vkDestroyPipelineCache(vk, pipelineCache, nullptr);
+            pipelineCache = VK_NULL_HANDLE;
+        }
+
         if (allocator != VK_NULL_HANDLE) {
             vmaDestroyAllocator(allocator);
             allocator = VK_NULL_HANDLE;
@@ -6,6 +6,8 @@
 
 #include "rhi/rt64_render_interface.h"
 
+#include <atomic>
+#include <map>
 #include <mutex>
 #include <set>
 #include <unordered_map>
@@ -107,6 +109,33 @@ namespace RT64 {
         ~VulkanDescriptorSetLayout();
     };
 
+    // Descriptor sets with identical layouts share the layout and are allocated in bulk from the same pools. Sets are never
+    // freed back to the pools: they're kept in a free list instead and handed out again to the next set created with the layout.
+    struct VulkanDescriptorSetAllocator {
+        static const uint32_t SetsPerPool = 64;
+
+        struct LayoutPools {
+            std::unique_ptr<VulkanDescriptorSetLayout> setLayout;
+            std::unordered_map<VkDescriptorType, uint32_t> setTypeCounts;
+            std::vector<VkDescriptorPool> pools;
+            uint32_t lastPoolSetCount = 0;
+            std::vector<VkDescriptorSet> freeSets;
+        };
+
+        VulkanDevice *device = nullptr;
+        std::map<std::vector<uint64_t>, std::unique_ptr<LayoutPools>> layoutPoolsMap;
+        std::mutex allocatorMutex;
+        std::atomic<uint32_t> livePoolCount = 0;
+        std::atomic<uint32_t> liveSetCount = 0;
+
+        VulkanDescriptorSetAllocator(VulkanDevice *device);
+        ~VulkanDescriptorSetAllocator();
+        LayoutPools *getLayoutPools(const RenderDescriptorSetDesc &desc);
+        VkDescriptorSet allocate(LayoutPools *layoutPools);
+        void free(LayoutPools *layoutPools, VkDescriptorSet descriptorSet);
+        void release();
+    };
+
     struct VulkanPipelineLayout : RenderPipelineLayout {
         VkPipelineLayout vk = VK_NULL_HANDLE;
         std::vector<VkPushConstantRange> pushConstantRanges;
@@ -183,6 +212,7 @@ namespace RT64 {
     struct VulkanDescriptorSet : RenderDescriptorSet {
         VkDescriptorSet vk = VK_NULL_HANDLE;
         VulkanDescriptorSetLayout *setLayout = nullptr;
+        VulkanDescriptorSetAllocator::LayoutPools *layoutPools = nullptr;
         VkDescriptorPool descriptorPool = VK_NULL_HANDLE;
         VulkanDevice *device = nullptr;
 
@@ -192,7 +222,7 @@ namespace RT64 {
         void setTexture(uint32_t descriptorIndex, const RenderTexture *texture, RenderTextureLayout textureLayout, const RenderTextureView *textureView) override;
         void setAccelerationStructure(uint32_t descriptorIndex, const RenderAccelerationStructure *accelerationStructure) override;
         void setDescriptor(uint32_t descriptorIndex, const VkDescriptorBufferInfo *bufferInfo, const VkDescriptorImageInfo *imageInfo, const VkBufferView *texelBufferView, void *pNext);
-        static VkDescriptorPool createDescriptorPool(VulkanDevice *device, const std::unordered_map<VkDescriptorType, uint32_t> &typeCounts);
+        static VkDescriptorPool createDescriptorPool(VulkanDevice *device, const std::unordered_map<VkDescriptorType, uint32_t> &typeCounts, uint32_t maxSets);
     };
 
     struct VulkanSwapChain : RenderSwapChain {
@@ -210,9 +240,13 @@ namespace RT64 {
         VkSurfaceFormatKHR pickedSurfaceFormat = {};
         VkPresentModeKHR pickedPresentMode = VK_PRESENT_MODE_FIFO_KHR;
         VkCompositeAlphaFlagBitsKHR pickedAlphaFlag = VK_COMPOSITE_ALPHA_OPAQUE_BIT_KHR;
+        std::vector<VkPresentModeKHR> supportedPresentModes;
+        RenderPresentMode presentMode = RenderPresentMode::FIFO;
         VkSemaphore acquireNextTextureSemaphore = VK_NULL_HANDLE;
-        VkSemaphore presentTransitionSemaphore = VK_NULL_HANDLE;
+        VkSemaphore acquireSpareSemaphore = VK_NULL_HANDLE;
         VkFence acquireNextTextureFence = VK_NULL_HANDLE;
+        std::vector<VkSemaphore> acquireSemaphores;
+        std::vector<VkSemaphore> presentSemaphores;
         std::vector<VulkanTexture> textures;
         bool acquireNextTextureSemaphoreSignaled = false;
         bool presentTransitionSemaphoreSignaled = false;
@@ -229,9 +263,13 @@ namespace RT64 {
         RenderTexture *getTexture(uint32_t index) override;
         RenderWindow getWindow() const override;
         bool isEmpty() const override;
+        bool isPresentModeSupported(RenderPresentMode presentMode) const override;
+        bool setPresentMode(RenderPresentMode presentMode) override;
+        RenderPresentMode getPresentMode() const override;
         uint32_t getRefreshRate() const override;
         void getWindowSize(uint32_t &dstWidth, uint32_t &dstHeight) const;
-        void checkAcquireNextTextureSemaphore();
+        void flushAcquireNextTextureSemaphore();
+        bool createSemaphores(std::vector<VkSemaphore> &semaphores, uint32_t count);
         bool acquireNextTexture();
         void releaseSwapChain();
         void releaseImageViews();
@@ -278,6 +316,8 @@ namespace RT64 {
         void traceRays(uint32_t width, uint32_t height, uint32_t depth, RenderBufferReference shaderBindingTable, const RenderShaderBindingGroupsInfo &shaderBindingGroupsInfo) override;
         void drawInstanced(uint32_t vertexCountPerInstance, uint32_t instanceCount, uint32_t startVertexLocation, uint32_t startInstanceLocation) override;
         void drawIndexedInstanced(uint32_t indexCountPerInstance, uint32_t instanceCount, uint32_t startIndexLocation, int32_t baseVertexLocation, uint32_t startInstanceLocation) override;
+        void drawInstancedIndirect(RenderBufferReference argumentBuffer, uint32_t drawCount) override;
+        void drawIndexedInstancedIndirect(RenderBufferReference argumentBuffer, uint32_t drawCount) override;
         void setPipeline(const RenderPipeline *pipeline) override;
         void setComputePipelineLayout(const RenderPipelineLayout *pipelineLayout) override;
         void setComputePushConstants(uint32_t rangeIndex, const void *data) override;
@@ -323,12 +363,18 @@ namespace RT64 {
         uint32_t familyIndex = 0;
         uint32_t queueIndex = 0;
         std::unordered_set<VulkanSwapChain *> swapChains;
+        VkSemaphore timelineSemaphore = VK_NULL_HANDLE;
+        std::atomic<uint64_t> timelineValue = 0;
+        std::vector<VkSemaphore> timelineWaitSemaphores;
+        std::vector<uint64_t> timelineWaitValues;
 
         VulkanCommandQueue(VulkanDevice *device, RenderCommandListType commandListType);
         ~VulkanCommandQueue() override;
         std::unique_ptr<RenderSwapChain> createSwapChain(RenderWindow renderWindow, uint32_t bufferCount, RenderFormat format) override;
         void executeCommandLists(const RenderCommandList **commandLists, uint32_t commandListCount, RenderCommandFence *signalFence) override;
         void waitForCommandFence(RenderCommandFence *fence) override;
+        uint64_t getTimelineValue() override;
+        void waitForCommandQueue(RenderCommandQueue *queue, uint64_t value) override;
     };
 
     struct VulkanPool : RenderPool {
@@ -360,6 +406,8 @@ namespace RT64 {
         VkPhysicalDevice physicalDevice = VK_NULL_HANDLE;
         VkPhysicalDeviceProperties physicalDeviceProperties = {};
         VmaAllocator allocator = VK_NULL_HANDLE;
+        VkPipelineCache pipelineCache = VK_NULL_HANDLE;
+        std::unique_ptr<VulkanDescriptorSetAllocator> descriptorSetAllocator;
         uint32_t queueFamilyIndices[3] = {};
         std::vector<VulkanQueueFamily> queueFamilies;
         RenderDeviceCapabilities capabilities;
@@ -389,6 +437,9 @@ namespace RT64 {
         void setShaderBindingTableInfo(RenderShaderBindingTableInfo &tableInfo, const RenderShaderBindingGroups &groups, const RenderPipeline *pipeline, RenderDescriptorSet **descriptorSets, uint32_t descriptorSetCount) override;
         const RenderDeviceCapabilities &getCapabilities() const override;
         RenderSampleCounts getSampleCountsSupported(RenderFormat format) const override;
+        RenderDescriptorSetStats getDescriptorSetStats() const override;
+        bool loadPipelineCache(const void *data, uint64_t size) override;
+        bool savePipelineCache(std::vector<uint8_t> &data) override;
         void release();
         bool isValid() const;
     };
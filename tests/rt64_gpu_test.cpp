@@ -0,0 +1,356 @@
+//
+// RT64
+//
+
+// GPU tests that check behavior the CPU can't verify on its own. They run on the Vulkan backend without a window and are
+// skipped if no device is available, so they can run as part of CI on machines with or without a GPU.
+
+#include <algorithm>
+#include <cstdio>
+#include <functional>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "rhi/rt64_render_interface.h"
+#include "rhi/rt64_render_interface_builders.h"
+
+#include "shaders/FullScreenVS.hlsl.spirv.h"
+#include "shaders/PostBlendDitherNoiseHelperTestBasePS.hlsl.spirv.h"
+#include "shaders/PostBlendDitherNoiseHelperTestAddPS.hlsl.spirv.h"
+#include "shaders/PostBlendDitherNoiseHelperTestSubPS.hlsl.spirv.h"
+#include "shaders/PostBlendDitherNoiseHelperTestInShaderPS.hlsl.spirv.h"
+
+namespace RT64 {
+    extern std::unique_ptr<RenderInterface> CreateVulkanInterface();
+
+    enum class TestResult {
+        Passed,
+        Failed,
+        Skipped
+    };
+
+    // Return code recognized by CTest as a skipped test.
+    static const int SkipReturnCode = 77;
+
+    struct TestContext {
+        std::unique_ptr<RenderInterface> renderInterface;
+        std::unique_ptr<RenderDevice> device;
+
+        bool setup() {
+            renderInterface = CreateVulkanInterface();
+            if (renderInterface == nullptr) {
+                return false;
+            }
+
+            device = renderInterface->createDevice();
+            return (device != nullptr);
+        }
+    };
+
+    struct Test {
+        std::string name;
+        std::function<TestResult(TestContext &)> function;
+    };
+
+    // Textures are decoded on a separate queue and made available as soon as their uploads are submitted. The queues that sample
+    // them only wait for the decoding on the GPU through the queue timelines. This checks that an execution submitted after the
+    // wait never sees the contents written before the upload, even if the upload takes a long time to finish.
+    static TestResult testQueueTimelineOrdering(TestContext &ctx) {
+        RenderDevice *device = ctx.device.get();
+        if (!device->getCapabilities().queueTimelines) {
+            fprintf(stdout, "Queue timelines are not supported by the device.\n");
+            return TestResult::Skipped;
+        }
+
+        // The buffer is big enough for the upload to still be running by the time the read is submitted if the wait is ignored.
+        const uint32_t WordCount = 16 * 1024 * 1024;
+        const uint64_t BufferSize = WordCount * sizeof(uint32_t);
+        const uint32_t IterationCount = 8;
+        std::unique_ptr<RenderCommandQueue> uploadQueue = device->createCommandQueue(RenderCommandListType::COMPUTE);
+        std::unique_ptr<RenderCommandList> uploadList = device->createCommandList(RenderCommandListType::COMPUTE);
+        std::unique_ptr<RenderCommandFence> uploadFence = device->createCommandFence();
+        std::unique_ptr<RenderCommandQueue> readQueue = device->createCommandQueue(RenderCommandListType::DIRECT);
+        std::unique_ptr<RenderCommandList> readList = device->createCommandList(RenderCommandListType::DIRECT);
+        std::unique_ptr<RenderCommandFence> readFence = device->createCommandFence();
+        std::unique_ptr<RenderBuffer> uploadBuffer = device->createBuffer(RenderBufferDesc::UploadBuffer(BufferSize));
+        std::unique_ptr<RenderBuffer> decodedBuffer = device->createBuffer(RenderBufferDesc::DefaultBuffer(BufferSize));
+        std::unique_ptr<RenderBuffer> readbackBuffer = device->createBuffer(RenderBufferDesc::ReadbackBuffer(BufferSize));
+        for (uint32_t i = 0; i < IterationCount; i++) {
+            // Every iteration uses a different pattern, so reading the contents of the previous upload is detected as well.
+            const uint32_t pattern = 0x52543634U + i;
+            uint32_t *uploadWords = reinterpret_cast<uint32_t *>(uploadBuffer->map());
+            std::fill(uploadWords, uploadWords + WordCount, pattern);
+            uploadBuffer->unmap();
+
+            uploadList->begin();
+            uploadList->barriers(RenderBarrierStage::COPY, RenderBufferBarrier(decodedBuffer.get(), RenderBufferAccess::WRITE));
+            uploadList->copyBufferRegion(decodedBuffer->at(0), uploadBuffer->at(0), BufferSize);
+            uploadList->end();
+            uploadQueue->executeCommandLists(uploadList.get(), uploadFence.get());
+
+            // Same as TextureCache::queueWaitForGPUUploads. The CPU doesn't wait for the upload before submitting the read.
+            readQueue->waitForCommandQueue(uploadQueue.get(), uploadQueue->getTimelineValue());
+            readList->begin();
+            readList->barriers(RenderBarrierStage::COPY, RenderBufferBarrier(decodedBuffer.get(), RenderBufferAccess::READ));
+            readList->copyBufferRegion(readbackBuffer->at(0), decodedBuffer->at(0), BufferSize);
+            readList->end();
+            readQueue->executeCommandLists(readList.get(), readFence.get());
+            readQueue->waitForCommandFence(readFence.get());
+            uploadQueue->waitForCommandFence(uploadFence.get());
+
+            uint32_t mismatchCount = 0;
+            uint32_t firstMismatch = UINT32_MAX;
+            uint32_t firstMismatchWord = 0;
+            const uint32_t *readbackWords = reinterpret_cast<const uint32_t *>(readbackBuffer->map());
+            for (uint32_t w = 0; w < WordCount; w++) {
+                if (readbackWords[w] != pattern) {
+                    if (mismatchCount == 0) {
+                        firstMismatch = w;
+                        firstMismatchWord = readbackWords[w];
+                    }
+
+                    mismatchCount++;
+                }
+            }
+
+            readbackBuffer->unmap();
+
+            if (mismatchCount > 0) {
+                fprintf(stderr, "Iteration %u read %u words that were not uploaded yet. First mismatch at word %u: 0x%08X instead of 0x%08X.\n",
+                    i, mismatchCount, firstMismatch, firstMismatchWord, pattern);
+                return TestResult::Failed;
+            }
+        }
+
+        return TestResult::Passed;
+    }
+
+    // Must match the push constants declared by PostBlendDitherNoiseHelperTestPS.
+    struct PostBlendDitherNoiseHelperTestCB {
+        uint32_t frameCount;
+        float ditherNoiseStrength;
+        uint32_t renderIndex;
+        uint32_t usesHDR;
+    };
+
+    // Calls that overwrite the destination add the post blend dither noise in the pixel shader instead of drawing it in two extra
+    // passes. This renders the same dithered rect with the separate passes and with the ApplyPostBlendDitherNoise helper used by
+    // RasterPS on the formats used by the render targets and compares the captures. When RasterPS applies the helper is not tested.
+    static TestResult testPostBlendDitherNoiseHelper(TestContext &ctx) {
+        struct TargetFormat {
+            RenderFormat format;
+            bool usesHDR;
+            uint32_t channelBytes;
+            const char *name;
+        };
+
+        const TargetFormat TargetFormats[] = {
+            { RenderFormat::R8G8B8A8_UNORM, false, 1, "R8G8B8A8_UNORM" },
+            { RenderFormat::R16G16B16A16_UNORM, true, 2, "R16G16B16A16_UNORM" }
+        };
+
+        // The old passes round the color again when blending, and the precision of the blending is up to the implementation. Both
+        // captures are allowed to differ by a single step of the target, but only on a few channels: adding the noise before the
+        // color is quantized makes about a quarter of them differ instead.
+        const uint32_t Width = 256;
+        const uint32_t Height = 256;
+        const uint32_t ChannelCount = Width * Height * 4;
+        const uint32_t MaxChannelsOffByOne = ChannelCount / 100;
+        RenderDevice *device = ctx.device.get();
+        RenderPipelineLayoutBuilder layoutBuilder;
+        layoutBuilder.begin();
+        layoutBuilder.addPushConstant(0, 0, sizeof(PostBlendDitherNoiseHelperTestCB), RenderShaderStageFlag::PIXEL);
+        layoutBuilder.end();
+
+        const RenderShaderFormat shaderFormat = RenderShaderFormat::SPIRV;
+        std::unique_ptr<RenderPipelineLayout> pipelineLayout = layoutBuilder.create(device);
+        std::unique_ptr<RenderShader> vertexShader = device->createShader(FullScreenVSBlobSPIRV, sizeof(FullScreenVSBlobSPIRV), "VSMain", shaderFormat);
+        std::unique_ptr<RenderShader> basePixelShader = device->createShader(PostBlendDitherNoiseHelperTestBasePSBlobSPIRV, sizeof(PostBlendDitherNoiseHelperTestBasePSBlobSPIRV), "PSMain", shaderFormat);
+        std::unique_ptr<RenderShader> addPixelShader = device->createShader(PostBlendDitherNoiseHelperTestAddPSBlobSPIRV, sizeof(PostBlendDitherNoiseHelperTestAddPSBlobSPIRV), "PSMain", shaderFormat);
+        std::unique_ptr<RenderShader> subPixelShader = device->createShader(PostBlendDitherNoiseHelperTestSubPSBlobSPIRV, sizeof(PostBlendDitherNoiseHelperTestSubPSBlobSPIRV), "PSMain", shaderFormat);
+        std::unique_ptr<RenderShader> inShaderPixelShader = device->createShader(PostBlendDitherNoiseHelperTestInShaderPSBlobSPIRV, sizeof(PostBlendDitherNoiseHelperTestInShaderPSBlobSPIRV), "PSMain", shaderFormat);
+        std::unique_ptr<RenderCommandQueue> commandQueue = device->createCommandQueue(RenderCommandListType::DIRECT);
+        std::unique_ptr<RenderCommandList> commandList = device->createCommandList(RenderCommandListType::DIRECT);
+        std::unique_ptr<RenderCommandFence> commandFence = device->createCommandFence();
+        for (const TargetFormat &target : TargetFormats) {
+            // Same pipelines as the raster shader and the post blend pipelines of the framebuffer renderer.
+            RenderGraphicsPipelineDesc pipelineDesc;
+            pipelineDesc.pipelineLayout = pipelineLayout.get();
+            pipelineDesc.vertexShader = vertexShader.get();
+            pipelineDesc.renderTargetFormat[0] = target.format;
+            pipelineDesc.renderTargetBlend[0] = RenderBlendDesc::Copy();
+            pipelineDesc.renderTargetCount = 1;
+            pipelineDesc.pixelShader = basePixelShader.get();
+            std::unique_ptr<RenderPipeline> basePipeline = device->createGraphicsPipeline(pipelineDesc);
+            pipelineDesc.pixelShader = inShaderPixelShader.get();
+            std::unique_ptr<RenderPipeline> inShaderPipeline = device->createGraphicsPipeline(pipelineDesc);
+
+            RenderBlendDesc &targetBlend = pipelineDesc.renderTargetBlend[0];
+            targetBlend.blendEnabled = true;
+            targetBlend.srcBlend = RenderBlend::ONE;
+            targetBlend.dstBlend = RenderBlend::ONE;
+            targetBlend.blendOp = RenderBlendOperation::ADD;
+            targetBlend.srcBlendAlpha = RenderBlend::ZERO;
+            targetBlend.dstBlendAlpha = RenderBlend::ONE;
+            targetBlend.blendOpAlpha = RenderBlendOperation::ADD;
+            pipelineDesc.pixelShader = addPixelShader.get();
+            std::unique_ptr<RenderPipeline> addPipeline = device->createGraphicsPipeline(pipelineDesc);
+            targetBlend.blendOp = RenderBlendOperation::REV_SUBTRACT;
+            pipelineDesc.pixelShader = subPixelShader.get();
+            std::unique_ptr<RenderPipeline> subPipeline = device->createGraphicsPipeline(pipelineDesc);
+
+            std::unique_ptr<RenderTexture> passesTexture = device->createTexture(RenderTextureDesc::ColorTarget(Width, Height, target.format));
+            std::unique_ptr<RenderTexture> inShaderTexture = device->createTexture(RenderTextureDesc::ColorTarget(Width, Height, target.format));
+            const RenderTexture *passesAttachment = passesTexture.get();
+            const RenderTexture *inShaderAttachment = inShaderTexture.get();
+            std::unique_ptr<RenderFramebuffer> passesFramebuffer = device->createFramebuffer(RenderFramebufferDesc(&passesAttachment, 1));
+            std::unique_ptr<RenderFramebuffer> inShaderFramebuffer = device->createFramebuffer(RenderFramebufferDesc(&inShaderAttachment, 1));
+            const uint64_t CaptureSize = uint64_t(ChannelCount) * target.channelBytes;
+            std::unique_ptr<RenderBuffer> readbackBuffer = device->createBuffer(RenderBufferDesc::ReadbackBuffer(CaptureSize * 2));
+
+            PostBlendDitherNoiseHelperTestCB testCB;
+            testCB.frameCount = 60;
+            testCB.ditherNoiseStrength = 1.0f;
+            testCB.renderIndex = 1;
+            testCB.usesHDR = target.usesHDR ? 1 : 0;
+
+            auto drawRect = [&](const RenderPipeline *pipeline) {
+                commandList->setPipeline(pipeline);
+                commandList->setGraphicsPipelineLayout(pipelineLayout.get());
+                commandList->setGraphicsPushConstants(0, &testCB);
+                commandList->drawInstanced(3, 1, 0, 0);
+            };
+
+            commandList->begin();
+            commandList->setViewports(RenderViewport(0.0f, 0.0f, float(Width), float(Height)));
+            commandList->setScissors(RenderRect(0, 0, Width, Height));
+            commandList->barriers(RenderBarrierStage::GRAPHICS, { RenderTextureBarrier(passesTexture.get(), RenderTextureLayout::COLOR_WRITE), RenderTextureBarrier(inShaderTexture.get(), RenderTextureLayout::COLOR_WRITE) });
+            commandList->setFramebuffer(passesFramebuffer.get());
+            drawRect(basePipeline.get());
+            drawRect(addPipeline.get());
+            drawRect(subPipeline.get());
+            commandList->setFramebuffer(inShaderFramebuffer.get());
+            drawRect(inShaderPipeline.get());
+            commandList->barriers(RenderBarrierStage::COPY, { RenderTextureBarrier(passesTexture.get(), RenderTextureLayout::COPY_SOURCE), RenderTextureBarrier(inShaderTexture.get(), RenderTextureLayout::COPY_SOURCE) });
+            commandList->copyTextureRegion(RenderTextureCopyLocation::PlacedFootprint(readbackBuffer.get(), target.format, Width, Height, 1, Width, 0), RenderTextureCopyLocation::Subresource(passesTexture.get()));
+            commandList->copyTextureRegion(RenderTextureCopyLocation::PlacedFootprint(readbackBuffer.get(), target.format, Width, Height, 1, Width, CaptureSize), RenderTextureCopyLocation::Subresource(inShaderTexture.get()));
+            commandList->end();
+            commandQueue->executeCommandLists(commandList.get(), commandFence.get());
+            commandQueue->waitForCommandFence(commandFence.get());
+
+            uint32_t offByOneCount = 0;
+            uint32_t maxDifference = 0;
+            uint32_t maxDifferenceChannel = 0;
+            const uint8_t *captureBytes = reinterpret_cast<const uint8_t *>(readbackBuffer->map());
+            for (uint32_t c = 0; c < ChannelCount; c++) {
+                uint32_t passesValue, inShaderValue;
+                if (target.channelBytes == 2) {
+                    passesValue = reinterpret_cast<const uint16_t *>(captureBytes)[c];
+                    inShaderValue = reinterpret_cast<const uint16_t *>(captureBytes + CaptureSize)[c];
+                }
+                else {
+                    passesValue = captureBytes[c];
+                    inShaderValue = captureBytes[CaptureSize + c];
+                }
+
+                const uint32_t difference = (passesValue > inShaderValue) ? (passesValue - inShaderValue) : (inShaderValue - passesValue);
+                if (difference > maxDifference) {
+                    maxDifference = difference;
+                    maxDifferenceChannel = c;
+                }
+
+                if (difference == 1) {
+                    offByOneCount++;
+                }
+            }
+
+            readbackBuffer->unmap();
+
+            if (maxDifference > 1) {
+                const uint32_t pixelIndex = maxDifferenceChannel / 4;
+                fprintf(stderr, "%s: channel %u of pixel (%u, %u) differs by %u steps between the passes and the pixel shader.\n",
+                    target.name, maxDifferenceChannel % 4, pixelIndex % Width, pixelIndex / Width, maxDifference);
+                return TestResult::Failed;
+            }
+
+            if (offByOneCount > MaxChannelsOffByOne) {
+                fprintf(stderr, "%s: %u of %u channels differ by one step between the passes and the pixel shader.\n",
+                    target.name, offByOneCount, ChannelCount);
+                return TestResult::Failed;
+            }
+        }
+
+        return TestResult::Passed;
+    }
+
+    static const std::vector<Test> &getTests() {
+        static const std::vector<Test> tests = {
+            { "queue_timeline_ordering", testQueueTimelineOrdering },
+            { "post_blend_dither_noise_helper", testPostBlendDitherNoiseHelper },
+        };
+
+        return tests;
+    }
+};
+
+static void printUsage(const char *program) {
+    fprintf(stderr, "Usage: %s [test name]\n", program);
+    fprintf(stderr, "Available tests:\n");
+    for (const RT64::Test &test : RT64::getTests()) {
+        fprintf(stderr, "  %s\n", test.name.c_str());
+    }
+}
+
+int main(int argc, char **argv) {
+    if (argc > 2) {
+        printUsage(argv[0]);
+        return 1;
+    }
+
+    const std::string filter = (argc > 1) ? argv[1] : std::string();
+    bool testFound = false;
+    for (const RT64::Test &test : RT64::getTests()) {
+        testFound = testFound || filter.empty() || (test.name == filter);
+    }
+
+    if (!testFound) {
+        printUsage(argv[0]);
+        return 1;
+    }
+
+    RT64::TestContext ctx;
+    if (!ctx.setup()) {
+        fprintf(stdout, "No Vulkan device is available. Skipping all tests.\n");
+        return RT64::SkipReturnCode;
+    }
+
+    uint32_t failedCount = 0;
+    uint32_t skippedCount = 0;
+    uint32_t runCount = 0;
+    for (const RT64::Test &test : RT64::getTests()) {
+        if (!filter.empty() && (test.name != filter)) {
+            continue;
+        }
+
+        const RT64::TestResult result = test.function(ctx);
+        const char *resultName = "PASSED";
+        if (result == RT64::TestResult::Failed) {
+            resultName = "FAILED";
+            failedCount++;
+        }
+        else if (result == RT64::TestResult::Skipped) {
+            resultName = "SKIPPED";
+            skippedCount++;
+        }
+
+        fprintf(stdout, "[%s] %s\n", resultName, test.name.c_str());
+        runCount++;
+    }
+
+    if (failedCount > 0) {
+        return 1;
+    }
+
+    return (skippedCount == runCount) ? RT64::SkipReturnCode : 0;
+}
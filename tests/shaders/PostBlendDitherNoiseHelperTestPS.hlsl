@@ -0,0 +1,39 @@
+//
+// RT64
+//
+
+// Only declares the parameters used by the noise instead of the full set of bindings used by the renderer.
+struct PostBlendDitherNoiseHelperTestCB {
+    uint frameCount;
+    float ditherNoiseStrength;
+    uint renderIndex;
+    uint usesHDR;
+};
+
+[[vk::push_constant]] ConstantBuffer<PostBlendDitherNoiseHelperTestCB> FrParams : register(b0);
+
+#include "shaders/PostBlendDitherNoise.hlsli"
+
+// Gradient that covers the whole range of the target and doesn't fall on its quantization steps.
+float4 BaseColor(float2 vertexPosition) {
+    const float2 gradient = vertexPosition / 256.0f;
+    return float4(gradient.x, gradient.y, 1.0f - gradient.x * gradient.y, 0.5f);
+}
+
+float4 PSMain(in float4 vertexPosition : SV_Position) : SV_TARGET {
+    float4 resultColor = BaseColor(vertexPosition.xy);
+#if defined(ADD_MODE) || defined(SUB_MODE)
+    // Same output as PostBlendDitherNoisePS.
+    resultColor.rgb = PostBlendDitherNoise(vertexPosition.xy, FrParams.renderIndex);
+    resultColor.a = 0.0f;
+#   if defined(ADD_MODE)
+    resultColor = max(resultColor, 0.0f);
+#   else
+    resultColor = max(-resultColor, 0.0f);
+#   endif
+#elif defined(IN_SHADER_MODE)
+    // Same helper RasterPS applies the noise with. The conditions RasterPS applies it under are not covered.
+    resultColor.rgb = ApplyPostBlendDitherNoise(resultColor.rgb, vertexPosition.xy, FrParams.renderIndex, FrParams.usesHDR != 0);
+#endif
+    return resultColor;
+}